@@ -0,0 +1,172 @@
+/**
+ * @file parse_bench.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include "metadata/http/jsonSelect.hpp"
+#include "metadata/sources/lastfm.hpp"
+#include "metadata/sources/scraper.hpp"
+#include "support/allocations.hpp"
+#include "support/fixtures.hpp"
+
+namespace {
+TrackIdentity searched() {
+    TrackIdentity track;
+    track.title = "Bohemian Rhapsody";
+    track.artist = "Queen";
+    track.album = "A Night at the Opera";
+    return track;
+}
+
+/**
+ * A recorded response and what parsing it must give, so a benchmark never times a parse that
+ * has quietly stopped finding anything.
+ */
+struct Fixture {
+    std::string name;
+    /// The track is matched.
+    bool found;
+    /// The parse reports a failure.
+    bool failed;
+};
+
+void report(const std::string &name, const std::string &body, const AllocationStats &stats) {
+    std::cout << std::format("{:<44} {:>8} KiB in, {:>6} allocations, {:>8} KiB asked for, "
+                             "{:>8} KiB peak\n",
+                             name, body.size() / 1024, stats.count, stats.bytes / 1024,
+                             stats.peak / 1024);
+}
+
+/// The malformed fixtures warn on every parse; the timings are what is wanted here.
+void quiet() {
+    spdlog::set_level(spdlog::level::off);
+}
+
+bool found(const SearchResult &result) {
+    return !result.web_url.empty();
+}
+} // namespace
+
+TEST_CASE("Apple Music search page parsing", "[!benchmark][scraper]") {
+    quiet();
+    const auto track = searched();
+    const std::vector<Fixture> fixtures{
+        {"applemusic/search_typical.html", true, false},
+        {"applemusic/search_large.html", true, false},
+        {"applemusic/search_empty.html", false, false},
+        // Cut off mid-payload: what arrived before the cut is still read.
+        {"applemusic/search_malformed.html", true, false},
+        {"applemusic/search_markup_only.html", true, false},
+    };
+
+    for (const auto &fixture : fixtures) {
+        const std::string page = readFixture(fixture.name);
+        for (const auto mode : {ScraperMode::Payload, ScraperMode::Markup}) {
+            const std::string name =
+                fixture.name + (mode == ScraperMode::Payload ? ", payload" : ", markup");
+            SearchHarvest harvest;
+            const auto stats = countAllocations([&] {
+                harvest = Scraper::parse(page, track, mode);
+            });
+            CHECK(found(harvest.result) == fixture.found);
+            CHECK(harvest.result.failed == fixture.failed);
+            report(name, page, stats);
+
+            BENCHMARK(std::string{name}) {
+                return Scraper::parse(page, track, mode);
+            };
+        }
+    }
+}
+
+TEST_CASE("Apple Music payload extraction", "[!benchmark][scraper]") {
+    quiet();
+    const std::string page = readFixture("applemusic/search_large.html");
+    const auto stats = countAllocations([&] {
+        CHECK(Scraper::payloadSongs(page).size() > 100);
+    });
+    report("applemusic/search_large.html, songs only", page, stats);
+
+    BENCHMARK("applemusic/search_large.html, songs only") {
+        return Scraper::payloadSongs(page);
+    };
+}
+
+TEST_CASE("Last.fm track.search parsing", "[!benchmark][lastfm]") {
+    quiet();
+    const auto track = searched();
+    const std::vector<Fixture> fixtures{
+        {"lastfm/track_search_typical.json", true, false},
+        {"lastfm/track_search_large.json", true, false},
+        {"lastfm/track_search_empty.json", false, false},
+        {"lastfm/track_search_malformed.json", false, true},
+        // An API error, such as a revoked key, is a failure rather than a miss.
+        {"lastfm/track_search_error.json", false, true},
+    };
+
+    for (const auto &fixture : fixtures) {
+        const std::string body = readFixture(fixture.name);
+        SearchResult result;
+        const auto stats = countAllocations([&] {
+            result = LastFm::parseSearch(body, track);
+        });
+        CHECK(found(result) == fixture.found);
+        CHECK(result.failed == fixture.failed);
+        report(fixture.name, body, stats);
+
+        BENCHMARK(std::string{fixture.name}) {
+            return LastFm::parseSearch(body, track);
+        };
+    }
+}
+
+TEST_CASE("Last.fm track.search, selected against a full parse", "[!benchmark][lastfm]") {
+    quiet();
+    // The fields parseSearch reads, read both ways.
+    const json_select::Selector selector{
+        "/results/trackmatches/track/*/name", "/results/trackmatches/track/*/artist",
+        "/results/trackmatches/track/*/url"
+    };
+    const auto selected = [&](const std::string &body) {
+        std::size_t found = 0;
+        json_select::select(body, selector, [&](const json_select::Match &) { ++found; });
+        return found;
+    };
+    const auto documented = [](const std::string &body) {
+        std::size_t found = 0;
+        const auto json = nlohmann::json::parse(body);
+        for (const auto &track : json["results"]["trackmatches"]["track"]) {
+            found += track.contains("name") + track.contains("artist") + track.contains("url");
+        }
+        return found;
+    };
+
+    for (const std::string name : {"lastfm/track_search_typical.json",
+                                   "lastfm/track_search_large.json"}) {
+        const std::string body = readFixture(name);
+        std::size_t bySelection = 0;
+        std::size_t byDocument = 0;
+        const auto selecting = countAllocations([&] { bySelection = selected(body); });
+        const auto parsing = countAllocations([&] { byDocument = documented(body); });
+        report(name + ", selected", body, selecting);
+        report(name + ", full parse", body, parsing);
+        CHECK(bySelection == byDocument);
+        CHECK(bySelection > 0);
+
+        BENCHMARK(name + ", selected") {
+            return selected(body);
+        };
+        BENCHMARK(name + ", full parse") {
+            return documented(body);
+        };
+    }
+}
@@ -0,0 +1,128 @@
+/**
+ * @file allocations.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "support/allocations.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <libxml/xmlmemory.h>
+
+namespace {
+/**
+ * Put in front of every block handed out, so a free knows how much it gives back. Sized to keep
+ * the block behind it aligned as malloc's are.
+ */
+struct alignas(std::max_align_t) Header {
+    std::size_t size;
+};
+
+std::atomic<bool> counting{false};
+std::atomic<std::size_t> count{0};
+std::atomic<std::size_t> bytes{0};
+std::atomic<std::size_t> live{0};
+std::atomic<std::size_t> peak{0};
+std::size_t baseline = 0;
+
+void note(const std::size_t size) {
+    const auto now = live.fetch_add(size, std::memory_order_relaxed) + size;
+    if (!counting.load(std::memory_order_relaxed))
+        return;
+    count.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+    auto high = peak.load(std::memory_order_relaxed);
+    while (now > high && !peak.compare_exchange_weak(high, now, std::memory_order_relaxed)) {
+    }
+}
+
+void *take(const std::size_t size) {
+    auto *header = static_cast<Header *>(std::malloc(sizeof(Header) + size));
+    if (!header)
+        return nullptr;
+    header->size = size;
+    note(size);
+    return header + 1;
+}
+
+void give(void *block) {
+    if (!block)
+        return;
+    auto *header = static_cast<Header *>(block) - 1;
+    live.fetch_sub(header->size, std::memory_order_relaxed);
+    std::free(header);
+}
+
+void *retake(void *block, const std::size_t size) {
+    if (!block)
+        return take(size);
+    auto *header = static_cast<Header *>(block) - 1;
+    const auto old = header->size;
+    header = static_cast<Header *>(std::realloc(header, sizeof(Header) + size));
+    if (!header)
+        return nullptr;
+    header->size = size;
+    live.fetch_sub(old, std::memory_order_relaxed);
+    note(size);
+    return header + 1;
+}
+
+void *xmlTake(const std::size_t size) { return take(size); }
+void xmlGive(void *block) { give(block); }
+void *xmlRetake(void *block, const std::size_t size) { return retake(block, size); }
+
+char *xmlCopy(const char *text) {
+    const auto size = std::strlen(text) + 1;
+    auto *copy = static_cast<char *>(take(size));
+    if (copy) {
+        std::memcpy(copy, text, size);
+    }
+    return copy;
+}
+
+// libxml2 allocates with malloc unless told otherwise; point it here before it first runs, so
+// every block it frees is one of ours.
+[[maybe_unused]] const bool hooked = xmlMemSetup(xmlGive, xmlTake, xmlRetake, xmlCopy) == 0;
+} // namespace
+
+void allocations::start() {
+    count = 0;
+    bytes = 0;
+    baseline = live.load();
+    peak = baseline;
+    counting = true;
+}
+
+AllocationStats allocations::stop() {
+    counting = false;
+    return AllocationStats{.count = count.load(), .bytes = bytes.load(),
+                           .peak = peak.load() - baseline};
+}
+
+void *operator new(const std::size_t size) {
+    if (void *block = take(size == 0 ? 1 : size))
+        return block;
+    throw std::bad_alloc{};
+}
+
+void *operator new[](const std::size_t size) {
+    return ::operator new(size);
+}
+
+void *operator new(const std::size_t size, const std::nothrow_t &) noexcept {
+    return take(size == 0 ? 1 : size);
+}
+
+void *operator new[](const std::size_t size, const std::nothrow_t &) noexcept {
+    return take(size == 0 ? 1 : size);
+}
+
+void operator delete(void *block) noexcept { give(block); }
+void operator delete[](void *block) noexcept { give(block); }
+void operator delete(void *block, std::size_t) noexcept { give(block); }
+void operator delete[](void *block, std::size_t) noexcept { give(block); }
+void operator delete(void *block, const std::nothrow_t &) noexcept { give(block); }
+void operator delete[](void *block, const std::nothrow_t &) noexcept { give(block); }
@@ -0,0 +1,40 @@
+/**
+ * @file allocations.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+/**
+ * What the heap saw while some code ran: operator new and libxml2's allocator both count.
+ */
+struct AllocationStats {
+    /// Allocations made, reallocations included.
+    std::size_t count = 0;
+    /// Bytes asked for across them.
+    std::size_t bytes = 0;
+    /// Most bytes held at once above what was held going in.
+    std::size_t peak = 0;
+};
+
+namespace allocations {
+/// Starts counting, from the bytes held now.
+void start();
+
+/// Stops counting.
+AllocationStats stop();
+} // namespace allocations
+
+/**
+ * Runs f once, counting what it allocates. Not reentrant, and only meaningful on one thread.
+ */
+template<class F>
+AllocationStats countAllocations(F &&f) {
+    allocations::start();
+    std::forward<F>(f)();
+    return allocations::stop();
+}
@@ -0,0 +1,30 @@
+/**
+ * @file fixtures.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#ifndef MUSICPP_FIXTURES_DIR
+#define MUSICPP_FIXTURES_DIR "benchmarks/fixtures"
+#endif
+
+/**
+ * Reads a recorded response from the fixtures directory.
+ * @param name Path under the fixtures directory, e.g. "lastfm/track_search_typical.json".
+ * @throws std::runtime_error if the fixture cannot be read.
+ */
+inline std::string readFixture(const std::string &name) {
+    const auto path = std::filesystem::path(MUSICPP_FIXTURES_DIR) / name;
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("Missing fixture " + path.string());
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
@@ -10,11 +10,16 @@
 
 #include "discord/presence.hpp"
 #include "discordpp.h"
+#include "metadata/sources/artwork.hpp"
 #include "types/track.hpp"
 
 class RichPresence final : public Presence {
 public:
-    explicit RichPresence(const uint64_t &apikey);
+    /**
+     * @param apikey Discord application id.
+     * @param artwork Rendition Apple artwork is shown at, whatever size it was cached at.
+     */
+    explicit RichPresence(const uint64_t &apikey, const ArtworkSize &artwork = {});
 
     ~RichPresence() override;
 
@@ -31,5 +36,6 @@ public:
     void clearPresence() const override;
 
 private:
+    ArtworkSize _artwork;
     std::shared_ptr<discordpp::Client> _client = std::make_shared<discordpp::Client>();
 };
\ No newline at end of file
@@ -16,9 +16,10 @@
 #include <vector>
 #include "system/paths.hpp"
 
-constexpr std::array<const char *, 12> kLoggerNames = {
+constexpr std::array<const char *, 14> kLoggerNames = {
     "amwin", "enricher", "lastfm", "scraper", "imgur", "discord",
-    "cache", "orchestrator", "scrobbler", "tray", "main", "notifications"
+    "cache", "orchestrator", "scrobbler", "tray", "main", "notifications",
+    "backfill", "http"
 };
 
 /**
@@ -7,9 +7,21 @@
 #pragma once
 #include <optional>
 #include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
 #include <leveldb/db.h>
 #include "types/track.hpp"
 
+/**
+ * A cached image a closer match could replace: a fallback, or a loose match.
+ */
+struct UpgradeCandidate {
+    Track track;
+    ImageUrl image;
+};
+
 class MetadataCache {
 public:
     explicit MetadataCache();
@@ -32,6 +44,15 @@ public:
      */
     void writeEntry(const EnrichedTrack &track) const;
 
+    /**
+     * Writes many entries in one batch, but only where the cache has nothing of its own: an image
+     * only over a missing or expired one, and a link only for a platform the track has none from.
+     * For what was never asked for, such as the other songs a search turned up.
+     * @param tracks Enriched tracks to fill the gaps with.
+     * @return How many tracks had something written.
+     */
+    std::size_t writeHarvest(std::span<const EnrichedTrack> tracks) const;
+
     /**
      * Attempts to find a given track within the database cache.
      * @param track A base track to find an url for.
@@ -39,6 +60,39 @@ public:
      */
     [[nodiscard]] std::optional<EnrichedTrack> findEntry(const Track &track) const;
 
+    /**
+     * Looks up many tracks at once against a single consistent view of the database. The keys are
+     * resolved in sorted order by one forward iterator, so a batch costs one pass over the tables
+     * rather than two independent lookups per track.
+     * @param tracks Base tracks to find urls for.
+     * @return One entry per track, in input order, each as findEntry() would have returned it.
+     */
+    [[nodiscard]] std::vector<std::optional<EnrichedTrack> > findEntries(
+        std::span<const Track> tracks) const;
+
+    /**
+     * Walks the fresh image rows in key order for those below a full match.
+     * @param after trackKey() of the track to carry on after; empty to start from the first row.
+     * @param limit Most candidates to return.
+     * @return Up to limit candidates, in key order. Fewer means the walk reached the last row.
+     */
+    [[nodiscard]] std::vector<UpgradeCandidate> findUpgradeable(std::string_view after,
+                                                                std::size_t limit) const;
+
+    /**
+     * Reads a side-table state row, kept apart from the track rows and never expired.
+     * @param name Name the state was written under.
+     * @return The stored value, or nullopt if nothing was written under the name.
+     */
+    [[nodiscard]] std::optional<std::string> readState(std::string_view name) const;
+
+    /**
+     * Writes a side-table state row, replacing whatever was kept under the name.
+     * @param name Name to keep the state under.
+     * @param value Opaque value; its owner decides the layout.
+     */
+    void writeState(std::string_view name, std::string_view value) const;
+
 private:
     void open(const std::filesystem::path &dbPath);
 
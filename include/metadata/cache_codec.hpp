@@ -5,9 +5,11 @@
  */
 
 #pragma once
+#include <array>
 #include <chrono>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include "types/track.hpp"
 
@@ -21,6 +23,35 @@ namespace cache_codec {
  */
 inline constexpr std::chrono::days kImageTtl{14};
 
+/// The Imgur uploader's identify(), the source of every thumbnail it rehosted.
+inline constexpr std::string_view kImgurSource{"Imgur Image Host"};
+
+/**
+ * Source names a url value stores as a small id rather than spelled out. An entry's id is its
+ * index plus one, with 0 reserved for a name written in full. Ids are on disk: append new names to
+ * the end, and never reorder or remove one.
+ */
+inline constexpr std::array<std::string_view, 3> kInternedSources = {
+    "Apple Music Web Scraper",
+    "LastFm API",
+    kImgurSource,
+};
+
+/**
+ * Url prefixes a url value stores as a small id, leaving only the remainder spelled out. Ids work
+ * as for kInternedSources, and the longest matching prefix is the one used.
+ */
+inline constexpr std::array<std::string_view, 8> kUrlPrefixes = {
+    "https://music.apple.com/",
+    "https://music.apple.com/ca/song/",
+    "https://music.apple.com/ca/album/",
+    "https://music.apple.com/us/song/",
+    "https://music.apple.com/us/album/",
+    "https://www.last.fm/music/",
+    "https://www.last.fm/",
+    "https://i.imgur.com/",
+};
+
 /**
  * A cached image together with the wall-clock instant it was written.
  */
@@ -29,6 +60,22 @@ struct CachedImage {
     std::chrono::sys_seconds written_at;
 };
 
+/**
+ * Appends a 64-bit integer as its eight bytes, in the machine's (little-endian) byte order.
+ * @param buf Value being encoded.
+ * @param value Integer to append.
+ */
+void putI64(std::string &buf, int64_t value);
+
+/**
+ * Reads an integer appended by putI64().
+ * @param buf Value being decoded.
+ * @param offset Where the integer starts; moved past it once read.
+ * @param out Set to the integer.
+ * @return Whether eight bytes were left to read.
+ */
+[[nodiscard]] bool readI64(std::string_view buf, size_t &offset, int64_t &out);
+
 /**
  * The current wall-clock time, truncated to seconds.
  */
@@ -40,6 +87,22 @@ struct CachedImage {
  */
 [[nodiscard]] bool isFresh(std::chrono::sys_seconds written_at, std::chrono::sys_seconds now);
 
+/**
+ * Derives the canonical, unprefixed key of a track's identity: the part the image and song-URL
+ * keys share.
+ * @param track Track's information.
+ * @return Key for the track's identity.
+ */
+[[nodiscard]] std::string trackKey(const Track &track);
+
+/**
+ * Recovers the identity a trackKey() was derived from. A pipe replaced when the key was made comes
+ * back as the dash it was replaced by, which derives the same key.
+ * @param key Unprefixed key, as trackKey() returns.
+ * @return The identity, or nullopt if the key is malformed.
+ */
+[[nodiscard]] std::optional<TrackIdentity> parseTrackKey(std::string_view key);
+
 /**
  * Derives the image storage key for a track.
  * @param track Track's information.
@@ -54,28 +117,42 @@ struct CachedImage {
  */
 [[nodiscard]] std::string urlKey(const Track &track);
 
+/**
+ * Derives the storage key for a named side-table state row. State rows sort apart from the image
+ * rows, so the expiry sweep never touches them.
+ * @param name Name the state is kept under.
+ * @return Prefixed database key for the state.
+ */
+[[nodiscard]] std::string stateKey(std::string_view name);
+
 /**
  * Serializes a track's image into the image value format:
- * [written_at: i64][type: 1 byte][source_len: u32][source][url: remainder].
+ * [written_at: i64][type | 0x80: 1 byte][quality: 1 byte][confidence: 1 byte][source_len: u32]
+ * [source][url: remainder]. The high bit of the type byte marks the quality and confidence bytes.
  */
 [[nodiscard]] std::string createImageValue(const ImageUrl &image,
                                            std::chrono::sys_seconds written_at);
 
 /**
- * Parses an image value back into an image and the instant it was written.
+ * Parses an image value back into an image and the instant it was written. Also reads the layout
+ * written before images were graded, without the quality and confidence bytes: such an image
+ * reads as a full-confidence match, unless it came from the Imgur host, which only ever held
+ * fallbacks.
  * @return The cached image, or nullopt if the buffer is empty or malformed.
  */
 [[nodiscard]] std::optional<CachedImage> parseImageValue(const std::string &raw);
 
 /**
- * Serializes a song-URL list into the url value format:
- * [count: u32]{ [source_len: u32][source][url_len: u32][url] }*.
+ * Serializes a song-URL list into the url value format, with every integer a LEB128 varint:
+ * [0xFF][version: 2][count]{ [source_id]([source_len][source])? [prefix_id][rest_len][rest] }*.
+ * A source_id of 0 is followed by the name in full; a prefix_id of 0 means the whole url is rest.
  */
 [[nodiscard]] std::string createUrlValue(const std::vector<SongUrl> &urls);
 
 /**
  * Parses a url value back into a list of SongUrls. Stops cleanly at the first malformed
- * entry rather than throwing.
+ * entry rather than throwing. Also reads the unversioned layout written before names and
+ * prefixes were interned: [count: u32]{ [source_len: u32][source][url_len: u32][url] }*.
  */
 [[nodiscard]] std::vector<SongUrl> parseUrlValue(const std::string &raw);
 
@@ -5,25 +5,63 @@
  */
 
 #pragma once
+#include <chrono>
+#include <cstddef>
 #include <memory>
 #include <optional>
 #include <vector>
 
 #include "types/track.hpp"
 #include "metadata/cache.hpp"
+#include "metadata/health.hpp"
+#include "metadata/singleflight.hpp"
 #include "metadata/sources/source.hpp"
 #include "metadata/uploaders/uploader.hpp"
+#include "orchestrator/worker.hpp"
+
+/// Threads the sources are queried on, and so the most searches that run at once.
+constexpr std::size_t kSourceThreads{4};
+
+/// Wall time enrich() waits on the sources before passing over the ones yet to answer. Just past
+/// a single request's timeout, so only a source that is stuck is passed over.
+constexpr std::chrono::seconds kSourceDeadline{6};
+
+/// How long a hedged enrichment gives one contender for the image before starting the next. About
+/// what a healthy source takes to answer, so a hedge is only placed on a slow one.
+constexpr std::chrono::milliseconds kHedgeDelay{800};
+
+/**
+ * How an enrichment spreads its searches. Defaults to the constants above; tests substitute a
+ * tighter schedule.
+ */
+struct EnrichSchedule {
+    std::chrono::milliseconds sourceDeadline = kSourceDeadline;
+    std::size_t sourceThreads = kSourceThreads;
+
+    /// Race the sources, then the uploaders, for the image instead of asking them all at once.
+    bool hedged = false;
+    std::chrono::milliseconds hedgeDelay = kHedgeDelay;
+
+    /// Ask the contenders cheapest first, by expected time per usable answer, instead of in
+    /// registration order.
+    bool adaptiveOrder = false;
+
+    /// Where the searches and uploads queue for their hosts' rate limits: Bulk for a backfill,
+    /// so that the app's own lookups still come first.
+    CallPriority priority = CallPriority::Interactive;
+};
 
 class Enricher {
 public:
     /**
      * @param cache Long-lived metadata cache (not owned).
+     * @param schedule How the searches are spread. Defaults to the production schedule.
      */
-    explicit Enricher(MetadataCache &cache);
+    explicit Enricher(MetadataCache &cache, const EnrichSchedule &schedule = {});
 
     /**
      * Registers a web source tried during enrichment for image + song urls.
-     * Sources are tried in registration order.
+     * Sources are queried side by side, but their answers are taken in registration order.
      * @param source Shared handle to the source.
      */
     void registerSource(std::shared_ptr<MetadataWebSource> source);
@@ -36,7 +74,17 @@ public:
     void registerUploader(std::unique_ptr<Uploader> uploader);
 
     /**
-     * Enriches a track with an image url and per-platform song urls.
+     * Enriches a track with an image url and per-platform song urls. Every source with something
+     * to offer is searched at once; the uploaders are only tried once each has answered or the
+     * source deadline has passed.
+     *
+     * In hedged mode the sources, then the uploaders, are started one at a time instead, each
+     * after the last has answered or had the hedge delay to do so. The first usable image wins
+     * and the contenders only after an image are cancelled, or never started; every one still
+     * owing a link is then started, if it was not yet, and kept until the source deadline. With
+     * the image already cached there is nothing to hedge, and they are all started at once.
+     *
+     * Concurrent calls for the same track identity share a single enrichment.
      * @param track Base track to enrich.
      * @param thumbnail Optional raw thumbnail bytes from the poller.
      * @return A fully populated EnrichedTrack (image may be empty on total failure).
@@ -45,8 +93,133 @@ public:
                                        const std::optional<std::vector<unsigned char> > &thumbnail)
     const;
 
+    /**
+     * Enriches a track as above, but returns by the deadline with whatever has been found.
+     *
+     * The deadline only ends the wait; it is not passed on to the requests. Each search or
+     * upload is given until the later of the deadline and the source deadline, so one still
+     * running when this returns carries on, and whatever it finds that is still missing goes
+     * straight to the cache for the next enrichment. A call that joins an enrichment of the same
+     * track already running waits on it only until its own deadline.
+     * @param track Base track to enrich.
+     * @param thumbnail Optional raw thumbnail bytes from the poller.
+     * @param deadline When the caller needs an answer by. Not a limit on the transfers.
+     * @return What was found by the deadline (image may be empty).
+     */
+    [[nodiscard]] EnrichedTrack enrich(const Track &track,
+                                       const std::optional<std::vector<unsigned char> > &thumbnail,
+                                       std::chrono::steady_clock::time_point deadline) const;
+
+    /**
+     * Asks the sources again for a track whose cached image is a fallback or a loose match, and
+     * replaces it in place if one now has something better. Song links still missing are filled
+     * in on the way. The sources are asked in turn on the calling thread, stopping at the first
+     * full match.
+     * @param track Track whose cached image to upgrade.
+     * @param context A stop or deadline cuts the upgrade short.
+     * @return Whether a better image was written.
+     */
+    bool upgrade(const Track &track, const CallContext &context = {}) const;
+
+    /**
+     * The running health of every source and uploader asked so far. A contender whose circuit is
+     * open is passed over until its backoff runs out.
+     */
+    [[nodiscard]] std::vector<HealthSnapshot> health() const;
+
 private:
+    /// A source's answer, and whether the search behind it was cancelled by its caller.
+    struct Search {
+        SearchResult result;
+        bool cancelled = false;
+    };
+
+    /// One source or uploader asked during an enrichment.
+    struct Lane;
+
+    /// Where the jobs of one enrichment post their answers.
+    struct Race;
+
+    /// The enrichment behind enrich(), run once per identity however many callers want it.
+    EnrichedTrack lookup(const Track &track,
+                         const std::optional<std::vector<unsigned char> > &thumbnail,
+                         std::chrono::steady_clock::time_point deadline) const;
+
+    /**
+     * The sources with something to offer, then the uploaders if an image is wanted, in the order
+     * they are to be asked.
+     */
+    std::vector<Lane> contenders(const EnrichedTrack &out,
+                                 const std::optional<std::vector<unsigned char> > &thumbnail) const;
+
+    /**
+     * Hands a lane to the pool. Its answer is posted to the race, or, if the enrichment has
+     * stopped waiting by then, written to the cache.
+     */
+    void launch(const std::shared_ptr<Race> &race, Lane &lane, std::size_t index,
+                const Track &track, const CallContext &context) const;
+
+    /**
+     * Writes what a lane found after its enrichment stopped waiting, where it is still missing.
+     * @param platform Platform or host the lane asked.
+     * @param needLink Whether the platform's link was still wanted.
+     * @param uploaded Whether the lane was an uploader's.
+     * @param wantImage Whether the enrichment returned without an image.
+     */
+    void settleLate(const Track &track, const std::string &platform, bool needLink, bool uploaded,
+                    const SearchResult &answer, bool wantImage) const;
+
+    /**
+     * Asks every source with something to offer at once, then the uploaders if that gave no image.
+     * @return Whether anything was added to out.
+     */
+    bool searchAll(EnrichedTrack &out, const std::optional<std::vector<unsigned char> > &thumbnail,
+                   std::chrono::steady_clock::time_point deadline) const;
+
+    /**
+     * Races the sources and uploaders for the image, hedging on the slow ones.
+     * @return Whether anything was added to out.
+     */
+    bool raceForImage(EnrichedTrack &out,
+                      const std::optional<std::vector<unsigned char> > &thumbnail,
+                      std::chrono::steady_clock::time_point deadline) const;
+
+    /**
+     * Picks the contenders to ask, out of their names in registration order.
+     * @return Indices of those whose circuit is closed, cheapest first under adaptiveOrder.
+     */
+    std::vector<std::size_t> rank(const std::vector<std::string> &names) const;
+
+    /**
+     * Searches a source, folding how it went into its health unless the search was cancelled.
+     * Concurrent searches of one source for the same identity share a single request. Whatever
+     * else the search turned up is kept in the cache.
+     */
+    SearchResult ask(MetadataWebSource &source, const std::string &name, const Track &track,
+                     const CallContext &context) const;
+
+    /**
+     * Writes the songs a search turned up beside the track asked for to the cache, graded as
+     * harvested, wherever the cache has nothing of its own for them.
+     * @param platform Platform the search asked.
+     * @param track Track the search was for.
+     * @param others Songs the search listed beside it.
+     */
+    void keepHarvest(const std::string &platform, const Track &track,
+                     const std::vector<HarvestedSong> &others) const;
+
+    /// Uploads to an uploader, folding how it went into its health unless it was cancelled.
+    UploadResult upload(Uploader &uploader, const std::string &name,
+                        const std::vector<unsigned char> &bytes, const CallContext &context) const;
+
     MetadataCache &_cache;
+    EnrichSchedule _schedule{};
     std::vector<std::shared_ptr<MetadataWebSource> > _sources{};
     std::vector<std::unique_ptr<Uploader> > _uploaders{};
+    mutable HealthBoard _health;
+    mutable SingleFlight<std::string, EnrichedTrack> _enrichments;
+    mutable SingleFlight<std::string, Search> _searches;
+
+    /// Runs the source searches off the calling thread.
+    mutable WorkerPool _pool;
 };
\ No newline at end of file
@@ -0,0 +1,143 @@
+/**
+ * @file health.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "metadata/cache.hpp"
+
+/// Weight the latest answer carries in the latency and success averages.
+constexpr double kHealthSmoothing{0.2};
+
+/// Failures in a row that open a contender's circuit.
+constexpr std::uint32_t kFailuresToOpen{3};
+
+/// How long a circuit first stays open. Every failure after that doubles it, up to kMaxBackoff.
+constexpr std::chrono::seconds kBaseBackoff{30};
+constexpr std::chrono::seconds kMaxBackoff{30 * 60};
+
+/// How often the health of every contender is written to the log.
+constexpr std::chrono::minutes kHealthLogInterval{15};
+
+/**
+ * How a single call to a source or uploader went.
+ */
+enum class Outcome {
+    Hit, ///< Answered with something usable.
+    Miss, ///< Answered, but had nothing for the track.
+    Failed, ///< Could not be asked: transport, HTTP or parse failure.
+};
+
+/**
+ * A point-in-time copy of one contender's health, for metrics and the log.
+ */
+struct HealthSnapshot {
+    std::string name;
+    std::chrono::milliseconds latency{};
+    double successRatio = 1.0;
+    std::uint32_t consecutiveFailures = 0;
+    std::uint64_t calls = 0;
+    /// How long the circuit stays open for; zero while it is closed.
+    std::chrono::seconds openFor{};
+};
+
+/**
+ * Running health of one source or uploader: how long it takes, how often it has something, and
+ * whether it has failed enough in a row to stop being asked for a while.
+ */
+class SourceHealth {
+public:
+    using Clock = std::chrono::system_clock;
+
+    /**
+     * Whether the contender may be asked. It may not while its circuit is open; once the backoff
+     * has run out it is asked again, and its next answer closes or reopens the circuit.
+     */
+    [[nodiscard]] bool allows(Clock::time_point now) const;
+
+    /**
+     * Folds one call into the averages, opening or closing the circuit.
+     * @param outcome How the call went.
+     * @param latency How long the call took.
+     * @param now When the call finished.
+     * @return Whether this call opened the circuit.
+     */
+    bool record(Outcome outcome, std::chrono::milliseconds latency, Clock::time_point now);
+
+    /**
+     * Expected wall time spent per usable answer: the average latency over the success ratio.
+     * Zero until the contender has been asked, so a new one is tried first.
+     */
+    [[nodiscard]] double expectedCost() const;
+
+    [[nodiscard]] HealthSnapshot snapshot(std::string name, Clock::time_point now) const;
+
+    /**
+     * Serializes the health as: [version: 1 byte][latency_ms][success_ratio]
+     * [consecutive_failures][calls][open_until_ms], each field eight bytes written by
+     * cache_codec::putI64 (the two averages as the bits of their double).
+     */
+    [[nodiscard]] std::string encode() const;
+
+    /**
+     * Parses an encode()d health.
+     * @return The health, or nullopt if the value is malformed or from an unknown version.
+     */
+    [[nodiscard]] static std::optional<SourceHealth> decode(std::string_view raw);
+
+private:
+    double _latencyMs = 0.0;
+    double _successRatio = 1.0;
+    std::uint32_t _consecutiveFailures = 0;
+    std::uint64_t _calls = 0;
+    Clock::time_point _openUntil{};
+};
+
+/**
+ * The health of every contender an Enricher asks, keyed by its identify() name. Each is loaded
+ * from the cache's state rows the first time it is touched and written back after every call, so
+ * an open circuit survives a restart.
+ */
+class HealthBoard {
+public:
+    /**
+     * @param store Cache the health is persisted in (not owned).
+     */
+    explicit HealthBoard(MetadataCache &store);
+
+    /// Whether the named contender's circuit lets it be asked now.
+    [[nodiscard]] bool allows(const std::string &name);
+
+    /// Folds one call to the named contender into its health and persists it.
+    void record(const std::string &name, Outcome outcome, std::chrono::milliseconds latency);
+
+    /// Expected wall time per usable answer from the named contender; see SourceHealth.
+    [[nodiscard]] double expectedCost(const std::string &name);
+
+    /// Every contender touched so far, ordered by name.
+    [[nodiscard]] std::vector<HealthSnapshot> snapshot() const;
+
+private:
+    /// The named contender's health, loaded on first use. Expects _mutex held.
+    SourceHealth &entry(const std::string &name);
+
+    /// Writes every contender's health to the log once kHealthLogInterval has passed. Expects
+    /// _mutex held.
+    void logIfDue(SourceHealth::Clock::time_point now);
+
+    MetadataCache &_store;
+    mutable std::mutex _mutex;
+    std::map<std::string, SourceHealth> _health{};
+    SourceHealth::Clock::time_point _lastLogged{};
+};
@@ -0,0 +1,42 @@
+/**
+ * @file callContext.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <stop_token>
+
+/**
+ * Whom a call's answer is for, so a host's rate limit can serve the user ahead of background work
+ * without starving it.
+ */
+enum class CallPriority {
+    /// Someone is waiting on it, e.g. the now-playing track's enrichment or its scrobble.
+    Interactive,
+    /// Nobody is, e.g. a backfill, a cache upgrade or a replay of journaled scrobbles.
+    Bulk,
+};
+
+/**
+ * What a single outgoing call is allowed, handed down from whoever wants its answer, through the
+ * source or uploader making it, to the CurlWrapper carrying it out.
+ */
+struct CallContext {
+    /// Pulled once the answer is no longer wanted. A transfer in flight is aborted.
+    std::stop_token stop{};
+
+    /// When the answer stops being useful. The transfer's timeout is cut to what is left of it.
+    std::optional<std::chrono::steady_clock::time_point> deadline{};
+
+    /// Where the call queues behind others for its host's rate limit.
+    CallPriority priority = CallPriority::Interactive;
+
+    /// Whether the deadline has already passed.
+    [[nodiscard]] bool expired() const {
+        return deadline && std::chrono::steady_clock::now() >= *deadline;
+    }
+};
@@ -7,13 +7,24 @@
 #pragma once
 
 #include <curl/curl.h>
+#include <functional>
+#include <future>
+#include <memory>
 #include <stdexcept>
 #include <string_view>
 #include <utility>
 
 #include "log/log.hpp"
+#include "metadata/http/callContext.hpp"
 #include "types/track.hpp"
 
+/// Longest any single request may take, connecting included. A call's deadline only shortens it.
+constexpr std::chrono::seconds kRequestTimeout{5};
+
+/// Largest response body, once decoded, that is read; a bigger one fails the call. Search pages
+/// run to a few hundred KB.
+constexpr std::size_t kMaxResponseBytes{16 * 1024 * 1024};
+
 class CurlInitError : public std::exception {
 public:
     [[nodiscard]] const char *what() const noexcept override {
@@ -26,6 +37,11 @@ struct CurlResult {
     std::string curlErrorString;
     long HTTPCode = 0;
     std::string output;
+    /// Whether the call went out on a connection already open, with no handshake of its own.
+    bool reusedConnection = false;
+    /// Bytes of the response that came over the wire, headers included, before decoding; output
+    /// holds the body decoded.
+    std::size_t bytesReceived = 0;
 
     /**
      * Whether libcurl carried the request out.
@@ -42,6 +58,11 @@ struct CurlResult {
      */
     [[nodiscard]] bool ok() const;
 
+    /**
+     * Whether the call was aborted because its caller stopped wanting the answer.
+     */
+    [[nodiscard]] bool cancelled() const;
+
     /**
      * A short, single-line excerpt of the response body.
      */
@@ -83,16 +104,50 @@ private:
 
 class CurlWrapper {
 protected:
+    /// Borrowed from HttpClient for the wrapper's lifetime, and handed back by the destructor.
     CURL *curl = nullptr;
     curl_slist *headers = nullptr;
     curl_mime *mime = nullptr;
     char errbuf[CURL_ERROR_SIZE] = {0};
 
+    /// Stop token of the caller, polled by ProgressCallback while the transfer runs.
+    std::stop_token stop{};
+    /// Deadline of the caller; a request that would start past it is not sent.
+    std::optional<std::chrono::steady_clock::time_point> deadline{};
+    /// Priority of the caller, to queue at for the host's rate limit.
+    CallPriority priority = CallPriority::Interactive;
+    /// Host the request goes to, whose rate limit it waits on before going out.
+    std::string host;
+
     static size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp) {
-        static_cast<std::string *>(userp)->append(static_cast<char *>(contents), size * nmemb);
+        auto *output = static_cast<std::string *>(userp);
+        // Taking less than offered aborts the transfer with CURLE_WRITE_ERROR.
+        if (size * nmemb > kMaxResponseBytes - output->size())
+            return 0;
+        output->append(static_cast<char *>(contents), size * nmemb);
         return size * nmemb;
     }
 
+    static int ProgressCallback(void *clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+        // Non-zero aborts the transfer with CURLE_ABORTED_BY_CALLBACK.
+        return static_cast<const std::stop_token *>(clientp)->stop_requested() ? 1 : 0;
+    }
+
+    /**
+     * Readies the request to go out into r: checks its context still wants it, waits for the
+     * host's rate limit, and points the response at r.output.
+     * @return Whether it may go out; if not, r says why.
+     */
+    [[nodiscard]] bool prepare(CurlResult &r);
+
+    /**
+     * Reads the outcome of a finished transfer into r.
+     * @param code What libcurl finished it with.
+     */
+    void finish(CurlResult &r, CURLcode code);
+
+    friend class HttpEngine;
+
 public:
     explicit CurlWrapper(const std::string &endpoint);
 
@@ -126,7 +181,40 @@ public:
      */
     void addMime(const std::vector<unsigned char> &bytes, const std::string &name);
 
+    /**
+     * Sends the request as a POST of the given form fields.
+     * @param fields URL-encoded body; copied, so it need not outlive the call.
+     */
     void usePost(const std::string &fields) const;
 
+    /**
+     * Binds the request to its caller's context. A stop requested while the transfer runs aborts
+     * it, within about a second, and a deadline cuts the timeout to what is left of it. Both also
+     * end its wait for the host's rate limit, which it queues for at the context's priority.
+     * @param context Context of the call this request carries out.
+     */
+    void setContext(const CallContext &context);
+
+    /**
+     * Waits for the host's rate limit, if it has one, then carries the request out.
+     */
     [[nodiscard]] CurlResult performCall();
+
+    /**
+     * As performCall(), but the transfer runs on HttpEngine's I/O thread alongside any others,
+     * and the caller only waits for the host's rate limit. The request is kept until the
+     * transfer ends, and its context's stop aborts it promptly.
+     * @param request Request to carry out, set up as for performCall().
+     * @return The result, once the transfer ends.
+     */
+    [[nodiscard]] static std::future<CurlResult> performAsync(std::unique_ptr<CurlWrapper> request);
+
+    /**
+     * As above, but calls done with the result instead of handing back a future, so a caller can
+     * wait on several transfers at once. See HttpEngine::submit() for where done runs.
+     * @param request Request to carry out, set up as for performCall().
+     * @param done Called with the result once the transfer ends.
+     */
+    static void performAsync(std::unique_ptr<CurlWrapper> request,
+                             std::function<void(CurlResult)> done);
 };
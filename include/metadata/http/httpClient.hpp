@@ -0,0 +1,101 @@
+/**
+ * @file httpClient.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <curl/curl.h>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Most idle easy handles kept per host; more than this are cleaned up as they come back.
+inline constexpr std::size_t kMaxIdlePerHost{8};
+
+/**
+ * What the calls to one host have taken off the wire, as HttpClient::traffic() reports it.
+ */
+struct HostTraffic {
+    std::string host;
+    /// Calls that went out, however they ended.
+    std::uint64_t calls = 0;
+    /// Of those, the ones that went out on a connection already open.
+    std::uint64_t reused = 0;
+    /// Response bytes received, headers included, before decoding.
+    std::uint64_t bytesReceived = 0;
+};
+
+/**
+ * The process's libcurl handles. Easy handles are lent out per host and kept once returned. Each
+ * keeps its own connections open across calls, so a call handed a handle that has spoken to its
+ * host already goes out on that connection instead of connecting and handshaking again.
+ *
+ * All of them share one DNS cache and TLS session cache, so even a fresh handle skips the lookup
+ * and resumes the TLS session. Connections are not shared: handles run on several threads at
+ * once, and libcurl does not support a connection cache shared between concurrent threads.
+ *
+ * CurlWrapper borrows its handle here; nothing else needs to.
+ */
+class HttpClient {
+public:
+    /// The process-wide client.
+    static HttpClient &instance();
+
+    HttpClient(const HttpClient &) = delete;
+
+    HttpClient &operator=(const HttpClient &) = delete;
+
+    /**
+     * Lends out an easy handle for a host, the one handed back last if any, attached to the shared
+     * caches and otherwise at libcurl's defaults.
+     * @param host Host the handle will call, as hostOf() reads it.
+     * @return The handle; hand it back with release(). nullptr if libcurl could not make one.
+     */
+    [[nodiscard]] CURL *acquire(std::string_view host);
+
+    /**
+     * Takes back a handle lent out by acquire(). Its options are reset; its connections stay open
+     * with it, for the next call to the host.
+     * @param host Host it was lent out for.
+     * @param handle The handle; nullptr is ignored.
+     */
+    void release(std::string_view host, CURL *handle);
+
+    /// Handles idle in the pool for a host.
+    [[nodiscard]] std::size_t idle(std::string_view host) const;
+
+    /**
+     * Counts a call that went out against its host.
+     * @param host Host it called.
+     * @param bytesReceived Response bytes it received, headers included, before decoding.
+     * @param reused Whether it went out on a connection already open.
+     */
+    void record(std::string_view host, std::size_t bytesReceived, bool reused);
+
+    /// Every host called so far, by host name.
+    [[nodiscard]] std::vector<HostTraffic> traffic() const;
+
+private:
+    HttpClient();
+
+    ~HttpClient();
+
+    static void lockShare(CURL *, curl_lock_data data, curl_lock_access, void *client);
+
+    static void unlockShare(CURL *, curl_lock_data data, void *client);
+
+    CURLSH *_share = nullptr;
+    /// One per kind of data the share holds, so a DNS lookup never waits on a TLS session.
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> _shareLocks{};
+
+    mutable std::mutex _mutex;
+    std::map<std::string, std::vector<CURL *>, std::less<> > _idle{};
+    std::map<std::string, HostTraffic, std::less<> > _traffic{};
+};
@@ -0,0 +1,98 @@
+/**
+ * @file httpEngine.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#pragma once
+
+#include <chrono>
+#include <curl/curl.h>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "metadata/http/curlWrapper.hpp"
+
+/// Longest the I/O thread sleeps with nothing to do before looking at its transfers again.
+constexpr std::chrono::milliseconds kEnginePollInterval{1000};
+
+/**
+ * Carries out many transfers at once on one I/O thread, driving libcurl's multi interface, so a
+ * caller can have several requests in flight without a thread blocked on each.
+ *
+ * Reached through CurlWrapper::performAsync(), which the storefront searches MultiRegionScraper
+ * races go through; the handles it drives still come from HttpClient's pool.
+ */
+class HttpEngine {
+public:
+    /// The process-wide engine; its I/O thread starts with it.
+    static HttpEngine &instance();
+
+    HttpEngine(const HttpEngine &) = delete;
+
+    HttpEngine &operator=(const HttpEngine &) = delete;
+
+    /**
+     * Hands a request over to the I/O thread.
+     * @param request Request to carry out; kept until its transfer ends.
+     * @return Its result, once the transfer ends.
+     */
+    [[nodiscard]] std::future<CurlResult> submit(std::unique_ptr<CurlWrapper> request);
+
+    /**
+     * Hands a request over to the I/O thread, to be told of its result rather than wait on it, so
+     * one caller can wait on several.
+     * @param request Request to carry out; kept until its transfer ends.
+     * @param done Called with the result once the transfer ends: on the I/O thread, or on the
+     * caller's if the request never got that far. It must be brief and must not throw.
+     */
+    void submit(std::unique_ptr<CurlWrapper> request, std::function<void(CurlResult)> done);
+
+    /// Transfers handed over and not yet ended.
+    [[nodiscard]] std::size_t inFlight() const;
+
+private:
+    /**
+     * One request in flight. Its result is written into as the response arrives, so it stays put
+     * until the transfer ends.
+     */
+    struct Transfer {
+        std::unique_ptr<CurlWrapper> request;
+        CurlResult result{};
+        std::function<void(CurlResult)> done{};
+        /// Wakes the I/O thread when the request's stop is pulled, to abort it there and then.
+        std::optional<std::stop_callback<std::function<void()> > > onStop{};
+    };
+
+    HttpEngine();
+
+    ~HttpEngine();
+
+    /// The I/O thread: adds what was handed over, runs the transfers, ends the finished ones.
+    void run(const std::stop_token &stop);
+
+    /// Takes a transfer out of the multi handle and hands its result over.
+    void complete(CURL *handle, CURLcode code);
+
+    /// Hands a transfer's result over, giving its request back first.
+    void settle(std::unique_ptr<Transfer> transfer);
+
+    CURLM *_multi = nullptr;
+
+    mutable std::mutex _mutex;
+    /// Handed over, not yet added to the multi handle.
+    std::vector<std::unique_ptr<Transfer> > _pending{};
+    /// Added, by easy handle; only touched by the I/O thread.
+    std::map<CURL *, std::unique_ptr<Transfer> > _active{};
+    /// Handed over and not yet ended, pending or active.
+    std::size_t _inFlight = 0;
+
+    std::jthread _thread;
+};
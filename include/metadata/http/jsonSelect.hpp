@@ -0,0 +1,100 @@
+/**
+ * @file jsonSelect.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+/**
+ * Reads a few chosen values out of a JSON response as it is parsed, rather than building the
+ * whole document to look three fields up in it.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json_select {
+/// Most pointers one Selector holds.
+inline constexpr std::size_t kMaxPointers{64};
+
+/**
+ * A value found at a selected pointer. Objects and arrays are reported as they open, with no
+ * contents: a pointer ending at one only says it is there.
+ */
+struct Value {
+    enum class Kind { Null, Boolean, Integer, Float, String, Object, Array };
+
+    Kind kind = Kind::Null;
+    bool boolean = false;
+    std::int64_t integer = 0;
+    double number = 0;
+    /// Only valid during the callback it is handed to.
+    std::string_view string{};
+
+    /// The value as an integer: an integer, or a string spelling one, as Last.fm sends codes.
+    [[nodiscard]] std::optional<std::int64_t> asInteger() const;
+};
+
+/**
+ * One value found.
+ */
+struct Match {
+    /// Index of the pointer that selected it, in the order the Selector was given them.
+    std::size_t pointer = 0;
+    /// Index of the innermost array element it sits in; 0 outside any array. Tells the values of
+    /// one array element from the next.
+    std::size_t element = 0;
+    const Value &value;
+};
+
+/**
+ * A compiled set of JSON pointers (RFC 6901), in which a "*" token matches any array index. Build
+ * it once and keep it; selecting with it does not allocate per pointer.
+ */
+class Selector {
+public:
+    /**
+     * Compiles pointers, e.g. "/data/link". A "*" in place of an array index selects the same
+     * path under every element; "" selects the document itself.
+     * @param pointers Up to kMaxPointers pointers.
+     */
+    Selector(std::initializer_list<std::string_view> pointers);
+
+    [[nodiscard]] std::size_t size() const;
+
+private:
+    friend class Handler;
+
+    struct Token {
+        std::string key;
+        /// Set when the token names an array index.
+        std::optional<std::size_t> index;
+        bool any = false;
+
+        [[nodiscard]] bool matchesKey(std::string_view name) const;
+
+        [[nodiscard]] bool matchesIndex(std::size_t at) const;
+    };
+
+    std::vector<std::vector<Token> > _pointers{};
+};
+
+/**
+ * Parses a document, handing every value a pointer selects to the callback in document order.
+ * Anything not on a selected path is read past and never built.
+ * @param json The document.
+ * @param selector Pointers wanted.
+ * @param onMatch Called with each value found.
+ * @return Whether the document parsed whole. Values found before a fault have still been handed
+ * over.
+ */
+bool select(std::string_view json, const Selector &selector,
+            const std::function<void(const Match &)> &onMatch);
+} // namespace json_select
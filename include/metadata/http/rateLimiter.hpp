@@ -0,0 +1,154 @@
+/**
+ * @file rateLimiter.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+/**
+ * Keeps the calls to each remote host within what it tolerates, across every source, uploader and
+ * thread in the process.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "metadata/http/callContext.hpp"
+
+/**
+ * How fast calls to a host may go out: a token bucket refilled at perSecond and holding at most
+ * burst tokens, one spent per call.
+ */
+struct RateLimit {
+    /// Zero or less lets every call through.
+    double perSecond = 0;
+    /// Calls that may go out back to back after the host has been left alone for a while.
+    double burst = 1;
+};
+
+/// Last.fm asks for no more than about 5 calls per second per API key.
+inline constexpr RateLimit kLastFmRateLimit{.perSecond = 5, .burst = 5};
+
+/// Imgur allows 50 uploads an hour per client; a few may go out at once.
+inline constexpr RateLimit kImgurRateLimit{.perSecond = 50.0 / 3600, .burst = 10};
+
+/// While both kinds are waiting, interactive calls served before a bulk call gets its turn.
+inline constexpr std::size_t kInteractiveShare{3};
+
+/**
+ * How long the calls of one priority waited for their tokens.
+ */
+struct RateWaitStats {
+    /// Calls let through.
+    std::uint64_t granted = 0;
+    /// Calls turned away because their deadline or stop came first.
+    std::uint64_t refused = 0;
+    /// Time spent waiting by every call, granted or refused.
+    std::chrono::microseconds totalWait{};
+    std::chrono::microseconds longestWait{};
+
+    /// Mean wait per call; zero before any.
+    [[nodiscard]] std::chrono::microseconds meanWait() const;
+};
+
+/**
+ * One host's wait metrics, as RateLimiter::snapshot() reports them.
+ */
+struct RateLimiterStats {
+    std::string host;
+    RateWaitStats interactive{};
+    RateWaitStats bulk{};
+};
+
+/**
+ * A token bucket shared by every call to one host. Callers queue in arrival order within their
+ * priority; interactive calls go first, but a waiting bulk call is served after at most
+ * kInteractiveShare interactive ones, so neither kind can starve the other.
+ *
+ * The process-wide limiters are reached through forHost(); a host nobody limited is not waited on.
+ */
+class RateLimiter {
+public:
+    explicit RateLimiter(RateLimit limit);
+
+    RateLimiter(const RateLimiter &) = delete;
+
+    RateLimiter &operator=(const RateLimiter &) = delete;
+
+    /**
+     * Blocks until a call may go out, and spends its token.
+     * @param context Priority to queue at. A stop, or a deadline the token would come after, ends
+     * the wait without spending one.
+     * @return Whether a token was had; false if the context ran out first.
+     */
+    bool acquire(const CallContext &context);
+
+    /**
+     * Changes the limit. Tokens already in the bucket beyond the new burst are dropped.
+     * @param limit New limit.
+     */
+    void setLimit(RateLimit limit);
+
+    /// Waits so far, by priority.
+    [[nodiscard]] std::array<RateWaitStats, 2> stats() const;
+
+    /**
+     * The process-wide limiter of a host. Last.fm and Imgur are limited from the start.
+     * @param host Host name, as hostOf() reads it from a URL.
+     * @return The limiter, valid for the life of the process; nullptr if the host is not limited.
+     */
+    [[nodiscard]] static RateLimiter *forHost(std::string_view host);
+
+    /**
+     * Limits a host process-wide, or changes its limit.
+     * @param host Host name, e.g. "music.apple.com".
+     * @param limit Limit to hold its calls to.
+     */
+    static void limitHost(std::string_view host, RateLimit limit);
+
+    /// Every limited host's waits, by host name.
+    [[nodiscard]] static std::vector<RateLimiterStats> snapshot();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// Tops the bucket up for the time since it was last, up to the burst.
+    void refill(Clock::time_point now);
+
+    /// The priority whose oldest caller is served next; only meaningful while someone waits.
+    [[nodiscard]] CallPriority turn() const;
+
+    /// When the bucket next holds a whole token; now if it already does.
+    [[nodiscard]] Clock::time_point nextToken(Clock::time_point now) const;
+
+    void record(CallPriority priority, bool granted, Clock::duration waited);
+
+    mutable std::mutex _mutex;
+    std::condition_variable_any _changed;
+    RateLimit _limit;
+    double _tokens = 0;
+    Clock::time_point _refilled;
+    /// Tickets of the callers waiting, oldest first, by priority.
+    std::array<std::deque<std::uint64_t>, 2> _queues{};
+    std::uint64_t _nextTicket = 0;
+    /// Interactive calls served since the last bulk one.
+    std::size_t _interactiveStreak = 0;
+    /// Bumped whenever the queues or the limit change, to wake the waiters.
+    std::uint64_t _generation = 0;
+    std::array<RateWaitStats, 2> _stats{};
+};
+
+/**
+ * The host a URL names, e.g. "ws.audioscrobbler.com" for "https://ws.audioscrobbler.com/2.0/?x".
+ * @param url Absolute URL.
+ * @return The host, as written; empty if the URL has none.
+ */
+[[nodiscard]] std::string_view hostOf(std::string_view url);
@@ -9,6 +9,19 @@
 #include <string>
 
 constexpr double kMatchGenerosity = 60.0; // Minimum similarity percentage (0-100) for a fuzzy match
+constexpr double kConfidentMatch = 85.0; // Minimum score (0-100) for a match to be trusted outright
+constexpr double kSubstringScore = 90.0; // Score of a match made by one string containing the other
+
+/**
+ * How alike two strings are, tolerant of case: 100 when equal, falling with the edit distance.
+ * @param a First string.
+ * @param b Second string.
+ * @param allowSubstring When true, one string wholly containing the other (past a short length
+ * floor) scores at least kSubstringScore. See fuzzyMatch().
+ * @return The similarity, 0-100.
+ */
+[[nodiscard]] double matchScore(const std::string &a, const std::string &b,
+                                bool allowSubstring = false);
 
 /**
  * Whether two strings name the same thing, tolerant of case, punctuation and small typos.
@@ -17,7 +30,8 @@ constexpr double kMatchGenerosity = 60.0; // Minimum similarity percentage (0-10
  * @param allowSubstring When true, one string wholly containing the other (past a short length
  * floor) also counts as a match. Reserved for fields that carry source-appended decoration such as
  * titles ("… (Remastered 2011)").
- * @return Whether the two are considered a match.
+ * @return Whether the two are considered a match: whether their matchScore() clears
+ * kMatchGenerosity.
  */
 [[nodiscard]] bool fuzzyMatch(const std::string &a, const std::string &b,
                               bool allowSubstring = false);
\ No newline at end of file
@@ -6,8 +6,20 @@
 
 #pragma once
 
+#include <span>
+#include <vector>
+
 #include "types/track.hpp"
 
+/**
+ * What became of one play handed to Scrobbler::scrobbleBatch().
+ */
+enum class ScrobbleStatus {
+    Accepted, ///< Scrobbled.
+    Ignored, ///< Received, but filtered out by the service; sending it again is ignored again.
+    Failed, ///< Not scrobbled, for now: worth sending again later.
+};
+
 /**
  * Capability for services that can scrobble played tracks to a user's account.
  */
@@ -33,6 +45,24 @@ public:
      */
     [[nodiscard]] virtual bool scrobble(const Track &track) const = 0;
 
+    /**
+     * Scrobbles several plays, oldest first. Defaults to scrobbling them one at a time, stopping
+     * at the first one rejected.
+     * @param tracks Plays to scrobble.
+     * @return What became of each play, in the order given.
+     */
+    [[nodiscard]] virtual std::vector<ScrobbleStatus> scrobbleBatch(
+        const std::span<const Track> tracks) const {
+        std::vector statuses(tracks.size(), ScrobbleStatus::Failed);
+        for (std::size_t i = 0; i < tracks.size(); ++i) {
+            if (!scrobble(tracks[i])) {
+                break;
+            }
+            statuses[i] = ScrobbleStatus::Accepted;
+        }
+        return statuses;
+    }
+
     /**
      * Sets the user's currently playing status.
      * @param track Track currently playing.
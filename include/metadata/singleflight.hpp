@@ -0,0 +1,92 @@
+/**
+ * @file singleflight.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+/**
+ * Coalesces concurrent calls for the same key: the first caller runs the work, and anyone asking
+ * for the same key while it runs waits on that call and gets a copy of its result instead of
+ * running the work again. Nothing is remembered once the call is done; a later caller runs the
+ * work afresh.
+ * @tparam Key Ordered key the calls are coalesced on.
+ * @tparam Value What the work returns; copied out to every caller.
+ */
+template<typename Key, typename Value>
+class SingleFlight {
+public:
+    /**
+     * Runs work for key, or joins the call for key already running.
+     * @param key Key the call is coalesced on.
+     * @param work Callable returning a Value. An exception it throws reaches every caller.
+     * @return The result of whichever call ran.
+     */
+    template<typename Work>
+    Value run(const Key &key, Work &&work) {
+        return *run(key, std::forward<Work>(work), std::nullopt);
+    }
+
+    /**
+     * As above, but a caller that joins a call already running waits for it only until its own
+     * deadline, so one started by a caller with more time to spare cannot hold it past that. A
+     * caller that runs the work itself is left to bound it.
+     * @param key Key the call is coalesced on.
+     * @param work Callable returning a Value. An exception it throws reaches every caller.
+     * @param until When a joining caller stops waiting; nullopt to wait for as long as it runs.
+     * @return The result of whichever call ran, or nullopt if the call joined was still running
+     * at until.
+     */
+    template<typename Work>
+    std::optional<Value> run(const Key &key, Work &&work,
+                             const std::optional<std::chrono::steady_clock::time_point> until) {
+        std::unique_lock lock(_mutex);
+        if (const auto it = _inFlight.find(key); it != _inFlight.end()) {
+            const std::shared_future<Value> joined = it->second;
+            lock.unlock();
+            if (until && joined.wait_until(*until) != std::future_status::ready)
+                return std::nullopt;
+            return joined.get();
+        }
+        std::promise<Value> promise;
+        _inFlight.emplace(key, promise.get_future().share());
+        lock.unlock();
+
+        try {
+            Value value = work();
+            // Retired before it is answered, so no caller can join a call that has already ended.
+            retire(key);
+            promise.set_value(value);
+            return value;
+        } catch (...) {
+            retire(key);
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    /// How many calls are running right now.
+    [[nodiscard]] std::size_t inFlight() const {
+        std::lock_guard lock(_mutex);
+        return _inFlight.size();
+    }
+
+private:
+    void retire(const Key &key) {
+        std::lock_guard lock(_mutex);
+        _inFlight.erase(key);
+    }
+
+    mutable std::mutex _mutex;
+    std::map<Key, std::shared_future<Value> > _inFlight{};
+};
@@ -0,0 +1,60 @@
+/**
+ * @file artwork.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/// Edge length, in pixels, artwork is asked for at. Discord never shows the large image bigger.
+constexpr std::uint16_t kArtworkEdge{512};
+
+/// Quality asked of a jpeg rendition, as Apple's own pages do.
+constexpr std::uint8_t kArtworkQuality{60};
+
+/**
+ * Image format an artwork rendition is asked for in.
+ */
+enum class ArtworkFormat : std::uint8_t {
+    Jpeg,
+    Webp
+};
+
+/**
+ * The rendition of an artwork a consumer wants. Apple's image server renders any square size in
+ * either format, so a url naming one rendition can be rewritten into another.
+ */
+struct ArtworkSize {
+    std::uint16_t edge = kArtworkEdge;
+    ArtworkFormat format = ArtworkFormat::Jpeg;
+};
+
+/**
+ * Fills in an artwork template's {w}, {h}, {c} and {f} placeholders.
+ * @param pattern Template as Apple's payloads carry it, e.g. ".../{w}x{h}{c}.{f}".
+ * @param size Rendition to name.
+ * @return The url, or the template as it was if it has no placeholders.
+ */
+[[nodiscard]] std::string fillArtwork(std::string_view pattern, const ArtworkSize &size);
+
+/**
+ * Rewrites the rendition an Apple artwork url names, e.g. ".../296x296bb-60.jpg", keeping its
+ * crop code.
+ * @param url Artwork url.
+ * @param size Rendition to name.
+ * @return The rewritten url, or the url as it was if it is not an Apple artwork url.
+ */
+[[nodiscard]] std::string resizeArtwork(std::string_view url, const ArtworkSize &size);
+
+/**
+ * Picks the artwork out of an html srcset: the smallest candidate at least the size wanted, or
+ * failing that the largest, rewritten to the rendition wanted.
+ * @param srcset Comma separated "url [descriptor]" candidates.
+ * @param size Rendition to name.
+ * @return The url, or empty if the srcset holds none.
+ */
+[[nodiscard]] std::string artworkFromSrcset(std::string_view srcset, const ArtworkSize &size);
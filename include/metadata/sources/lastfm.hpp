@@ -9,6 +9,9 @@
 #include "source.hpp"
 #include "metadata/scrobbler.hpp"
 #include <atomic>
+#include <span>
+#include <string_view>
+#include <vector>
 
 class LastFm : public MetadataWebSource, public Scrobbler {
 public:
@@ -27,7 +30,18 @@ public:
     /**
      * Searching tracks with LastFm does not require a session key, but does require a valid API key.
      */
-    [[nodiscard]] SearchResult searchTrack(const Track &track) override;
+    [[nodiscard]] SearchResult searchTrack(const Track &track,
+                                           const CallContext &context) override;
+
+    /**
+     * Reads a track.search response into the first result matching the track, as searchTrack()
+     * does once the response is in hand.
+     * @param body The response's JSON.
+     * @param track Track searched for.
+     * @return The match, an empty result if none matched, failed if the body is malformed.
+     */
+    [[nodiscard]] static SearchResult parseSearch(std::string_view body,
+                                                  const TrackIdentity &track);
 
     [[nodiscard]] std::string identify() override;
 
@@ -37,6 +51,23 @@ public:
 
     [[nodiscard]] bool scrobble(const Track &track) const override;
 
+    /**
+     * Scrobbles the plays in as few track.scrobble requests as Last.fm allows, each carrying up
+     * to kScrobbleBatchLimit plays under one signature. A play not yet played far enough is not
+     * sent, and stays Failed.
+     */
+    [[nodiscard]] std::vector<ScrobbleStatus> scrobbleBatch(
+        std::span<const Track> tracks) const override;
+
+    /**
+     * Reads a track.scrobble response into what became of each play it carried.
+     * @param body The response's JSON.
+     * @param count Plays the request carried.
+     * @return One status per play; all Failed if the request was refused or the body malformed.
+     */
+    [[nodiscard]] static std::vector<ScrobbleStatus> parseScrobbles(std::string_view body,
+                                                                    std::size_t count);
+
     [[nodiscard]] bool setPlaying(const Track &track) const override;
 
 private:
@@ -48,6 +79,8 @@ private:
 
     const std::chrono::seconds kTrackLengthForScrobble{30};
     const double kTrackLengthPercentageForScrobble{0.5};
+    /// Most plays one track.scrobble request may carry.
+    const std::size_t kScrobbleBatchLimit{50};
 
     const std::string kIDENTITY = "LastFm API";
     const std::string kSESSION_STORAGE_KEY = "amqx_musicppv2_lastfm_apisecret";
@@ -66,5 +99,26 @@ private:
 
     [[nodiscard]] std::string requestAuthToken() const;
 
+    /// Whether a play has been played far enough for Last.fm to take its scrobble.
+    [[nodiscard]] bool playedEnough(const Track &track) const;
+
+    /**
+     * Scrobbles the plays as scrobbleBatch() describes.
+     * @param tracks Plays to scrobble.
+     * @param priority Where the requests queue for Last.fm's rate limit.
+     * @return One status per play.
+     */
+    [[nodiscard]] std::vector<ScrobbleStatus> scrobbleTracks(std::span<const Track> tracks,
+                                                             CallPriority priority) const;
+
+    /**
+     * Sends one track.scrobble request.
+     * @param tracks Plays to send, at most kScrobbleBatchLimit.
+     * @param priority Where the request queues for Last.fm's rate limit.
+     * @return One status per play.
+     */
+    [[nodiscard]] std::vector<ScrobbleStatus> submitScrobbles(std::span<const Track> tracks,
+                                                              CallPriority priority) const;
+
     [[nodiscard]] Session getNewSession(const std::string &token) const;
 };
\ No newline at end of file
@@ -0,0 +1,136 @@
+/**
+ * @file lastfm_request.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+/**
+ * The wire format of Last.fm's API: building signed calls, and reading what they answer.
+ */
+
+#pragma once
+
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "metadata/http/jsonSelect.hpp"
+
+/// Where every Last.fm API call is sent.
+inline constexpr std::string_view kLastFmEndpoint{"https://ws.audioscrobbler.com/2.0/"};
+
+/**
+ * One Last.fm API call's parameters, kept in name order as they are set so that signing and
+ * encoding them is a single pass.
+ *
+ * A signed call carries api_sig, the MD5 of every parameter's name and value in name order
+ * followed by the shared secret. Every call asks for JSON; format is not signed, per Last.fm.
+ */
+class LastFmRequest {
+public:
+    /**
+     * Starts a call.
+     * @param method API method, e.g. "track.scrobble".
+     * @param apiKey The application's API key.
+     */
+    LastFmRequest(std::string_view method, std::string_view apiKey);
+
+    /**
+     * Sets a parameter, replacing any already set under the name.
+     * @param name Parameter name, e.g. "artist" or "artist[3]".
+     * @param value Its value, unescaped.
+     * @return This, so calls can be chained.
+     */
+    LastFmRequest &set(std::string_view name, std::string value);
+
+    /**
+     * Signs the call with the shared secret. Unsigned calls carry no api_sig.
+     * @param secret The application's shared secret.
+     * @return This, so calls can be chained.
+     */
+    LastFmRequest &sign(std::string secret);
+
+    /// The call as a form body, for a POST to kLastFmEndpoint.
+    [[nodiscard]] std::string body() const;
+
+    /// The call as a URL, for a GET.
+    [[nodiscard]] std::string url() const;
+
+    /// Parameters set, api_key and method included.
+    [[nodiscard]] std::size_t size() const;
+
+private:
+    /**
+     * Writes the parameters, then api_sig if signed, then format, escaped and joined with '&'.
+     * @param prefix What the output starts with.
+     */
+    [[nodiscard]] std::string encode(std::string_view prefix) const;
+
+    /// By name, ascending.
+    std::vector<std::pair<std::string, std::string> > _params{};
+    std::string _secret{};
+};
+
+/**
+ * Error codes Last.fm answers a call with (https://www.last.fm/api/errorcodes). Only the ones
+ * acted on are named.
+ */
+enum class LastFmError : int {
+    None = 0,
+    AuthenticationFailed = 4,
+    InvalidParameters = 6,
+    OperationFailed = 8,
+    InvalidSessionKey = 9,
+    InvalidApiKey = 10,
+    ServiceOffline = 11,
+    InvalidSignature = 13,
+    UnauthorizedToken = 14,
+    TokenExpired = 15,
+    TemporaryError = 16,
+    SuspendedApiKey = 26,
+    RateLimitExceeded = 29,
+};
+
+/**
+ * Whether a call succeeded, and why not if it did not.
+ */
+struct LastFmStatus {
+    bool ok = false;
+    /// Set when Last.fm answered with an error; None if the call succeeded or the body was not
+    /// an answer at all.
+    LastFmError error = LastFmError::None;
+    std::string message{};
+
+    /// Whether the same call may succeed if sent again later.
+    [[nodiscard]] bool retryable() const;
+};
+
+/**
+ * Reads a call's status from its response: JSON ({"error": 9, "message": ...}), or the XML
+ * Last.fm falls back to (<lfm status="failed"><error code="9">...</error></lfm>).
+ * @param body The response.
+ * @return The status; not ok, with no error, if the body is neither.
+ */
+[[nodiscard]] LastFmStatus parseLastFmStatus(std::string_view body);
+
+/// Pointers a Last.fm response's status is read from: "/error", then "/message". A
+/// json_select::Selector that lists them first reads the status as the rest is selected.
+inline constexpr std::size_t kLastFmStatusPointers{2};
+
+/**
+ * Takes a match of one of the status pointers into a status, marking it failed if the response
+ * carries an error.
+ * @param match A match from a selector listing the status pointers first.
+ * @param status Status to fill; start it ok.
+ * @return Whether the match was one of the status pointers.
+ */
+bool takeLastFmStatus(const json_select::Match &match, LastFmStatus &status);
+
+/**
+ * As parseLastFmStatus(), for a JSON response already parsed.
+ * @param json The response.
+ * @return The status.
+ */
+[[nodiscard]] LastFmStatus lastFmStatus(const nlohmann::json &json);
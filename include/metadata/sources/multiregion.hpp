@@ -0,0 +1,89 @@
+/**
+ * @file multiregion.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "metadata/cache.hpp"
+#include "metadata/sources/regions.hpp"
+#include "metadata/sources/source.hpp"
+
+/// How long the first storefront asked has to answer before the fallbacks are asked alongside it.
+/// About what a healthy storefront search takes, so a hedge is only placed on a slow one.
+constexpr std::chrono::milliseconds kRegionHedgeDelay{800};
+
+/**
+ * Which storefronts are searched, and in what order. Defaults to Canada, hedged into the
+ * storefronts that carry most of what Canada does not.
+ */
+struct RegionPlan {
+    ScraperRegions primary = ScraperRegions::CA;
+    std::vector<ScraperRegions> fallbacks{ScraperRegions::US, ScraperRegions::GB,
+                                          ScraperRegions::JP};
+    std::chrono::milliseconds hedgeDelay = kRegionHedgeDelay;
+};
+
+/**
+ * Searches several Apple Music storefronts for a track that may be missing from one. The
+ * storefront an artist was last found in is asked first, else the primary; if it has not found
+ * the track within the hedge delay, the fallbacks are asked side by side and the first to find it
+ * wins. Where each artist was found is kept in the cache, so their later tracks go straight there.
+ *
+ * The searches are started with harvestTrackAsync(), so they run on HttpEngine's I/O thread and
+ * the lookup only waits; no thread is started per storefront.
+ */
+class MultiRegionScraper final : public MetadataWebSource {
+public:
+    /// Makes the source that searches one storefront.
+    using RegionSource = std::function<std::shared_ptr<MetadataWebSource>(ScraperRegions)>;
+
+    /**
+     * @param cache Cache the per-artist storefronts are kept in (not owned).
+     * @param plan Storefronts to search.
+     * @param makeSource Makes the source for a storefront, called once per storefront used.
+     */
+    MultiRegionScraper(MetadataCache &cache, RegionPlan plan, RegionSource makeSource);
+
+    /// The storefront sources' shared name, so health, cache rows and links stay as one source's.
+    [[nodiscard]] std::string identify() override;
+
+    [[nodiscard]] SearchResult searchTrack(const Track &track,
+                                           const CallContext &context) override;
+
+    /// Searches as above, handing back what the winning storefront's search turned up.
+    [[nodiscard]] SearchHarvest harvestTrack(const Track &track,
+                                             const CallContext &context) override;
+
+    /**
+     * The storefront an artist was last found in.
+     * @return The storefront, or nullopt if none was kept for the artist.
+     */
+    [[nodiscard]] std::optional<ScraperRegions> affinity(const std::string &artist) const;
+
+private:
+    /// Where the searches of one lookup post their answers.
+    struct Race;
+
+    /// The storefronts to ask for a track, the one to ask first in front.
+    std::vector<ScraperRegions> order(const Track &track) const;
+
+    std::shared_ptr<MetadataWebSource> sourceFor(ScraperRegions region);
+
+    MetadataCache &_cache;
+    RegionPlan _plan;
+    RegionSource _makeSource;
+
+    std::mutex _mutex{};
+    std::map<ScraperRegions, std::shared_ptr<MetadataWebSource> > _sources{};
+};
@@ -0,0 +1,48 @@
+/**
+ * @file regions.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * The Apple Music storefronts the scraper can search, by country.
+ */
+enum class ScraperRegions : size_t {
+    AE, AG, AI, AM, AR, AT, AU, AZ, BB, BE,
+    BG, BH, BM, BO, BR, BS, BW, BY, BZ, CA,
+    CF, CH, CI, CL, CM, CN, CO, CR, CZ, DE,
+    DK, DM, DO, EC, EE, EG, ES, FI, FR, GB,
+    GD, GE, GN, GQ, GR, GT, GW, GY, HK, HN,
+    HR, HU, ID, IE, IL, IN, IT, JM, JO, JP,
+    KG, KN, KR, KW, KY, KZ, LA, LC, LI, LT,
+    LU, LV, MA, MD, ME, MG, MK, ML, MO, MS,
+    MT, MU, MX, MY, MZ, NE, NG, NI, NL, NO,
+    NZ, OM, PA, PE, PH, PL, PR, PT, PY, QA,
+    RO, RU, SA, SE, SG, SI, SK, SN, SR, SV,
+    TC, TH, TJ, TM, TN, TR, TT, TW, UA, UG,
+    US, UY, AZ_UZ, VC, VE, VG, VN, ZA,
+
+    _COUNT
+};
+
+/**
+ * @return The storefront's two-letter code, as it appears in its urls.
+ * @throws std::out_of_range For a value past the table.
+ */
+std::string to_string(ScraperRegions region);
+
+/**
+ * Looks up a storefront by its two-letter code, in either case.
+ * @return The storefront, or nullopt if there is none by that code.
+ */
+[[nodiscard]] std::optional<ScraperRegions> parseRegion(std::string_view code);
+
+/// Whether a two-letter code names a storefront, in either case.
+[[nodiscard]] bool isValidRegion(std::string_view region);
@@ -6,44 +6,110 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "source.hpp"
+#include "metadata/http/curlWrapper.hpp"
+#include "metadata/sources/artwork.hpp"
+#include "metadata/sources/regions.hpp"
 #include "types/results.hpp"
 
-enum class ScraperRegions : size_t {
-    AE, AG, AI, AM, AR, AT, AU, AZ, BB, BE,
-    BG, BH, BM, BO, BR, BS, BW, BY, BZ, CA,
-    CF, CH, CI, CL, CM, CN, CO, CR, CZ, DE,
-    DK, DM, DO, EC, EE, EG, ES, FI, FR, GB,
-    GD, GE, GN, GQ, GR, GT, GW, GY, HK, HN,
-    HR, HU, ID, IE, IL, IN, IT, JM, JO, JP,
-    KG, KN, KR, KW, KY, KZ, LA, LC, LI, LT,
-    LU, LV, MA, MD, ME, MG, MK, ML, MO, MS,
-    MT, MU, MX, MY, MZ, NE, NG, NI, NL, NO,
-    NZ, OM, PA, PE, PH, PL, PR, PT, PY, QA,
-    RO, RU, SA, SE, SG, SI, SK, SN, SR, SV,
-    TC, TH, TJ, TM, TN, TR, TT, TW, UA, UG,
-    US, UY, AZ_UZ, VC, VE, VG, VN, ZA,
-
-    _COUNT
-};
+/// Where the scraper's search pages are read from, under the region.
+inline constexpr std::string_view kScraperEndpoint{"https://music.apple.com/"};
 
-std::string to_string(ScraperRegions region);
+/**
+ * Where the scraper reads a search page's results from.
+ */
+enum class ScraperMode {
+    /// The rendered markup, walked element by element. The default.
+    Markup,
+    /// The JSON payload the page embeds for its own scripts, falling back to the markup when a
+    /// page carries none. Opt-in: its layout is only known from hand-built pages so far, not
+    /// from recorded ones.
+    Payload
+};
 
-bool isValidRegion(const std::string &region);
+/**
+ * One song on a search page, as the page's embedded payload describes it.
+ */
+struct ScrapedSong {
+    std::string title;
+    std::string artist;
+    std::string album;
+    std::chrono::milliseconds duration{0};
+    /// Artwork url with {w}, {h}, {c} and {f} left in for the size, crop and format.
+    std::string artwork;
+    std::string url;
+};
 
 class Scraper : public MetadataWebSource {
 public:
-    explicit Scraper(const std::string &region);
+    /**
+     * @param region Storefront searched, e.g. "ca".
+     * @param mode Where results are read from.
+     * @param artwork Rendition the artwork urls found are rewritten to name.
+     */
+    explicit Scraper(const std::string &region, ScraperMode mode = ScraperMode::Markup,
+                     const ArtworkSize &artwork = {});
 
-    explicit Scraper(const ScraperRegions &region) : Scraper(to_string(region)) {
+    explicit Scraper(const ScraperRegions &region, const ScraperMode mode = ScraperMode::Markup,
+                     const ArtworkSize &artwork = {})
+        : Scraper(to_string(region), mode, artwork) {
     };
 
     [[nodiscard]] std::string identify() override;
 
-    [[nodiscard]] SearchResult searchTrack(const Track &track) override;
+    [[nodiscard]] SearchResult searchTrack(const Track &track,
+                                           const CallContext &context) override;
+
+    /**
+     * Searches as searchTrack() does, handing back every other song the page's payload lists.
+     * A page read from its markup harvests nothing.
+     */
+    [[nodiscard]] SearchHarvest harvestTrack(const Track &track,
+                                             const CallContext &context) override;
+
+    /// Harvests as above on HttpEngine's I/O thread, which reads the page as the transfer ends.
+    void harvestTrackAsync(const Track &track, const CallContext &context,
+                           std::function<void(SearchHarvest)> done) override;
+
+    /**
+     * Reads every song out of a search page's embedded payload, in page order and without
+     * duplicates. The payload is found by a plain substring scan and read as a stream of JSON
+     * events; only the fields of a song are kept, and no tree of the page or the payload is built.
+     * @param page The search page's html.
+     * @return The songs, empty if the page carries no payload or the payload lists none.
+     */
+    [[nodiscard]] static std::vector<ScrapedSong> payloadSongs(std::string_view page);
+
+    /**
+     * Reads a fetched search page into the best match for a track and the other songs listed,
+     * exactly as a search does once the page is in hand.
+     * @param page The search page's html.
+     * @param track Track searched for.
+     * @param mode Where results are read from.
+     * @param artwork Rendition the artwork urls found are rewritten to name.
+     * @return The harvest; failed if the page could not be read at all.
+     */
+    [[nodiscard]] static SearchHarvest parse(std::string_view page, const TrackIdentity &track,
+                                             ScraperMode mode = ScraperMode::Markup,
+                                             const ArtworkSize &artwork = {});
 
 private:
+    /// The search request for a track, or nullptr if one could not be made.
+    [[nodiscard]] std::unique_ptr<CurlWrapper> searchRequest(const Track &track,
+                                                             const CallContext &context) const;
+
+    /// Reads an ended search into its harvest: failed if the search did.
+    [[nodiscard]] static SearchHarvest read(const CurlResult &result, const TrackIdentity &track,
+                                            ScraperMode mode, const ArtworkSize &artwork);
+
     std::string _region;
+    ScraperMode _mode;
+    ArtworkSize _artwork;
     const std::string kIDENTITY = "Apple Music Web Scraper";
 };
\ No newline at end of file
@@ -5,6 +5,9 @@
  */
 
 #pragma once
+#include <functional>
+
+#include "metadata/http/callContext.hpp"
 #include "types/results.hpp"
 #include "types/track.hpp"
 
@@ -12,7 +15,40 @@ class MetadataWebSource {
 public:
     virtual ~MetadataWebSource() = default;
 
-    [[nodiscard]] virtual SearchResult searchTrack(const Track &track) = 0;
+    /**
+     * Searches the source for a track's image and song url.
+     * @param track Track to search for.
+     * @param context What the search may spend; a stop aborts its request in flight.
+     * @return What was found, empty where nothing matched.
+     */
+    [[nodiscard]] virtual SearchResult searchTrack(const Track &track,
+                                                   const CallContext &context) = 0;
+
+    /**
+     * Searches the source for a track as searchTrack() does, and also hands back the other songs
+     * the search turned up, each with what the source offers for it. A source whose search lists
+     * only the one match keeps this default, which harvests nothing.
+     * @param track Track to search for.
+     * @param context What the search may spend; a stop aborts its request in flight.
+     * @return The track's answer, and the songs listed beside it.
+     */
+    [[nodiscard]] virtual SearchHarvest harvestTrack(const Track &track,
+                                                     const CallContext &context) {
+        return SearchHarvest{searchTrack(track, context)};
+    }
+
+    /**
+     * Starts a harvestTrack() and hands over what it turns up, so a caller can have several
+     * searches in flight at once. A source whose search is one request hands it to HttpEngine and
+     * returns at once; one that keeps this default searches on the caller's thread first.
+     * @param track Track to search for.
+     * @param context What the search may spend; a stop aborts its request in flight.
+     * @param done Called once with the harvest, on whichever thread the search ends on.
+     */
+    virtual void harvestTrackAsync(const Track &track, const CallContext &context,
+                                   std::function<void(SearchHarvest)> done) {
+        done(harvestTrack(track, context));
+    }
 
     [[nodiscard]] virtual std::string identify() = 0;
 };
\ No newline at end of file
@@ -0,0 +1,89 @@
+/**
+ * @file upgrader.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+
+#include "metadata/cache.hpp"
+#include "metadata/enricher.hpp"
+
+/// Time between two upgrade attempts. Each may ask every source once, so this keeps the upgrader's
+/// share of the sources' rate budget to a trickle beside what playback asks of them.
+constexpr std::chrono::seconds kUpgradeInterval{30};
+
+/// How long the upgrader rests after walking the whole cache before it starts over.
+constexpr std::chrono::hours kUpgradeRest{6};
+
+/**
+ * How the upgrader paces itself. Defaults to the constants above; tests substitute a tighter one.
+ */
+struct UpgradeSchedule {
+    std::chrono::milliseconds interval = kUpgradeInterval;
+    std::chrono::milliseconds rest = kUpgradeRest;
+};
+
+/**
+ * Walks the cache in the background for images that are a fallback or a loose match, and has the
+ * enricher try each again, one at a time, off the poll loop. Where it finds its place in the
+ * cache is kept in a state row, so a restart carries on rather than starting over.
+ */
+class CacheUpgrader {
+public:
+    /**
+     * Starts the background walk. The first attempt waits out one interval.
+     * @param cache Cache to walk (not owned).
+     * @param enricher Enricher that asks the sources (not owned).
+     * @param schedule How the walk is paced. Defaults to the production schedule.
+     */
+    CacheUpgrader(MetadataCache &cache, const Enricher &enricher,
+                  const UpgradeSchedule &schedule = {});
+
+    /// Stops the walk, cancelling an upgrade in flight, and joins the thread.
+    ~CacheUpgrader();
+
+    CacheUpgrader(const CacheUpgrader &) = delete;
+
+    CacheUpgrader &operator=(const CacheUpgrader &) = delete;
+
+    CacheUpgrader(CacheUpgrader &&) = delete;
+
+    CacheUpgrader &operator=(CacheUpgrader &&) = delete;
+
+    /// Images replaced with a better one since the upgrader started.
+    [[nodiscard]] std::size_t upgraded() const;
+
+private:
+    /**
+     * Upgrades one candidate per interval until a stop is requested.
+     * @param stop Stop token of the upgrader thread.
+     */
+    void walk(const std::stop_token &stop);
+
+    /**
+     * Sleeps for a while, or until a stop is requested.
+     * @return Whether the full time passed.
+     */
+    bool rest(const std::stop_token &stop, std::chrono::milliseconds duration);
+
+    MetadataCache &_cache;
+    const Enricher &_enricher;
+    UpgradeSchedule _schedule{};
+    std::atomic<std::size_t> _upgraded{0};
+
+    std::mutex _mutex{};
+    std::condition_variable_any _wake{};
+
+    /// Declared last, so it is stopped and joined before the members the walk uses go.
+    std::jthread _thread;
+};
@@ -16,7 +16,7 @@ public:
     [[nodiscard]] std::string identify() override;
 
     [[nodiscard]] UploadResult uploadImage(const std::vector<unsigned char> &bytes,
-                                           ImageType type) override;
+                                           ImageType type, const CallContext &context) override;
 
 private:
     std::string _apikey;
@@ -8,6 +8,7 @@
 
 #include <vector>
 
+#include "metadata/http/callContext.hpp"
 #include "types/results.hpp"
 #include "types/track.hpp"
 
@@ -15,8 +16,16 @@ class Uploader {
 public:
     virtual ~Uploader() = default;
 
+    /**
+     * Rehosts raw image bytes.
+     * @param bytes Image to upload.
+     * @param type Kind of image the bytes hold.
+     * @param context What the upload may spend; a stop aborts it in flight.
+     * @return Where the image now lives, empty on failure.
+     */
     [[nodiscard]] virtual UploadResult uploadImage(const std::vector<unsigned char> &bytes,
-                                                   ImageType type) = 0;
+                                                   ImageType type,
+                                                   const CallContext &context) = 0;
 
     [[nodiscard]] virtual std::string identify() = 0;
 };
\ No newline at end of file
@@ -7,20 +7,44 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <vector>
 
 #include "discord/presence.hpp"
 #include "log/log.hpp"
 #include "metadata/enricher.hpp"
 #include "metadata/scrobbler.hpp"
 #include "orchestrator/scrobble_driver.hpp"
+#include "orchestrator/worker.hpp"
 #include "players/poller.hpp"
 
 /// A backwards jump in playback position larger than this counts as a new play of the same track.
 constexpr std::chrono::seconds kRestartThreshold{30};
 
+/// How long a track change waits on its enrichment before publishing what it has. Only the wait is
+/// cut short: the searches still get the whole source deadline, and what they find after goes to
+/// the cache for the next play.
+constexpr std::chrono::seconds kEnrichBudget{3};
+
 class Orchestrator {
 public:
+    Orchestrator() = default;
+
+    /// Retires any enrichment still queued, so shutdown does not wait on its network calls.
+    ~Orchestrator();
+
+    Orchestrator(const Orchestrator &) = delete;
+
+    Orchestrator &operator=(const Orchestrator &) = delete;
+
+    Orchestrator(Orchestrator &&) = delete;
+
+    Orchestrator &operator=(Orchestrator &&) = delete;
+
     /**
      * Registers an enricher the orchestrator drives during the poll loop.
      * @param enricher Unique ptr to the enricher.
@@ -33,6 +57,12 @@ public:
      */
     void registerScrobbler(std::shared_ptr<Scrobbler> scrobbler);
 
+    /**
+     * Registers the journal qualifying plays are kept in until they are scrobbled.
+     * @param journal Unique ptr to the journal.
+     */
+    void registerScrobbleJournal(std::unique_ptr<ScrobbleJournal> journal);
+
     /**
      * Registers a poller the orchestrator drives during the poll loop.
      * @param poller Unique ptr to the poller.
@@ -46,7 +76,16 @@ public:
     void registerRichPresence(std::unique_ptr<Presence> discord);
 
     /**
-     * Performs a cycle of the orchestrator.
+     * Registers a callback run whenever an enrichment lands between cycles, so the poll loop can
+     * run the next cycle early and publish the upgraded presence without waiting out its sleep.
+     * Called on the enrichment thread.
+     * @param wakeup Callback to run.
+     */
+    void registerWakeup(std::function<void()> wakeup);
+
+    /**
+     * Performs a cycle of the orchestrator. A new track is published bare at once and enriched in
+     * the background; the cycle after the enrichment lands publishes it again with its metadata.
      */
     void run();
 
@@ -76,6 +115,30 @@ private:
      */
     void updatePauseDetails();
 
+    /**
+     * Retires the enrichment of the track that was being presented, and starts a new one for the
+     * track now playing.
+     * @param track Track to enrich.
+     * @param thumbnail Raw thumbnail bytes from the poller, if any.
+     */
+    void startEnrichment(const Track &track, std::optional<std::vector<unsigned char> > thumbnail);
+
+    /**
+     * Applies every enrichment that has landed since the previous cycle to the current track.
+     */
+    void drainEnrichments();
+
+    /**
+     * An enrichment finished off the poll loop.
+     */
+    struct Enrichment {
+        /// Token of the track it was made for. Once retired, the track has changed since and the
+        /// enrichment describes something no longer being presented.
+        std::stop_token track;
+
+        EnrichedTrack enriched;
+    };
+
     std::shared_ptr<spdlog::logger> _log = logging::get("orchestrator");
 
     std::unique_ptr<Enricher> _enricher = nullptr;
@@ -89,4 +152,17 @@ private:
 
     /// Playback position observed on the previous cycle, used to spot a restart.
     std::chrono::nanoseconds _position{};
+
+    std::function<void()> _wakeup{};
+
+    /// The track being enriched. Retired and replaced whenever the track changes.
+    std::stop_source _enrichment{};
+
+    std::mutex _enrichedMutex{};
+
+    /// Enrichments posted by the worker, waiting to be applied at a later cycle.
+    std::vector<Enrichment> _enriched{};
+
+    /// Runs enrichments off the poll loop.
+    Worker _enrichments{};
 };
\ No newline at end of file
@@ -9,11 +9,14 @@
 #include <chrono>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <set>
 #include <stop_token>
 #include <vector>
 
 #include "log/log.hpp"
 #include "metadata/scrobbler.hpp"
+#include "orchestrator/scrobble_journal.hpp"
 #include "orchestrator/worker.hpp"
 #include "types/track.hpp"
 
@@ -24,7 +27,8 @@ constexpr std::chrono::seconds kScrobbleMinLength{30};
 /// length, whichever comes first — measured against playback position, not wall time.
 constexpr std::chrono::seconds kScrobblePlayCap{240};
 
-/// Wall time between scrobble attempts after one was rejected.
+/// Wall time between scrobble attempts after one was rejected. Also how long a journal replay that
+/// was rejected waits before it is tried again.
 constexpr std::chrono::seconds kScrobbleRetry{30};
 
 /// Times a now-playing update is offered to a scrobbler before the play is given up on.
@@ -74,6 +78,13 @@ public:
      */
     void registerScrobbler(std::shared_ptr<Scrobbler> scrobbler);
 
+    /**
+     * Keeps every qualifying play in a journal until its scrobbler accepts it, and replays the
+     * plays left there by earlier plays, or earlier runs, in batches.
+     * @param journal The journal. Without one, a play not scrobbled while current is lost.
+     */
+    void registerJournal(std::unique_ptr<ScrobbleJournal> journal);
+
     /**
      * Retires every attempt made for the play that just ended and arms the schedule for the next
      * one. Called when the track changes, when it starts over, and when playback stops.
@@ -89,8 +100,9 @@ public:
     void tick(const Track &current);
 
 private:
-    /// The network calls a scrobbler is driven through over the course of one play.
-    enum class Attempt { NowPlaying, Scrobble };
+    /// The network calls a scrobbler is driven through: over the course of one play, and, with a
+    /// journal, for the plays before it.
+    enum class Attempt { NowPlaying, Scrobble, Replay };
 
     /// Where one of those calls stands within the current play.
     enum class Phase {
@@ -115,6 +127,16 @@ private:
         std::shared_ptr<Scrobbler> scrobbler;
         Pending nowPlaying{};
         Pending scrobble{};
+        /// The journal replay. Not tied to a play, so it carries over a reset.
+        Pending replay{};
+        /// Whether the current play has been put in the journal yet.
+        bool journaled = false;
+        /// The current play's journal entry, kept out of replays while the play itself is driving
+        /// its scrobble.
+        std::optional<std::uint64_t> entry{};
+        /// Journal entries whose play's scrobble is with the worker, retired plays' included. Kept
+        /// out of replays until the result is back, so no play is sent twice.
+        std::set<std::uint64_t> carried{};
     };
 
     /**
@@ -133,6 +155,13 @@ private:
         std::size_t target = 0;
         Attempt kind = Attempt::NowPlaying;
         bool accepted = false;
+
+        /// The journal entry a scrobble was made for.
+        std::optional<std::uint64_t> entry{};
+
+        /// Journal entries the call settled: accepted, or ignored for good. They are acknowledged
+        /// as soon as the result is drained, even if the play has been retired by then.
+        std::vector<std::uint64_t> scrobbled{};
     };
 
     /**
@@ -176,6 +205,27 @@ private:
      */
     void driveAttempts(const Track &current);
 
+    /**
+     * Puts the current play in the journal once it qualifies for a scrobble. A play the journal
+     * already holds as scrobbled needs no scrobble.
+     * @param target Target the play is owed to.
+     * @param current Track playing this cycle.
+     */
+    void journalPlay(Target &target, const Track &current);
+
+    /**
+     * Hands the worker the next batch of journaled plays for a target, if it is due and nothing of
+     * the current play's scrobble is in flight.
+     * @param target Index of the target to replay for.
+     */
+    void driveReplay(std::size_t target);
+
+    /**
+     * Applies a replay's result: schedules the next batch, or backs off if it was rejected.
+     * @param result Result to apply.
+     */
+    void applyReplay(const AttemptResult &result);
+
     /**
      * Submits a single attempt to the worker, stamped with the current play.
      * @param target Index of the target to call.
@@ -198,6 +248,11 @@ private:
     /// Results posted by the worker, waiting to be applied at the top of a later cycle.
     std::vector<AttemptResult> _results{};
 
+    /// Stopped on destruction only, so a replay still queued outlives a reset but not the driver.
+    std::stop_source _lifetime{};
+
+    std::unique_ptr<ScrobbleJournal> _journal{};
+
     /// Runs the attempts off the poll loop.
     Worker _worker{};
 };
\ No newline at end of file
@@ -0,0 +1,133 @@
+/**
+ * @file scrobble_journal.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "types/track.hpp"
+
+/// Most plays a scrobbler is handed at once when the journal is replayed (Last.fm's limit for
+/// one track.scrobble request).
+constexpr std::size_t kJournalBatch{50};
+
+/// Acknowledged records the journal carries before it is rewritten without them.
+constexpr std::size_t kJournalCompactAfter{64};
+
+/**
+ * One play recorded for one scrobbler, kept until the scrobbler acknowledges it.
+ */
+struct JournalEntry {
+    std::uint64_t id = 0;
+    /// The scrobbler's identify(), so each scrobbler drains only its own plays.
+    std::string target;
+    TrackIdentity identity;
+    /// When the play began: seconds since the unix epoch.
+    std::int64_t timestamp = 0;
+    std::chrono::milliseconds length{0};
+
+    /**
+     * The play as a track a scrobbler can be handed, however long ago it began.
+     * @return Track whose timing starts at the recorded wall time and runs for its length.
+     */
+    [[nodiscard]] Track track() const;
+};
+
+/**
+ * An append-only file of the plays owed to each scrobbler, so a play that could not be scrobbled
+ * while it was current (offline, or the scrobbler down) is still scrobbled later, across restarts.
+ *
+ * Each record is length-prefixed and checksummed. A play is one record, its acknowledgement
+ * another; what is written is held until sync(), which writes and flushes it to disk in one go.
+ * On open, a torn record at the tail (a crash mid-write) and anything after it is dropped. Once
+ * enough plays are acknowledged the file is rewritten with only the outstanding ones.
+ *
+ * Not thread-safe: the scrobble driver uses it from the poll loop only.
+ */
+class ScrobbleJournal {
+public:
+    /**
+     * Opens the journal at path, creating it if missing, and reads back the plays outstanding.
+     * A journal that cannot be opened is logged and kept in memory for the session. A file there
+     * that is not a journal is never written over: it is renamed aside and a new journal started,
+     * or if it cannot be, the journal is kept in memory.
+     * @param path File the journal is kept in. Empty keeps it in memory only.
+     */
+    explicit ScrobbleJournal(std::filesystem::path path);
+
+    /// Syncs whatever is still held.
+    ~ScrobbleJournal();
+
+    ScrobbleJournal(const ScrobbleJournal &) = delete;
+
+    ScrobbleJournal &operator=(const ScrobbleJournal &) = delete;
+
+    /**
+     * Records a play owed to a scrobbler. A play is known by when it began, so recording the same
+     * play for the same scrobbler twice records it once.
+     * @param target The scrobbler's identify().
+     * @param track Track played.
+     * @return The entry's id, the one already made if the play was recorded before. Nullopt if the
+     * play was recorded before and has since been acknowledged.
+     */
+    std::optional<std::uint64_t> record(const std::string &target, const Track &track);
+
+    /**
+     * Marks entries as scrobbled, so they are never handed out again. Unknown ids are ignored.
+     * @param ids The entries' ids.
+     */
+    void acknowledge(std::span<const std::uint64_t> ids);
+
+    /**
+     * The oldest plays still owed to a scrobbler.
+     * @param target The scrobbler's identify().
+     * @param limit Most entries wanted.
+     * @return Up to limit entries, oldest first.
+     */
+    [[nodiscard]] std::vector<JournalEntry> pending(const std::string &target,
+                                                    std::size_t limit) const;
+
+    /// Plays still owed, across every scrobbler.
+    [[nodiscard]] std::size_t size() const;
+
+    /**
+     * Writes what was recorded and acknowledged since the last sync and flushes it to disk, then
+     * compacts the file if enough of it is acknowledged. Does nothing if nothing is held.
+     */
+    void sync();
+
+private:
+    /// Reads the file back, dropping a torn tail.
+    void load();
+
+    /// Rewrites the file with the outstanding plays only.
+    void compact();
+
+    /// Opens the file for appending, logging on failure.
+    void openForAppend();
+
+    std::filesystem::path _path;
+    std::FILE *_file = nullptr;
+
+    std::uint64_t _nextId = 1;
+    /// Outstanding plays by id, so oldest first.
+    std::map<std::uint64_t, JournalEntry> _pending{};
+    /// Entry ids by (target, timestamp), for every play outstanding or recorded this session.
+    std::map<std::pair<std::string, std::int64_t>, std::uint64_t> _seen{};
+    /// Records in the file that only describe acknowledged plays.
+    std::size_t _dead = 0;
+    /// Encoded records not yet written.
+    std::string _unsynced{};
+};
@@ -12,27 +12,32 @@
 #include <mutex>
 #include <stop_token>
 #include <thread>
+#include <vector>
 
 /**
- * A single background thread that runs submitted jobs in the order they were submitted.
+ * A fixed set of background threads sharing one queue. Jobs start in the order they were
+ * submitted, but run side by side, so they may finish in any order.
  */
-class Worker {
+class WorkerPool {
 public:
-    Worker();
+    /**
+     * @param threads Threads to start, and so the most jobs that ever run at once. At least one.
+     */
+    explicit WorkerPool(std::size_t threads);
 
-    /// Stops the thread and joins it once the queue has drained.
-    ~Worker();
+    /// Stops the threads and joins them once the queue has drained.
+    ~WorkerPool();
 
-    Worker(const Worker &) = delete;
+    WorkerPool(const WorkerPool &) = delete;
 
-    Worker &operator=(const Worker &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
 
-    Worker(Worker &&) = delete;
+    WorkerPool(WorkerPool &&) = delete;
 
-    Worker &operator=(Worker &&) = delete;
+    WorkerPool &operator=(WorkerPool &&) = delete;
 
     /**
-     * Queues a job to run on the worker thread.
+     * Queues a job to run on the next free thread.
      * @param job Work to run. Must not outlive whatever it captures.
      */
     void submit(std::function<void()> job);
@@ -40,7 +45,7 @@ public:
 private:
     /**
      * Runs queued jobs until a stop is requested and the queue has drained.
-     * @param stop Stop token of the worker thread.
+     * @param stop Stop token of the calling thread.
      */
     void drain(const std::stop_token &stop);
 
@@ -48,5 +53,15 @@ private:
     std::condition_variable_any _queued{};
     std::deque<std::function<void()> > _jobs{};
 
-    std::jthread _thread;
+    std::vector<std::jthread> _threads{};
+};
+
+/**
+ * A single background thread that runs submitted jobs in the order they were submitted: a pool
+ * of one, so each job finishes before the next starts.
+ */
+class Worker final : public WorkerPool {
+public:
+    Worker() : WorkerPool(1) {
+    }
 };
\ No newline at end of file
@@ -0,0 +1,66 @@
+/**
+ * @file md5.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/// Length of an MD5 digest as lowercase hex.
+inline constexpr std::size_t kMd5HexLength{32};
+
+/**
+ * Streaming MD5 (RFC 1321), for signing Last.fm requests. Not for anything that needs a secure
+ * hash.
+ *
+ * Input is fed in any number of update() calls and hashes the same as if it were fed in one, so
+ * a signature can be built from its parts without concatenating them first. Nothing is allocated.
+ */
+class Md5 {
+public:
+    /// The digest as lowercase hex, not null-terminated.
+    using Hex = std::array<char, kMd5HexLength>;
+
+    Md5();
+
+    /**
+     * Feeds more input.
+     * @param data Bytes to hash.
+     * @return This, so calls can be chained.
+     */
+    Md5 &update(std::string_view data);
+
+    /**
+     * Finishes the hash. Only the first call is meaningful: the state is spent afterwards.
+     * @return The 16-byte digest.
+     */
+    [[nodiscard]] std::array<std::uint8_t, 16> digest();
+
+    /**
+     * Finishes the hash, as digest(), and writes it as hex.
+     * @return The digest as 32 lowercase hex characters.
+     */
+    [[nodiscard]] Hex hexDigest();
+
+    /**
+     * Hashes one input in one go.
+     * @param data Bytes to hash.
+     * @return The digest as 32 lowercase hex characters.
+     */
+    [[nodiscard]] static Hex hex(std::string_view data);
+
+private:
+    /// Runs the compression function over one 64-byte block.
+    void transform(const std::uint8_t *block);
+
+    std::array<std::uint32_t, 4> _state;
+    /// Input bytes fed so far.
+    std::uint64_t _length = 0;
+    /// The tail of the input that does not fill a block yet.
+    std::array<std::uint8_t, 64> _buffer{};
+};
@@ -6,6 +6,7 @@
 
 #pragma once
 #include <string>
+#include <vector>
 
 #include "types/track.hpp"
 
@@ -14,15 +15,45 @@ public:
     std::string image_url;
     std::string web_url;
     ImageType image_type = Static;
+    /// How closely the match fit the track, 0-100; see matchScore().
+    std::uint8_t confidence = 100;
+    /// The source could not be asked (transport, HTTP or parse failure), as opposed to having
+    /// been asked and matched nothing.
+    bool failed = false;
 
     friend auto operator<=>(const SearchResult &, const SearchResult &) = default;
 };
 
 std::ostream &operator<<(std::ostream &os, const SearchResult &result);
 
+/**
+ * A song a search turned up beside the one searched for, and what the source offers for it.
+ */
+class HarvestedSong {
+public:
+    TrackIdentity identity;
+    SearchResult result;
+
+    friend bool operator==(const HarvestedSong &, const HarvestedSong &) = default;
+};
+
+/**
+ * Everything one search turned up: the answer for the track searched for, and the other songs
+ * the source listed beside it.
+ */
+class SearchHarvest {
+public:
+    SearchResult result;
+    std::vector<HarvestedSong> others;
+
+    friend bool operator==(const SearchHarvest &, const SearchHarvest &) = default;
+};
+
 class UploadResult {
 public:
     std::string image_url;
+    /// The upload did not go through, as opposed to the host accepting it without a link.
+    bool failed = false;
 
     friend auto operator<=>(const UploadResult &, const UploadResult &) = default;
 };
@@ -134,11 +134,40 @@ struct fmt::formatter<ImageType> : ostream_formatter {
 
 std::ostream &operator<<(std::ostream &os, const ImageType &type);
 
+/**
+ * How far an image can be trusted to picture its track. Stored with every cached image: append
+ * new values to the end, and never reorder or remove one.
+ */
+enum class ImageQuality : std::uint8_t {
+    Matched = 0, ///< A source matched the track closely.
+    LowConfidence = 1, ///< A source matched the track, but only loosely.
+    Fallback = 2, ///< The player's own thumbnail, rehosted because no source had an image.
+    Harvested = 3, ///< Listed by a source beside a song it was asked for, and never asked for.
+};
+
+[[nodiscard]] constexpr std::string to_string(const ImageQuality &quality) {
+    switch (quality) {
+    case ImageQuality::Matched:
+        return "Matched";
+    case ImageQuality::LowConfidence:
+        return "LowConfidence";
+    case ImageQuality::Fallback:
+        return "Fallback";
+    case ImageQuality::Harvested:
+        return "Harvested";
+    default:
+        return "Unknown";
+    }
+}
+
 class ImageUrl {
 public:
     std::string url;
     ImageType type = Static;
     std::string source;
+    ImageQuality quality = ImageQuality::Matched;
+    /// How closely the source's match fit the track, 0-100. Zero for a fallback.
+    std::uint8_t confidence = 100;
 
     friend auto operator<=>(const ImageUrl &, const ImageUrl &) = default;
 };
@@ -23,7 +23,8 @@ constexpr discordpp::LoggingSeverity defaultLevel() {
 
 }
 
-RichPresence::RichPresence(const uint64_t &apikey) {
+RichPresence::RichPresence(const uint64_t &apikey, const ArtworkSize &artwork)
+    : _artwork(artwork) {
     DiscordRefresher::initialize();
     _client->AddLogCallback([](auto message, const auto &severity) {
         const auto &logger = logging::get("discord");
@@ -178,13 +179,15 @@ void setTimeline(discordpp::Activity &activity, const Track &track, const PauseD
  * enriched track. No-op when no image was found.
  * @param activity Discord activity object.
  * @param track Enriched track details.
+ * @param artwork Rendition Apple artwork is shown at.
  */
-void setAssets(discordpp::Activity &activity, const EnrichedTrack &track) {
+void setAssets(discordpp::Activity &activity, const EnrichedTrack &track,
+               const ArtworkSize &artwork) {
     discordpp::ActivityAssets assets;
     if (track.image.url.empty()) {
         assets.SetLargeImage("default");
     } else {
-        assets.SetLargeImage(track.image.url);
+        assets.SetLargeImage(resizeArtwork(track.image.url, artwork));
     }
     if (!track.track.identity.album.empty()) {
         assets.SetLargeText(discordStringBounds(track.track.identity.album));
@@ -226,7 +229,7 @@ void RichPresence::setPresence(const EnrichedTrack &track) const {
     discordpp::Activity activity;
     setIdentity(activity, track.track);
     setTimeline(activity, track.track, track.pause);
-    setAssets(activity, track);
+    setAssets(activity, track, _artwork);
     setButtons(activity, track);
 
     _client->UpdateRichPresence(activity, [](const discordpp::ClientResult &result) {
@@ -8,12 +8,16 @@
 #include "players/amwin.hpp"
 #include "metadata/cache.hpp"
 #include "metadata/enricher.hpp"
+#include "metadata/upgrader.hpp"
 #include "metadata/sources/lastfm.hpp"
+#include "metadata/sources/multiregion.hpp"
 #include "metadata/sources/scraper.hpp"
 #include "metadata/uploaders/imgur.hpp"
 #include "log/log.hpp"
 #include "orchestrator/orchestrator.hpp"
+#include "orchestrator/scrobble_journal.hpp"
 #include "system/notifications.hpp"
+#include "system/paths.hpp"
 
 #include <csignal>
 #include <future>
@@ -33,6 +37,8 @@ namespace {
 std::atomic running{true};
 std::mutex sleep_mutex;
 std::condition_variable sleep_cv;
+/// Set when an enrichment lands mid-sleep, so the poll loop publishes it without waiting.
+bool wake_early = false;
 
 std::shared_ptr<Tray> g_tray = nullptr;
 std::mutex g_tray_mutex;
@@ -130,8 +136,12 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
     MetadataCache cache;
     Orchestrator orchestrator{};
 
-    auto enricher = std::make_unique<Enricher>(cache);
-    enricher->registerSource(std::make_shared<Scraper>("ca"));
+    auto enricher = std::make_unique<Enricher>(
+        cache, EnrichSchedule{.hedged = true, .adaptiveOrder = true});
+    enricher->registerSource(std::make_shared<MultiRegionScraper>(
+        cache, RegionPlan{}, [](const ScraperRegions region) {
+            return std::make_shared<Scraper>(region);
+        }));
     if (std::string imgurId = apiKey("IMGUR_KEY"); !imgurId.empty()) {
         enricher->registerUploader(std::make_unique<Imgur>(imgurId));
     }
@@ -144,9 +154,20 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
         }
         enricher->registerSource(lastfm);
         orchestrator.registerScrobbler(std::move(lastfm));
+        orchestrator.registerScrobbleJournal(
+            std::make_unique<ScrobbleJournal>(appDataDir() / "scrobbles.journal"));
     }
 
+    // The orchestrator owns the enricher from here on; the upgrader is torn down before it.
+    const Enricher &upgrades = *enricher;
     orchestrator.registerEnricher(std::move(enricher));
+    CacheUpgrader upgrader(cache, upgrades);
+    orchestrator.registerWakeup([] { {
+            std::lock_guard lock(sleep_mutex);
+            wake_early = true;
+        }
+        sleep_cv.notify_all();
+    });
 
     auto discord = std::make_unique<RichPresence>(1358389458956976128);
     orchestrator.registerRichPresence(std::move(discord));
@@ -193,8 +214,9 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
             const EnrichedTrack playing = orchestrator.nowPlaying();
             tray->setTooltip(playing);
 
-            // make sure toasts work
-            if (curr != playing) {
+            // make sure toasts work. Compared by identity alone, so the presence being upgraded
+            // once its enrichment lands does not announce the same track twice.
+            if (curr.track.identity != playing.track.identity) {
                 curr = playing;
                 if (const auto &id = curr.track.identity; id.title.empty()) {
                     showToastNotification("MusicPP", "Nothing playing");
@@ -207,7 +229,9 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
             }
 
             std::unique_lock lock(*sleep_mut);
-            sleep_cond->wait_for(lock, std::chrono::seconds(5), [&] { return !running.load(); });
+            sleep_cond->wait_for(lock, std::chrono::seconds(5),
+                                 [&] { return !running.load() || wake_early; });
+            wake_early = false;
         }
     });
 
@@ -6,7 +6,9 @@
 
 #include "metadata/cache.hpp"
 #include "metadata/cache_codec.hpp"
+#include <algorithm>
 #include <filesystem>
+#include <memory>
 #include "system/paths.hpp"
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
@@ -19,6 +21,42 @@ std::filesystem::path defaultDbPath() {
     return appDataDir() / "song_db";
 }
 
+/**
+ * Assembles a cache entry from a track's raw rows.
+ * @param track Track the rows were looked up for.
+ * @param rawImage Raw image row, if one was stored.
+ * @param rawUrls Raw song-url row, if one was stored.
+ * @param now Instant the image's freshness is judged against.
+ * @return The entry, or nullopt if neither row holds anything usable.
+ */
+std::optional<EnrichedTrack> assembleEntry(const Track &track,
+                                           const std::optional<std::string> &rawImage,
+                                           const std::optional<std::string> &rawUrls,
+                                           const std::chrono::sys_seconds now) {
+    // An image is usable only if it parses and is still within its TTL. An expired image is
+    // withheld as though it were absent to force a refresh.
+    std::optional<ImageUrl> image;
+    if (rawImage) {
+        if (const auto cached = cache_codec::parseImageValue(*rawImage);
+            cached && cache_codec::isFresh(cached->written_at, now)) {
+            image = cached->image;
+        }
+    }
+
+    if (!image && !rawUrls)
+        return std::nullopt;
+
+    EnrichedTrack out;
+    out.track = track;
+    if (image) {
+        out.image = *image;
+    }
+    if (rawUrls) {
+        out.songUrls = cache_codec::parseUrlValue(*rawUrls);
+    }
+    return out;
+}
+
 }
 
 using namespace cache_codec;
@@ -106,32 +144,155 @@ void MetadataCache::writeEntry(const EnrichedTrack &track) const {
     }
 }
 
-std::optional<EnrichedTrack> MetadataCache::findEntry(const Track &track) const {
-    std::string rawImage;
-    std::string rawUrls;
-    const bool hasImage = _db->Get(leveldb::ReadOptions(), imageKey(track), &rawImage).ok();
-    const bool hasUrls = _db->Get(leveldb::ReadOptions(), urlKey(track), &rawUrls).ok();
+std::size_t MetadataCache::writeHarvest(const std::span<const EnrichedTrack> tracks) const {
+    leveldb::WriteBatch batch;
+    std::size_t written = 0;
+    const auto now = nowSeconds();
 
-    // An image is usable only if it parses and is still within its TTL. An expired image is
-    // withheld as though it were absent to force a refresh.
-    std::optional<ImageUrl> image;
-    if (hasImage) {
-        if (const auto cached = parseImageValue(rawImage);
-            cached && isFresh(cached->written_at, nowSeconds())) {
-            image = cached->image;
+    for (const auto &track : tracks) {
+        bool hasWrite = false;
+        if (!track.image.url.empty()) {
+            std::string raw;
+            const auto cached = _db->Get(leveldb::ReadOptions(), imageKey(track.track), &raw).ok()
+                                    ? parseImageValue(raw)
+                                    : std::nullopt;
+            if (!cached || !isFresh(cached->written_at, now)) {
+                batch.Put(imageKey(track.track), createImageValue(track.image, now));
+                hasWrite = true;
+            }
+        }
+
+        if (!track.songUrls.empty()) {
+            std::vector<SongUrl> existing;
+            if (std::string raw; _db->Get(leveldb::ReadOptions(), urlKey(track.track), &raw).ok()) {
+                existing = parseUrlValue(raw);
+            }
+            std::vector<SongUrl> missing;
+            for (const auto &songUrl : track.songUrls) {
+                if (std::ranges::none_of(existing, [&songUrl](const SongUrl &e) {
+                    return e.source == songUrl.source;
+                })) {
+                    missing.push_back(songUrl);
+                }
+            }
+            if (!missing.empty()) {
+                batch.Put(urlKey(track.track),
+                          createUrlValue(mergeSongUrls(std::move(existing), missing)));
+                hasWrite = true;
+            }
         }
+        written += hasWrite;
     }
 
-    if (!image && !hasUrls)
-        return std::nullopt;
+    if (written > 0) {
+        _db->Write(leveldb::WriteOptions(), &batch);
+    }
+    return written;
+}
 
-    EnrichedTrack out;
-    out.track = track;
-    if (image) {
-        out.image = *image;
+std::optional<EnrichedTrack> MetadataCache::findEntry(const Track &track) const {
+    std::optional<std::string> rawImage;
+    std::optional<std::string> rawUrls;
+    if (std::string raw; _db->Get(leveldb::ReadOptions(), imageKey(track), &raw).ok()) {
+        rawImage = std::move(raw);
+    }
+    if (std::string raw; _db->Get(leveldb::ReadOptions(), urlKey(track), &raw).ok()) {
+        rawUrls = std::move(raw);
+    }
+    return assembleEntry(track, rawImage, rawUrls, nowSeconds());
+}
+
+std::vector<std::optional<EnrichedTrack> > MetadataCache::findEntries(
+    const std::span<const Track> tracks) const {
+    /// One key to resolve, and where its row belongs in the batch.
+    struct Lookup {
+        std::string key;
+        std::size_t index;
+        bool image;
+    };
+
+    std::vector<Lookup> lookups;
+    lookups.reserve(tracks.size() * 2);
+    for (std::size_t i = 0; i < tracks.size(); ++i) {
+        lookups.push_back({imageKey(tracks[i]), i, true});
+        lookups.push_back({urlKey(tracks[i]), i, false});
     }
-    if (hasUrls) {
-        out.songUrls = parseUrlValue(rawUrls);
+    std::ranges::sort(lookups, {}, &Lookup::key);
+
+    std::vector<std::optional<std::string> > rawImages(tracks.size());
+    std::vector<std::optional<std::string> > rawUrls(tracks.size());
+
+    // Every lookup reads the same snapshot, so a write landing mid-batch cannot leave a track with
+    // its image from before the write and its urls from after it.
+    // Released on the way out however the lookups end, and after the iterator reading it.
+    const auto release = [this](const leveldb::Snapshot *snapshot) {
+        _db->ReleaseSnapshot(snapshot);
+    };
+    const std::unique_ptr<const leveldb::Snapshot, decltype(release)> snapshot(
+        _db->GetSnapshot(), release);
+    leveldb::ReadOptions options;
+    options.snapshot = snapshot.get();
+    const std::unique_ptr<leveldb::Iterator> it(_db->NewIterator(options));
+    for (const auto &[key, index, image] : lookups) {
+        // The keys are sorted, so the iterator only ever moves forward: it is re-seeked only once
+        // it has fallen behind the key wanted, and a run of misses costs no extra seeks.
+        if (!it->Valid() || it->key().compare(key) < 0) {
+            it->Seek(key);
+        }
+        if (!it->Valid()) {
+            break; // Past the last row, so every key still to come is a miss.
+        }
+        if (it->key() == leveldb::Slice(key)) {
+            (image ? rawImages : rawUrls)[index] = it->value().ToString();
+        }
+    }
+
+    const auto now = nowSeconds();
+    std::vector<std::optional<EnrichedTrack> > out;
+    out.reserve(tracks.size());
+    for (std::size_t i = 0; i < tracks.size(); ++i) {
+        out.push_back(assembleEntry(tracks[i], rawImages[i], rawUrls[i], now));
     }
     return out;
 }
+
+std::vector<UpgradeCandidate> MetadataCache::findUpgradeable(const std::string_view after,
+                                                             const std::size_t limit) const {
+    const leveldb::Slice prefix("img|");
+    const std::string resume = prefix.ToString() + std::string(after);
+    const auto now = nowSeconds();
+
+    std::vector<UpgradeCandidate> out;
+    const std::unique_ptr<leveldb::Iterator> it(_db->NewIterator(leveldb::ReadOptions()));
+    for (it->Seek(resume); it->Valid() && it->key().starts_with(prefix) && out.size() < limit;
+         it->Next()) {
+        if (!after.empty() && it->key() == leveldb::Slice(resume)) {
+            continue;
+        }
+        const auto cached = parseImageValue(it->value().ToString());
+        if (!cached || !isFresh(cached->written_at, now) ||
+            cached->image.quality == ImageQuality::Matched) {
+            continue;
+        }
+        auto key = it->key();
+        key.remove_prefix(prefix.size());
+        if (auto identity = parseTrackKey(std::string_view(key.data(), key.size()))) {
+            UpgradeCandidate candidate;
+            candidate.track.identity = std::move(*identity);
+            candidate.image = cached->image;
+            out.push_back(std::move(candidate));
+        }
+    }
+    return out;
+}
+
+std::optional<std::string> MetadataCache::readState(const std::string_view name) const {
+    if (std::string raw; _db->Get(leveldb::ReadOptions(), stateKey(name), &raw).ok()) {
+        return raw;
+    }
+    return std::nullopt;
+}
+
+void MetadataCache::writeState(const std::string_view name, const std::string_view value) const {
+    _db->Put(leveldb::WriteOptions(), stateKey(name), leveldb::Slice(value.data(), value.size()));
+}
@@ -44,11 +44,95 @@ bool readBytes(const std::string &buf, size_t &offset, const uint32_t len, std::
     return true;
 }
 
+void putVarint(std::string &buf, uint32_t value) {
+    while (value >= 0x80) {
+        buf.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buf.push_back(static_cast<char>(value));
+}
+
+bool readVarint(const std::string &buf, size_t &offset, uint32_t &out) {
+    out = 0;
+    // Five groups of seven bits cover a u32; a longer run is corrupt, not a bigger number.
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (offset >= buf.size())
+            return false;
+        const auto byte = static_cast<uint8_t>(buf[offset++]);
+        out |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+/// Set on the type byte of an image value followed by its quality and confidence bytes.
+constexpr uint8_t kGradedImageFlag = 0x80;
+
+/**
+ * Marks a versioned url value. An unversioned value opens with its u32 entry count instead, low
+ * byte first, which is only 0xFF for 255 entries or more. Entries are kept per distinct
+ * (url, source) pair, so nothing bounds the count as such, but no build that wrote unversioned
+ * values ever held more than a few links per track: 0xFF only ever opens a versioned value.
+ */
+constexpr char kUrlValueTag = static_cast<char>(0xFF);
+constexpr uint8_t kUrlValueVersion = 2;
+
+/**
+ * Finds the id of an interned string.
+ * @return The id, or 0 if the string is not in the table.
+ */
+template <size_t N>
+uint32_t internedId(const std::array<std::string_view, N> &table, const std::string_view value) {
+    const auto it = std::ranges::find(table, value);
+    return it == table.end() ? 0 : static_cast<uint32_t>(it - table.begin()) + 1;
+}
+
+/**
+ * Finds the id of the longest table prefix a url starts with.
+ * @return The id, or 0 if no prefix matches.
+ */
+uint32_t longestPrefixId(const std::string_view url) {
+    uint32_t best = 0;
+    size_t bestLength = 0;
+    for (size_t i = 0; i < cache_codec::kUrlPrefixes.size(); ++i) {
+        if (const auto prefix = cache_codec::kUrlPrefixes[i];
+            prefix.size() > bestLength && url.starts_with(prefix)) {
+            best = static_cast<uint32_t>(i) + 1;
+            bestLength = prefix.size();
+        }
+    }
+    return best;
+}
+
+std::vector<SongUrl> parseLegacyUrlValue(const std::string &raw) {
+    std::vector<SongUrl> urls;
+    size_t offset = 0;
+    uint32_t count = 0;
+    if (!readU32(raw, offset, count))
+        return urls;
+    urls.reserve(std::min<size_t>(count, raw.size()));
+    for (uint32_t i = 0; i < count; ++i) {
+        SongUrl songUrl;
+        if (uint32_t sourceLen = 0; !readU32(raw, offset, sourceLen) || !readBytes(
+                                        raw, offset, sourceLen, songUrl.source))
+            break;
+        if (uint32_t urlLen = 0; !readU32(raw, offset, urlLen) || !readBytes(
+                                     raw, offset, urlLen, songUrl.url))
+            break;
+        urls.push_back(std::move(songUrl));
+    }
+    return urls;
+}
+
+}
+
+namespace cache_codec {
 void putI64(std::string &buf, const int64_t value) {
     buf.append(reinterpret_cast<const char *>(&value), sizeof(value));
 }
 
-bool readI64(const std::string &buf, size_t &offset, int64_t &out) {
+bool readI64(const std::string_view buf, size_t &offset, int64_t &out) {
     if (offset + sizeof(int64_t) > buf.size())
         return false;
     std::memcpy(&out, buf.data() + offset, sizeof(int64_t));
@@ -56,9 +140,6 @@ bool readI64(const std::string &buf, size_t &offset, int64_t &out) {
     return true;
 }
 
-}
-
-namespace cache_codec {
 std::chrono::sys_seconds nowSeconds() {
     return std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
 }
@@ -67,6 +148,25 @@ bool isFresh(const std::chrono::sys_seconds written_at, const std::chrono::sys_s
     return now - written_at < kImageTtl;
 }
 
+std::string trackKey(const Track &track) {
+    return getKey(track);
+}
+
+std::optional<TrackIdentity> parseTrackKey(const std::string_view key) {
+    const auto first = key.find('|');
+    if (first == std::string_view::npos)
+        return std::nullopt;
+    const auto second = key.find('|', first + 1);
+    if (second == std::string_view::npos || key.find('|', second + 1) != std::string_view::npos)
+        return std::nullopt;
+
+    TrackIdentity identity;
+    identity.title = key.substr(0, first);
+    identity.artist = key.substr(first + 1, second - first - 1);
+    identity.album = key.substr(second + 1);
+    return identity;
+}
+
 std::string imageKey(const Track &track) {
     return "img|" + getKey(track);
 }
@@ -75,10 +175,16 @@ std::string urlKey(const Track &track) {
     return "url|" + getKey(track);
 }
 
+std::string stateKey(const std::string_view name) {
+    return "st|" + std::string(name);
+}
+
 std::string createImageValue(const ImageUrl &image, const std::chrono::sys_seconds written_at) {
     std::string val;
     putI64(val, written_at.time_since_epoch().count());
-    val.push_back(static_cast<char>(image.type));
+    val.push_back(static_cast<char>(image.type | kGradedImageFlag));
+    val.push_back(static_cast<char>(image.quality));
+    val.push_back(static_cast<char>(image.confidence));
     putU32(val, static_cast<uint32_t>(image.source.size()));
     val += image.source;
     val += image.url;
@@ -96,13 +202,25 @@ std::optional<CachedImage> parseImageValue(const std::string &raw) {
 
     if (offset >= raw.size())
         return std::nullopt;
-    cached.image.type = static_cast<ImageType>(static_cast<uint8_t>(raw[offset++]));
+    const auto type = static_cast<uint8_t>(raw[offset++]);
+    cached.image.type = static_cast<ImageType>(type & ~kGradedImageFlag);
+    const bool graded = (type & kGradedImageFlag) != 0;
+    if (graded) {
+        if (raw.size() - offset < 2)
+            return std::nullopt;
+        cached.image.quality = static_cast<ImageQuality>(static_cast<uint8_t>(raw[offset++]));
+        cached.image.confidence = static_cast<uint8_t>(raw[offset++]);
+    }
 
     uint32_t sourceLen = 0;
     if (!readU32(raw, offset, sourceLen))
         return std::nullopt;
     if (!readBytes(raw, offset, sourceLen, cached.image.source))
         return std::nullopt;
+    if (!graded && cached.image.source == kImgurSource) {
+        cached.image.quality = ImageQuality::Fallback;
+        cached.image.confidence = 0;
+    }
 
     cached.image.url = raw.substr(offset);
     return cached;
@@ -110,12 +228,21 @@ std::optional<CachedImage> parseImageValue(const std::string &raw) {
 
 std::string createUrlValue(const std::vector<SongUrl> &urls) {
     std::string val;
-    putU32(val, static_cast<uint32_t>(urls.size()));
+    val.push_back(kUrlValueTag);
+    val.push_back(static_cast<char>(kUrlValueVersion));
+    putVarint(val, static_cast<uint32_t>(urls.size()));
     for (const auto &[url, source] : urls) {
-        putU32(val, static_cast<uint32_t>(source.size()));
-        val += source;
-        putU32(val, static_cast<uint32_t>(url.size()));
-        val += url;
+        const uint32_t sourceId = internedId(kInternedSources, source);
+        putVarint(val, sourceId);
+        if (sourceId == 0) {
+            putVarint(val, static_cast<uint32_t>(source.size()));
+            val += source;
+        }
+        const uint32_t prefixId = longestPrefixId(url);
+        const size_t prefixLength = prefixId == 0 ? 0 : kUrlPrefixes[prefixId - 1].size();
+        putVarint(val, prefixId);
+        putVarint(val, static_cast<uint32_t>(url.size() - prefixLength));
+        val.append(url, prefixLength);
     }
     return val;
 }
@@ -124,19 +251,42 @@ std::vector<SongUrl> parseUrlValue(const std::string &raw) {
     std::vector<SongUrl> urls;
     if (raw.empty())
         return urls;
-    size_t offset = 0;
+    if (raw[0] != kUrlValueTag)
+        return parseLegacyUrlValue(raw);
+
+    // A version this build does not know cannot be read safely, so it reads as malformed.
+    if (raw.size() < 2 || static_cast<uint8_t>(raw[1]) != kUrlValueVersion)
+        return urls;
+    size_t offset = 2;
     uint32_t count = 0;
-    if (!readU32(raw, offset, count))
+    if (!readVarint(raw, offset, count))
         return urls;
-    urls.reserve(count);
+    // Every entry takes at least three bytes, so a count past that is corrupt and not reserved.
+    urls.reserve(std::min<size_t>(count, raw.size() / 3));
     for (uint32_t i = 0; i < count; ++i) {
         SongUrl songUrl;
-        if (uint32_t sourceLen = 0; !readU32(raw, offset, sourceLen) || !readBytes(
-                                        raw, offset, sourceLen, songUrl.source))
+        uint32_t sourceId = 0;
+        if (!readVarint(raw, offset, sourceId) || sourceId > kInternedSources.size())
             break;
-        if (uint32_t urlLen = 0; !readU32(raw, offset, urlLen) || !readBytes(
-                                     raw, offset, urlLen, songUrl.url))
+        if (sourceId == 0) {
+            if (uint32_t sourceLen = 0; !readVarint(raw, offset, sourceLen) || !readBytes(
+                                            raw, offset, sourceLen, songUrl.source))
+                break;
+        } else {
+            songUrl.source = kInternedSources[sourceId - 1];
+        }
+
+        uint32_t prefixId = 0;
+        std::string rest;
+        if (!readVarint(raw, offset, prefixId) || prefixId > kUrlPrefixes.size())
             break;
+        if (uint32_t restLen = 0; !readVarint(raw, offset, restLen) || !readBytes(
+                                      raw, offset, restLen, rest))
+            break;
+        if (prefixId != 0) {
+            songUrl.url = kUrlPrefixes[prefixId - 1];
+        }
+        songUrl.url += rest;
         urls.push_back(std::move(songUrl));
     }
     return urls;
@@ -5,12 +5,123 @@
  */
 
 #include "metadata/enricher.hpp"
+#include "metadata/cache_codec.hpp"
+#include "metadata/matching.hpp"
+#include "log/log.hpp"
 
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <set>
 #include <string>
 #include <utility>
 
-Enricher::Enricher(MetadataCache &cache) : _cache(cache) {
+namespace {
+/**
+ * Collects the identify() names of a list of contenders, in registration order.
+ */
+template<typename Contenders>
+std::vector<std::string> namesOf(const Contenders &contenders) {
+    std::vector<std::string> names;
+    names.reserve(contenders.size());
+    for (const auto &contender : contenders) {
+        names.push_back(contender->identify());
+    }
+    return names;
+}
+
+Outcome outcomeOf(const SearchResult &result) {
+    if (result.failed)
+        return Outcome::Failed;
+    return result.image_url.empty() && result.web_url.empty() ? Outcome::Miss : Outcome::Hit;
+}
+
+Outcome outcomeOf(const UploadResult &result) {
+    if (result.failed)
+        return Outcome::Failed;
+    return result.image_url.empty() ? Outcome::Miss : Outcome::Hit;
+}
+
+/**
+ * The image an answer offers, graded by how it was found.
+ * @param uploaded Whether the answer came from an uploader, rehosting the player's thumbnail.
+ */
+ImageUrl pictureOf(const SearchResult &answer, const std::string &platform, const bool uploaded) {
+    ImageUrl image{answer.image_url, answer.image_type, platform};
+    if (uploaded) {
+        image.quality = ImageQuality::Fallback;
+        image.confidence = 0;
+    } else {
+        image.quality = answer.confidence >= kConfidentMatch
+                            ? ImageQuality::Matched
+                            : ImageQuality::LowConfidence;
+        image.confidence = answer.confidence;
+    }
+    return image;
+}
+
+/**
+ * Where a quality stands, lower being better. A harvested image was listed for exactly its track,
+ * so it stands above a loose match, but below a source asked for the track itself.
+ */
+int standing(const ImageQuality quality) {
+    switch (quality) {
+    case ImageQuality::Matched:
+        return 0;
+    case ImageQuality::Harvested:
+        return 1;
+    case ImageQuality::LowConfidence:
+        return 2;
+    case ImageQuality::Fallback:
+    default:
+        return 3;
+    }
+}
+
+/**
+ * Whether one image pictures its track better than another: a better quality, or an equally
+ * graded but closer match.
+ */
+bool outranks(const ImageUrl &a, const ImageUrl &b) {
+    if (a.quality != b.quality)
+        return standing(a.quality) < standing(b.quality);
+    return a.confidence > b.confidence;
+}
+
+std::chrono::milliseconds since(const std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+}
+
+/**
+ * The context an enrichment's calls run under. They are given the whole source deadline even when
+ * the caller stops waiting sooner, so an answer that comes late can still reach the cache.
+ * @param start When the enrichment started.
+ * @param deadline When its caller needs an answer by; time_point::max() for no deadline.
+ * @param sourceDeadline The schedule's source deadline.
+ * @param priority The schedule's priority.
+ */
+CallContext callContext(const std::chrono::steady_clock::time_point start,
+                        const std::chrono::steady_clock::time_point deadline,
+                        const std::chrono::milliseconds sourceDeadline,
+                        const CallPriority priority) {
+    if (deadline == std::chrono::steady_clock::time_point::max()) {
+        // Bound by the request timeout alone, as without a deadline.
+        return CallContext{.priority = priority};
+    }
+    return CallContext{.deadline = std::max(deadline, start + sourceDeadline),
+                       .priority = priority};
+}
+}
+
+Enricher::Enricher(MetadataCache &cache, const EnrichSchedule &schedule)
+    : _cache(cache), _schedule(schedule), _health(cache), _pool(schedule.sourceThreads) {
+}
+
+std::vector<HealthSnapshot> Enricher::health() const {
+    return _health.snapshot();
 }
 
 void Enricher::registerSource(std::shared_ptr<MetadataWebSource> source) {
@@ -21,8 +132,61 @@ void Enricher::registerUploader(std::unique_ptr<Uploader> uploader) {
     _uploaders.push_back(std::move(uploader));
 }
 
+struct Enricher::Lane {
+    std::string platform;
+    /// Whether the platform's link is still wanted. Never for an uploader.
+    bool needLink;
+    bool upload;
+    /// An uploader's answer is carried as a SearchResult with no link.
+    std::function<SearchResult(const CallContext &)> call;
+    std::stop_source stop{};
+    bool launched = false;
+    bool settled = false;
+};
+
+struct Enricher::Race {
+    std::mutex mutex;
+    std::condition_variable answered;
+    std::vector<std::optional<SearchResult> > answers;
+    /// Set once the enrichment has stopped waiting. Shared with the jobs, so one that answers
+    /// after that still has somewhere to land.
+    bool abandoned = false;
+    /// Whether the enrichment stopped waiting without an image.
+    bool needImage = false;
+};
+
 EnrichedTrack Enricher::enrich(const Track &track,
                                const std::optional<std::vector<unsigned char> > &thumbnail) const {
+    return enrich(track, thumbnail, std::chrono::steady_clock::time_point::max());
+}
+
+EnrichedTrack Enricher::enrich(const Track &track,
+                               const std::optional<std::vector<unsigned char> > &thumbnail,
+                               const std::chrono::steady_clock::time_point deadline) const {
+    using Clock = std::chrono::steady_clock;
+    const auto until = deadline == Clock::time_point::max() ? std::nullopt
+                                                            : std::optional(deadline);
+    auto joined = _enrichments.run(cache_codec::trackKey(track), [&] {
+        return lookup(track, thumbnail, deadline);
+    }, until);
+    EnrichedTrack out;
+    if (joined) {
+        out = std::move(*joined);
+    } else if (const auto cached = _cache.findEntry(track)) {
+        // Joined an enrichment started with more time to spare, and ran out of its own waiting
+        // on it: what was already cached is all there is by this deadline.
+        out.image = cached->image;
+        out.songUrls = cached->songUrls;
+    }
+    // A joined enrichment was started for another caller's copy of the track, whose status and
+    // position may differ from this one's.
+    out.track = track;
+    return out;
+}
+
+EnrichedTrack Enricher::lookup(const Track &track,
+                               const std::optional<std::vector<unsigned char> > &thumbnail,
+                               const std::chrono::steady_clock::time_point deadline) const {
     EnrichedTrack out;
     out.track = track;
 
@@ -32,50 +196,437 @@ EnrichedTrack Enricher::enrich(const Track &track,
         out.songUrls = cached->songUrls;
     }
 
-    bool needImage = out.image.url.empty();
+    if (_schedule.hedged
+            ? raceForImage(out, thumbnail, deadline)
+            : searchAll(out, thumbnail, deadline)) {
+        _cache.writeEntry(out);
+    }
+    return out;
+}
+
+std::vector<Enricher::Lane> Enricher::contenders(
+    const EnrichedTrack &out, const std::optional<std::vector<unsigned char> > &thumbnail) const {
+    const Track &track = out.track;
     std::set<std::string> ownedPlatforms;
     for (const auto &[url, source] : out.songUrls) {
         ownedPlatforms.insert(source);
     }
+    const bool needImage = out.image.url.empty();
 
-    bool changed = false;
-
-    // Check sources first
-    for (const auto &source : _sources) {
-        const std::string platform = source->identify();
+    std::vector<Lane> lanes;
+    for (const auto index : rank(namesOf(_sources))) {
+        const auto &source = _sources[index];
+        std::string platform = source->identify();
         const bool needLink = !ownedPlatforms.contains(platform);
         if (!needImage && !needLink) {
             continue; // nothing to gain from this source
         }
+        lanes.push_back(Lane{platform, needLink, false,
+                             [this, source, platform, track](const CallContext &context) {
+                                 return ask(*source, platform, track, context);
+                             }});
+    }
+    if (needImage && thumbnail.has_value()) {
+        // Shared rather than copied per lane; an upload may outlive the enrichment.
+        const auto bytes = std::make_shared<const std::vector<unsigned char> >(*thumbnail);
+        for (const auto index : rank(namesOf(_uploaders))) {
+            // The pool is torn down before the uploaders, so the pointer outlives the job.
+            Uploader *uploader = _uploaders[index].get();
+            std::string host = uploader->identify();
+            lanes.push_back(Lane{host, false, true,
+                                 [this, uploader, host, bytes](const CallContext &context) {
+                                     const auto uploaded = upload(*uploader, host, *bytes, context);
+                                     return SearchResult{uploaded.image_url, "", Static};
+                                 }});
+        }
+    }
+    return lanes;
+}
 
-        const auto [image_url, web_url, image_type] = source->searchTrack(track);
+void Enricher::launch(const std::shared_ptr<Race> &race, Lane &lane, const std::size_t index,
+                      const Track &track, const CallContext &context) const {
+    lane.launched = true;
+    _pool.submit([this, race, index, track, platform = lane.platform, needLink = lane.needLink,
+            uploaded = lane.upload, call = lane.call,
+            context = CallContext{lane.stop.get_token(), context.deadline, context.priority}] {
+            SearchResult answer;
+            try {
+                answer = call(context);
+            } catch (const std::exception &e) {
+                logging::get("enricher")->warn("Asking {} threw: {}", platform, e.what());
+            }
+            bool late = false;
+            bool wantImage = false; {
+                std::lock_guard lock(race->mutex);
+                race->answers[index] = answer;
+                late = race->abandoned;
+                wantImage = race->needImage;
+            }
+            race->answered.notify_all();
+            if (late && !context.stop.stop_requested()) {
+                settleLate(track, platform, needLink, uploaded, answer, wantImage);
+            }
+        });
+}
 
-        if (needImage && !image_url.empty()) {
-            out.image = ImageUrl{image_url, image_type, platform};
+void Enricher::settleLate(const Track &track, const std::string &platform, const bool needLink,
+                          const bool uploaded, const SearchResult &answer,
+                          const bool wantImage) const {
+    EnrichedTrack late;
+    late.track = track;
+    // Another late answer may have pictured the track already; the first one in stands.
+    if (wantImage && !answer.image_url.empty()) {
+        if (const auto cached = _cache.findEntry(track); !cached || cached->image.url.empty()) {
+            late.image = pictureOf(answer, platform, uploaded);
+        }
+    }
+    if (needLink && !answer.web_url.empty()) {
+        late.songUrls.push_back(SongUrl{answer.web_url, platform});
+    }
+    if (late.image.url.empty() && late.songUrls.empty()) {
+        return;
+    }
+    _cache.writeEntry(late);
+    logging::get("enricher")->debug("{} answered late for '{} - {}'; kept for next time",
+                                    platform, track.identity.artist, track.identity.title);
+}
+
+bool Enricher::searchAll(EnrichedTrack &out,
+                         const std::optional<std::vector<unsigned char> > &thumbnail,
+                         const std::chrono::steady_clock::time_point deadline) const {
+    const Track &track = out.track;
+    auto lanes = contenders(out, thumbnail);
+    if (lanes.empty()) {
+        return false;
+    }
+
+    const auto race = std::make_shared<Race>();
+    race->answers.resize(lanes.size());
+    const auto start = std::chrono::steady_clock::now();
+    const auto sourcesBy = std::min(deadline, start + _schedule.sourceDeadline);
+    const auto context = callContext(start, deadline, _schedule.sourceDeadline,
+                                     _schedule.priority);
+
+    bool needImage = out.image.url.empty();
+    bool changed = false;
+    const auto take = [&](const Lane &lane, const SearchResult &answer) {
+        if (needImage && !answer.image_url.empty()) {
+            out.image = pictureOf(answer, lane.platform, lane.upload);
             needImage = false;
             changed = true;
         }
-        if (needLink && !web_url.empty()) {
-            out.songUrls.push_back(SongUrl{web_url, platform});
-            ownedPlatforms.insert(platform);
+        if (lane.needLink && !answer.web_url.empty()) {
+            out.songUrls.push_back(SongUrl{answer.web_url, lane.platform});
             changed = true;
         }
+    };
+
+    // Ask every source with something to offer at once, so the wait is the slowest search rather
+    // than the sum of them.
+    const auto sources = static_cast<std::size_t>(std::ranges::count(lanes, false, &Lane::upload));
+    for (std::size_t i = 0; i < sources; ++i) {
+        launch(race, lanes[i], i, track, context);
+    }
+
+    std::unique_lock lock(race->mutex);
+    race->answered.wait_until(lock, sourcesBy, [&] {
+        return std::all_of(race->answers.begin(), race->answers.begin() + sources,
+                           [](const auto &answer) { return answer.has_value(); });
+    });
+    // Answers are taken in the order asked, not the order they landed in, so the image always
+    // goes to the first source that has one.
+    for (std::size_t i = 0; i < sources; ++i) {
+        if (race->answers[i]) {
+            lanes[i].settled = true;
+            take(lanes[i], *race->answers[i]);
+        } else {
+            logging::get("enricher")->warn("{} did not answer for '{} - {}' in time",
+                                           lanes[i].platform, track.identity.artist,
+                                           track.identity.title);
+        }
     }
 
     // Only upload if we still don't possess an image
-    if (needImage && thumbnail.has_value()) {
-        for (const auto &uploader : _uploaders) {
-            if (const auto [image_url] = uploader->uploadImage(*thumbnail, Static); !image_url.
-                empty()) {
-                out.image = ImageUrl{image_url, Static, uploader->identify()};
+    for (std::size_t i = sources; i < lanes.size() && needImage; ++i) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+        launch(race, lanes[i], i, track, context);
+        const auto landed = [&race, i] { return race->answers[i].has_value(); };
+        if (deadline == std::chrono::steady_clock::time_point::max()) {
+            race->answered.wait(lock, landed);
+        } else {
+            race->answered.wait_until(lock, deadline, landed);
+        }
+        if (race->answers[i]) {
+            lanes[i].settled = true;
+            take(lanes[i], *race->answers[i]);
+        }
+    }
+
+    race->abandoned = true;
+    race->needImage = needImage;
+    return changed;
+}
+
+bool Enricher::raceForImage(EnrichedTrack &out,
+                            const std::optional<std::vector<unsigned char> > &thumbnail,
+                            const std::chrono::steady_clock::time_point deadline) const {
+    const Track &track = out.track;
+    auto lanes = contenders(out, thumbnail);
+    if (lanes.empty()) {
+        return false;
+    }
+
+    const auto race = std::make_shared<Race>();
+    race->answers.resize(lanes.size());
+    const auto log = logging::get("enricher");
+    const auto start = std::chrono::steady_clock::now();
+    const auto budget = std::min(deadline, start + _schedule.sourceDeadline);
+    const auto context = callContext(start, deadline, _schedule.sourceDeadline,
+                                     _schedule.priority);
+    auto hedgeAt = budget;
+    // Lanes before this have been started, or passed over once the image was won.
+    std::size_t next = 0;
+
+    const auto hedge = [&] {
+        launch(race, lanes[next], next, track, context);
+        ++next;
+        hedgeAt = std::chrono::steady_clock::now() + _schedule.hedgeDelay;
+    };
+    // With no image left to race for, only the lanes owing a link are worth starting, and there
+    // is nothing to hedge: they are all started at once.
+    const auto startLinks = [&] {
+        for (; next < lanes.size(); ++next) {
+            if (lanes[next].needLink) {
+                launch(race, lanes[next], next, track, context);
+            }
+        }
+    };
+
+    bool needImage = out.image.url.empty();
+    bool changed = false;
+    if (needImage) {
+        hedge();
+    } else {
+        startLinks();
+    }
+
+    std::unique_lock lock(race->mutex);
+    while (true) {
+        bool pending = false;
+        bool linksPending = false;
+        for (std::size_t i = 0; i < lanes.size(); ++i) {
+            Lane &lane = lanes[i];
+            if (!lane.launched || lane.settled) {
+                continue;
+            }
+            if (!race->answers[i]) {
+                pending = true;
+                linksPending = linksPending || lane.needLink;
+                continue;
+            }
+            lane.settled = true;
+            const SearchResult &answer = *race->answers[i];
+
+            if (needImage && !answer.image_url.empty()) {
+                out.image = pictureOf(answer, lane.platform, lane.upload);
+                needImage = false;
                 changed = true;
+            }
+            if (lane.needLink && !answer.web_url.empty()) {
+                out.songUrls.push_back(SongUrl{answer.web_url, lane.platform});
+                changed = true;
+            }
+        }
+
+        if (!needImage) {
+            // The image is won: whoever was only still running for it has lost.
+            for (Lane &lane : lanes) {
+                if (lane.launched && !lane.settled && !lane.needLink && lane.stop.request_stop()) {
+                    log->debug("Cancelled {}, beaten to the image for '{} - {}'", lane.platform,
+                               track.identity.artist, track.identity.title);
+                }
+            }
+        }
+        if (std::chrono::steady_clock::now() >= budget) {
+            break;
+        }
+        if (!needImage) {
+            if (next < lanes.size()) {
+                startLinks();
+                continue;
+            }
+            if (!linksPending) {
                 break;
             }
+        } else if (next < lanes.size() &&
+                   (!pending || std::chrono::steady_clock::now() >= hedgeAt)) {
+            hedge();
+            continue;
+        }
+        if (!pending) {
+            break; // every contender has answered, none with an image
         }
+
+        const auto wake = needImage && next < lanes.size() ? std::min(hedgeAt, budget) : budget;
+        race->answered.wait_until(lock, wake);
     }
 
-    if (changed) {
-        _cache.writeEntry(out);
+    // Whatever is still running carries on, and what it finds goes to the cache.
+    for (const Lane &lane : lanes) {
+        if (lane.launched && !lane.settled && !lane.stop.stop_requested()) {
+            log->debug("{} did not answer for '{} - {}' in time", lane.platform,
+                       track.identity.artist, track.identity.title);
+        }
     }
-    return out;
+    race->abandoned = true;
+    race->needImage = needImage;
+    return changed;
+}
+
+bool Enricher::upgrade(const Track &track, const CallContext &context) const {
+    const auto cached = _cache.findEntry(track);
+    if (!cached || cached->image.url.empty() || cached->image.quality == ImageQuality::Matched) {
+        return false; // nothing to upgrade, or nothing better to be had
+    }
+    EnrichedTrack out = *cached;
+    out.track = track;
+    std::set<std::string> ownedPlatforms;
+    for (const auto &[url, source] : out.songUrls) {
+        ownedPlatforms.insert(source);
+    }
+
+    // One source at a time, on the caller's thread: an upgrade is never in a hurry, and the pool
+    // is kept for the enrichments that are.
+    bool upgraded = false;
+    bool linked = false;
+    for (const auto index : rank(namesOf(_sources))) {
+        if (context.stop.stop_requested() || context.expired()) {
+            break;
+        }
+        const auto &source = _sources[index];
+        const std::string platform = source->identify();
+        const auto answer = ask(*source, platform, track, context);
+        if (!answer.image_url.empty()) {
+            if (auto image = pictureOf(answer, platform, false); outranks(image, out.image)) {
+                out.image = std::move(image);
+                upgraded = true;
+            }
+        }
+        if (!answer.web_url.empty() && ownedPlatforms.insert(platform).second) {
+            out.songUrls.push_back(SongUrl{answer.web_url, platform});
+            linked = true;
+        }
+        if (out.image.quality == ImageQuality::Matched) {
+            break;
+        }
+    }
+
+    if (!upgraded && !linked) {
+        return false;
+    }
+    if (!upgraded) {
+        out.image = {}; // the row's written_at stands, so the fallback still expires on time
+    }
+    _cache.writeEntry(out);
+    if (upgraded) {
+        logging::get("enricher")->info("Upgraded the image of '{} - {}' from {} to {} by {}",
+                                       track.identity.artist, track.identity.title,
+                                       to_string(cached->image.quality),
+                                       to_string(out.image.quality), out.image.source);
+    }
+    return upgraded;
+}
+
+std::vector<std::size_t> Enricher::rank(const std::vector<std::string> &names) const {
+    std::vector<std::size_t> order;
+    order.reserve(names.size());
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        if (_health.allows(names[i])) {
+            order.push_back(i);
+        } else {
+            logging::get("enricher")->debug("Passing over {} while its circuit is open", names[i]);
+        }
+    }
+    if (_schedule.adaptiveOrder) {
+        // Stable, so contenders that cost the same keep their registration order.
+        std::vector<double> costs(names.size());
+        for (const auto i : order) {
+            costs[i] = _health.expectedCost(names[i]);
+        }
+        std::ranges::stable_sort(order, {}, [&costs](const std::size_t i) { return costs[i]; });
+    }
+    return order;
+}
+
+SearchResult Enricher::ask(MetadataWebSource &source, const std::string &name, const Track &track,
+                           const CallContext &context) const {
+    const auto joined = _searches.run(name + "|" + cache_codec::trackKey(track), [&] {
+        const auto start = std::chrono::steady_clock::now();
+        auto harvest = source.harvestTrack(track, context);
+        Search search{
+            std::move(harvest.result), context.stop.stop_requested() || context.expired()
+        };
+        // A search cut short by its caller says nothing about the source.
+        if (!search.cancelled) {
+            _health.record(name, outcomeOf(search.result), since(start));
+        }
+        if (!harvest.others.empty()) {
+            keepHarvest(name, track, harvest.others);
+        }
+        return search;
+    }, context.deadline);
+    if (!joined) {
+        // Joined a search started with more time to spare, and ran out of its own waiting on it.
+        return SearchResult{.failed = true};
+    }
+    const auto &[result, cancelled] = *joined;
+    if (cancelled && !context.stop.stop_requested() && !context.expired()) {
+        // The search joined was abandoned by the caller that started it, but this one still wants
+        // an answer.
+        return ask(source, name, track, context);
+    }
+    return result;
+}
+
+void Enricher::keepHarvest(const std::string &platform, const Track &track,
+                           const std::vector<HarvestedSong> &others) const {
+    const auto asked = cache_codec::trackKey(track);
+    std::vector<EnrichedTrack> entries;
+    entries.reserve(others.size());
+    for (const auto &[identity, result] : others) {
+        if (identity.title.empty() || identity.artist.empty())
+            continue;
+        EnrichedTrack entry;
+        entry.track.identity = identity;
+        // The track asked for is the enrichment's own to write.
+        if (cache_codec::trackKey(entry.track) == asked)
+            continue;
+        if (!result.image_url.empty()) {
+            entry.image = ImageUrl{result.image_url, result.image_type, platform,
+                                   ImageQuality::Harvested, result.confidence};
+        }
+        if (!result.web_url.empty()) {
+            entry.songUrls.push_back(SongUrl{result.web_url, platform});
+        }
+        if (!entry.image.url.empty() || !entry.songUrls.empty()) {
+            entries.push_back(std::move(entry));
+        }
+    }
+    if (const auto kept = _cache.writeHarvest(entries); kept > 0) {
+        logging::get("enricher")->debug("Kept {} song(s) {} listed beside '{} - {}'", kept,
+                                        platform, track.identity.artist, track.identity.title);
+    }
+}
+
+UploadResult Enricher::upload(Uploader &uploader, const std::string &name,
+                              const std::vector<unsigned char> &bytes,
+                              const CallContext &context) const {
+    const auto start = std::chrono::steady_clock::now();
+    UploadResult result = uploader.uploadImage(bytes, Static, context);
+    if (!context.stop.stop_requested() && !context.expired()) {
+        _health.record(name, outcomeOf(result), since(start));
+    }
+    return result;
 }
@@ -0,0 +1,181 @@
+/**
+ * @file health.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "metadata/health.hpp"
+#include "metadata/cache_codec.hpp"
+#include "log/log.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <format>
+
+namespace {
+/// Layout version written ahead of an encoded health.
+constexpr std::uint8_t kHealthVersion{1};
+
+/// Floor on the success ratio when working out a cost, so one that never answers is merely last.
+constexpr double kMinSuccessRatio{0.05};
+
+/// The state row a contender's health is kept under.
+std::string stateName(const std::string &name) {
+    return "health|" + name;
+}
+}
+
+bool SourceHealth::allows(const Clock::time_point now) const {
+    return now >= _openUntil;
+}
+
+bool SourceHealth::record(const Outcome outcome, const std::chrono::milliseconds latency,
+                          const Clock::time_point now) {
+    const double ms = static_cast<double>(latency.count());
+    const double hit = outcome == Outcome::Hit ? 1.0 : 0.0;
+    // The first call seeds the averages rather than being smoothed into the defaults.
+    if (_calls == 0) {
+        _latencyMs = ms;
+        _successRatio = hit;
+    } else {
+        _latencyMs += kHealthSmoothing * (ms - _latencyMs);
+        _successRatio += kHealthSmoothing * (hit - _successRatio);
+    }
+    ++_calls;
+
+    if (outcome != Outcome::Failed) {
+        _consecutiveFailures = 0;
+        _openUntil = {};
+        return false;
+    }
+    if (++_consecutiveFailures < kFailuresToOpen)
+        return false;
+
+    // Doubles with every failure past the threshold; the shift is capped well before overflow.
+    const auto doublings = std::min<std::uint32_t>(_consecutiveFailures - kFailuresToOpen, 16);
+    const auto backoff = std::min<std::chrono::seconds>(kBaseBackoff * (1 << doublings),
+                                                        kMaxBackoff);
+    _openUntil = now + backoff;
+    return true;
+}
+
+double SourceHealth::expectedCost() const {
+    if (_calls == 0)
+        return 0.0;
+    return _latencyMs / std::max(_successRatio, kMinSuccessRatio);
+}
+
+HealthSnapshot SourceHealth::snapshot(std::string name, const Clock::time_point now) const {
+    HealthSnapshot out;
+    out.name = std::move(name);
+    out.latency = std::chrono::milliseconds(static_cast<std::int64_t>(_latencyMs));
+    out.successRatio = _successRatio;
+    out.consecutiveFailures = _consecutiveFailures;
+    out.calls = _calls;
+    if (_openUntil > now)
+        out.openFor = std::chrono::ceil<std::chrono::seconds>(_openUntil - now);
+    return out;
+}
+
+std::string SourceHealth::encode() const {
+    std::string out;
+    out.push_back(static_cast<char>(kHealthVersion));
+    cache_codec::putI64(out, std::bit_cast<std::int64_t>(_latencyMs));
+    cache_codec::putI64(out, std::bit_cast<std::int64_t>(_successRatio));
+    cache_codec::putI64(out, _consecutiveFailures);
+    cache_codec::putI64(out, static_cast<std::int64_t>(_calls));
+    cache_codec::putI64(out, std::chrono::duration_cast<std::chrono::milliseconds>(
+                            _openUntil.time_since_epoch()).count());
+    return out;
+}
+
+std::optional<SourceHealth> SourceHealth::decode(const std::string_view raw) {
+    if (raw.empty() || static_cast<std::uint8_t>(raw[0]) != kHealthVersion)
+        return std::nullopt;
+
+    std::size_t offset = 1;
+    std::int64_t latency = 0, ratio = 0, failures = 0, calls = 0, openUntil = 0;
+    if (!cache_codec::readI64(raw, offset, latency) || !cache_codec::readI64(raw, offset, ratio) ||
+        !cache_codec::readI64(raw, offset, failures) ||
+        !cache_codec::readI64(raw, offset, calls) ||
+        !cache_codec::readI64(raw, offset, openUntil) || offset != raw.size())
+        return std::nullopt;
+
+    SourceHealth out;
+    out._latencyMs = std::bit_cast<double>(latency);
+    out._successRatio = std::bit_cast<double>(ratio);
+    out._consecutiveFailures = static_cast<std::uint32_t>(failures);
+    out._calls = static_cast<std::uint64_t>(calls);
+    out._openUntil = Clock::time_point(std::chrono::duration_cast<Clock::duration>(
+        std::chrono::milliseconds(openUntil)));
+    return out;
+}
+
+HealthBoard::HealthBoard(MetadataCache &store)
+    : _store(store), _lastLogged(SourceHealth::Clock::now()) {
+}
+
+bool HealthBoard::allows(const std::string &name) {
+    std::lock_guard lock(_mutex);
+    return entry(name).allows(SourceHealth::Clock::now());
+}
+
+void HealthBoard::record(const std::string &name, const Outcome outcome,
+                         const std::chrono::milliseconds latency) {
+    const auto now = SourceHealth::Clock::now();
+    std::lock_guard lock(_mutex);
+    SourceHealth &health = entry(name);
+    if (health.record(outcome, latency, now)) {
+        const auto opened = health.snapshot(name, now);
+        logging::get("enricher")->warn("{} failed {} time(s) in a row; not asked again for {}s",
+                                       name, opened.consecutiveFailures, opened.openFor.count());
+    }
+    _store.writeState(stateName(name), health.encode());
+    logIfDue(now);
+}
+
+double HealthBoard::expectedCost(const std::string &name) {
+    std::lock_guard lock(_mutex);
+    return entry(name).expectedCost();
+}
+
+std::vector<HealthSnapshot> HealthBoard::snapshot() const {
+    const auto now = SourceHealth::Clock::now();
+    std::lock_guard lock(_mutex);
+    std::vector<HealthSnapshot> out;
+    out.reserve(_health.size());
+    for (const auto &[name, health] : _health) {
+        out.push_back(health.snapshot(name, now));
+    }
+    return out;
+}
+
+SourceHealth &HealthBoard::entry(const std::string &name) {
+    if (const auto it = _health.find(name); it != _health.end())
+        return it->second;
+
+    // A missing or unreadable row starts the contender over as healthy.
+    SourceHealth loaded;
+    if (const auto raw = _store.readState(stateName(name))) {
+        if (auto decoded = SourceHealth::decode(*raw)) {
+            loaded = *decoded;
+        }
+    }
+    return _health.emplace(name, loaded).first->second;
+}
+
+void HealthBoard::logIfDue(const SourceHealth::Clock::time_point now) {
+    if (now - _lastLogged < kHealthLogInterval)
+        return;
+    _lastLogged = now;
+
+    std::string line;
+    for (const auto &[name, health] : _health) {
+        const auto snap = health.snapshot(name, now);
+        line += std::format("{}{}: {}ms, {:.0f}% hits over {} call(s)", line.empty() ? "" : "; ",
+                            name, snap.latency.count(), snap.successRatio * 100, snap.calls);
+        if (snap.openFor.count() > 0)
+            line += std::format(", open for {}s", snap.openFor.count());
+    }
+    logging::get("enricher")->info("Source health: {}", line);
+}
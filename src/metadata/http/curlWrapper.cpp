@@ -10,6 +10,9 @@
 #include <memory>
 
 #include "metadata/http/curlGlobal.hpp"
+#include "metadata/http/httpClient.hpp"
+#include "metadata/http/httpEngine.hpp"
+#include "metadata/http/rateLimiter.hpp"
 
 namespace {
 constexpr size_t kMaxLoggedBody = 200;
@@ -27,6 +30,10 @@ bool CurlResult::ok() const {
     return transferred() && httpOk();
 }
 
+bool CurlResult::cancelled() const {
+    return curlcode == CURLE_ABORTED_BY_CALLBACK;
+}
+
 std::string CurlResult::briefBody() const {
     if (output.empty())
         return "<empty body>";
@@ -50,6 +57,11 @@ bool CurlResult::checkTransfer(const std::string_view &logger,
                                const std::string &description) const {
     if (transferred())
         return true;
+    // A cancelled call was abandoned on purpose, so there is nothing to warn about.
+    if (cancelled()) {
+        logging::get(logger)->debug("{} cancelled", description);
+        return false;
+    }
     logging::get(logger)->warn("{} failed: {}", description, curlErrorString);
     return false;
 }
@@ -64,9 +76,8 @@ bool CurlResult::checkResponse(const std::string_view &logger,
     return false;
 }
 
-CurlWrapper::CurlWrapper(const std::string &endpoint) {
-    CurlGlobal::initialize();
-    curl = curl_easy_init();
+CurlWrapper::CurlWrapper(const std::string &endpoint) : host(hostOf(endpoint)) {
+    curl = HttpClient::instance().acquire(host);
     if (!curl) {
         throw CurlInitError();
     }
@@ -74,9 +85,18 @@ CurlWrapper::CurlWrapper(const std::string &endpoint) {
     curl_easy_setopt(curl, CURLOPT_URL, endpoint.c_str());
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
     curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 5L);
-    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, static_cast<long>(kRequestTimeout.count()));
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, static_cast<long>(kRequestTimeout.count()));
     curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, errbuf);
+    // Keeps the pooled connection alive between calls, so the next one can go out on it.
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    // Every encoding this libcurl can decode (gzip, and br and zstd when built in) is offered,
+    // and the body is decoded before it reaches WriteCallback.
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+    // HTTP/2 where the server offers it over TLS, so HttpEngine can multiplex its transfers.
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+    // Refused up front when the server says how big the body is; WriteCallback catches the rest.
+    curl_easy_setopt(curl, CURLOPT_MAXFILESIZE_LARGE, static_cast<curl_off_t>(kMaxResponseBytes));
     errbuf[0] = '\0';
 }
 
@@ -99,7 +119,31 @@ void CurlWrapper::addMime(const std::vector<unsigned char> &bytes, const std::st
 
 void CurlWrapper::usePost(const std::string &fields) const {
     curl_easy_setopt(curl, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, fields.c_str());
+    // Copied, so callers may pass a temporary: CURLOPT_POSTFIELDS would only keep the pointer.
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(fields.size()));
+    curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, fields.c_str());
+}
+
+void CurlWrapper::setContext(const CallContext &context) {
+    deadline = context.deadline;
+    priority = context.priority;
+    if (deadline) {
+        // At least a millisecond: zero would lift the timeout altogether. A deadline already
+        // passed is caught by performCall before anything is sent.
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            *deadline - std::chrono::steady_clock::now());
+        const auto timeout = std::clamp<std::chrono::milliseconds>(
+            left, std::chrono::milliseconds(1), kRequestTimeout);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(timeout.count()));
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(timeout.count()));
+    }
+
+    stop = context.stop;
+    if (!stop.stop_possible())
+        return; // Nothing can ever cancel it, so there is nothing to poll.
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, ProgressCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &stop);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
 }
 
 CurlWrapper::~CurlWrapper() {
@@ -107,7 +151,7 @@ CurlWrapper::~CurlWrapper() {
         curl_slist_free_all(headers);
     if (mime)
         curl_mime_free(mime);
-    curl_easy_cleanup(curl);
+    HttpClient::instance().release(host, curl);
 }
 
 void CurlWrapper::addHeader(const std::string &header) {
@@ -120,20 +164,72 @@ void CurlWrapper::setUserAgent(const std::string &useragent) {
 
 CurlResult CurlWrapper::performCall() {
     CurlResult r;
+    if (prepare(r))
+        finish(r, curl_easy_perform(curl));
+    return r;
+}
+
+std::future<CurlResult> CurlWrapper::performAsync(std::unique_ptr<CurlWrapper> request) {
+    return HttpEngine::instance().submit(std::move(request));
+}
+
+void CurlWrapper::performAsync(std::unique_ptr<CurlWrapper> request,
+                               std::function<void(CurlResult)> done) {
+    HttpEngine::instance().submit(std::move(request), std::move(done));
+}
+
+bool CurlWrapper::prepare(CurlResult &r) {
     errbuf[0] = '\0';
 
+    if (stop.stop_requested()) {
+        r.curlcode = CURLE_ABORTED_BY_CALLBACK;
+        r.curlErrorString = "cancelled before it went out";
+        return false;
+    }
+    if (deadline && std::chrono::steady_clock::now() >= *deadline) {
+        r.curlcode = CURLE_OPERATION_TIMEDOUT;
+        r.curlErrorString = "deadline passed before it went out";
+        return false;
+    }
+    if (auto *limiter = RateLimiter::forHost(host);
+        limiter && !limiter->acquire(CallContext{stop, deadline, priority})) {
+        if (stop.stop_requested()) {
+            r.curlcode = CURLE_ABORTED_BY_CALLBACK;
+            r.curlErrorString = "cancelled while waiting for the rate limit";
+        } else {
+            r.curlcode = CURLE_OPERATION_TIMEDOUT;
+            r.curlErrorString = "deadline would pass waiting for the rate limit";
+        }
+        return false;
+    }
+
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &r.output);
+    return true;
+}
 
-    r.curlcode = curl_easy_perform(curl);
+void CurlWrapper::finish(CurlResult &r, const CURLcode code) {
+    r.curlcode = code;
     curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &r.HTTPCode);
-
-    if (r.curlcode != CURLE_OK) {
+    long connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+    r.reusedConnection = r.curlcode == CURLE_OK && connects == 0;
+    curl_off_t body = 0;
+    long header = 0;
+    curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &body);
+    curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE, &header);
+    r.bytesReceived = static_cast<std::size_t>(body) + static_cast<std::size_t>(header);
+    HttpClient::instance().record(host, r.bytesReceived, r.reusedConnection);
+    logging::get("http")->debug("{} call ended with HTTP {} after {} byte(s){}", host, r.HTTPCode,
+                                r.bytesReceived,
+                                r.reusedConnection ? ", on a reused connection" : "");
+
+    if (r.curlcode == CURLE_WRITE_ERROR || r.curlcode == CURLE_FILESIZE_EXCEEDED) {
+        r.curlErrorString = fmt::format("response larger than {} bytes", kMaxResponseBytes);
+    } else if (r.curlcode != CURLE_OK) {
         if (errbuf[0] != '\0')
             r.curlErrorString = errbuf;
         else
             r.curlErrorString = curl_easy_strerror(r.curlcode);
     }
-
-    return r;
 }
\ No newline at end of file
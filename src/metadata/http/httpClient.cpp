@@ -0,0 +1,107 @@
+/**
+ * @file httpClient.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "metadata/http/httpClient.hpp"
+
+#include "metadata/http/curlGlobal.hpp"
+
+HttpClient &HttpClient::instance() {
+    static HttpClient client;
+    return client;
+}
+
+HttpClient::HttpClient() {
+    // Initialised first, so that libcurl outlives the handles cleaned up at exit.
+    CurlGlobal::initialize();
+    _share = curl_share_init();
+    if (!_share)
+        return; // Handles then simply go out unshared.
+    curl_share_setopt(_share, CURLSHOPT_LOCKFUNC, lockShare);
+    curl_share_setopt(_share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+    curl_share_setopt(_share, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    // Not CURL_LOCK_DATA_CONNECT: the handles run on several threads at once, and libcurl does not
+    // support sharing connections between them. Each handle keeps its own, which is what the
+    // per-host pool is for.
+}
+
+HttpClient::~HttpClient() {
+    for (auto &[host, handles] : _idle) {
+        for (auto *handle : handles) {
+            curl_easy_cleanup(handle);
+        }
+    }
+    if (_share)
+        curl_share_cleanup(_share);
+}
+
+CURL *HttpClient::acquire(const std::string_view host) {
+    CURL *handle = nullptr; {
+        std::lock_guard lock(_mutex);
+        if (const auto found = _idle.find(host); found != _idle.end() && !found->second.empty()) {
+            handle = found->second.back();
+            found->second.pop_back();
+        }
+    }
+    if (!handle)
+        handle = curl_easy_init();
+    // Reset on release, so the share is the only option it comes with.
+    if (handle && _share)
+        curl_easy_setopt(handle, CURLOPT_SHARE, _share);
+    return handle;
+}
+
+void HttpClient::release(const std::string_view host, CURL *handle) {
+    if (!handle)
+        return;
+    curl_easy_reset(handle); {
+        std::lock_guard lock(_mutex);
+        auto found = _idle.find(host);
+        if (found == _idle.end())
+            found = _idle.emplace(std::string(host), std::vector<CURL *>{}).first;
+        if (found->second.size() < kMaxIdlePerHost) {
+            found->second.push_back(handle);
+            return;
+        }
+    }
+    curl_easy_cleanup(handle);
+}
+
+std::size_t HttpClient::idle(const std::string_view host) const {
+    std::lock_guard lock(_mutex);
+    const auto found = _idle.find(host);
+    return found == _idle.end() ? 0 : found->second.size();
+}
+
+void HttpClient::record(const std::string_view host, const std::size_t bytesReceived,
+                        const bool reused) {
+    std::lock_guard lock(_mutex);
+    auto found = _traffic.find(host);
+    if (found == _traffic.end())
+        found = _traffic.emplace(std::string(host), HostTraffic{.host = std::string(host)}).first;
+    ++found->second.calls;
+    found->second.reused += reused ? 1 : 0;
+    found->second.bytesReceived += bytesReceived;
+}
+
+std::vector<HostTraffic> HttpClient::traffic() const {
+    std::lock_guard lock(_mutex);
+    std::vector<HostTraffic> out;
+    out.reserve(_traffic.size());
+    for (const auto &[host, traffic] : _traffic) {
+        out.push_back(traffic);
+    }
+    return out;
+}
+
+void HttpClient::lockShare(CURL *, const curl_lock_data data, curl_lock_access, void *client) {
+    static_cast<HttpClient *>(client)->_shareLocks[data].lock();
+}
+
+void HttpClient::unlockShare(CURL *, const curl_lock_data data, void *client) {
+    static_cast<HttpClient *>(client)->_shareLocks[data].unlock();
+}
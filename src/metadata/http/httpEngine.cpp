@@ -0,0 +1,160 @@
+/**
+ * @file httpEngine.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "metadata/http/httpEngine.hpp"
+
+#include "metadata/http/httpClient.hpp"
+
+HttpEngine &HttpEngine::instance() {
+    static HttpEngine engine;
+    return engine;
+}
+
+HttpEngine::HttpEngine() {
+    // Made first, so the pool outlives the requests still held here at exit.
+    (void) HttpClient::instance();
+    _multi = curl_multi_init();
+    if (_multi) {
+        // Transfers to one host share a connection where HTTP/2 allows.
+        curl_multi_setopt(_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        _thread = std::jthread([this](const std::stop_token &stop) { run(stop); });
+    }
+}
+
+HttpEngine::~HttpEngine() {
+    if (!_multi)
+        return;
+    _thread.request_stop();
+    curl_multi_wakeup(_multi);
+    _thread.join();
+    curl_multi_cleanup(_multi);
+}
+
+std::future<CurlResult> HttpEngine::submit(std::unique_ptr<CurlWrapper> request) {
+    auto promise = std::make_shared<std::promise<CurlResult> >();
+    auto future = promise->get_future();
+    submit(std::move(request),
+           [promise](CurlResult result) { promise->set_value(std::move(result)); });
+    return future;
+}
+
+void HttpEngine::submit(std::unique_ptr<CurlWrapper> request,
+                        std::function<void(CurlResult)> done) {
+    auto transfer = std::make_unique<Transfer>();
+    transfer->request = std::move(request);
+    transfer->done = std::move(done);
+
+    if (!_multi) {
+        transfer->result.curlcode = CURLE_FAILED_INIT;
+        transfer->result.curlErrorString = "curl_multi_init failed";
+        transfer->done(std::move(transfer->result));
+        return;
+    }
+    // Checked, and rate limited, here on the caller's thread, so the I/O thread never waits.
+    if (!transfer->request->prepare(transfer->result)) {
+        transfer->done(std::move(transfer->result));
+        return;
+    }
+    // Only here: a blocking call has nothing running beside it to share a connection with, and
+    // would wait on the multiplexing check for nothing.
+    curl_easy_setopt(transfer->request->curl, CURLOPT_PIPEWAIT, 1L);
+    if (const auto &stop = transfer->request->stop; stop.stop_possible()) {
+        transfer->onStop.emplace(stop, [this] { curl_multi_wakeup(_multi); });
+    }
+
+    std::unique_lock lock(_mutex);
+    _pending.push_back(std::move(transfer));
+    ++_inFlight;
+    lock.unlock();
+    curl_multi_wakeup(_multi);
+}
+
+std::size_t HttpEngine::inFlight() const {
+    std::lock_guard lock(_mutex);
+    return _inFlight;
+}
+
+void HttpEngine::run(const std::stop_token &stop) {
+    std::vector<std::unique_ptr<Transfer> > adopted;
+    std::vector<CURL *> cancelled;
+    while (!stop.stop_requested()) {
+        {
+            std::lock_guard lock(_mutex);
+            adopted.swap(_pending);
+        }
+        for (auto &transfer : adopted) {
+            CURL *handle = transfer->request->curl;
+            if (curl_multi_add_handle(_multi, handle) != CURLM_OK) {
+                transfer->request->finish(transfer->result, CURLE_FAILED_INIT);
+                settle(std::move(transfer));
+                continue;
+            }
+            _active.emplace(handle, std::move(transfer));
+        }
+        adopted.clear();
+
+        // A pulled stop ends its transfer now, not at its next progress callback.
+        cancelled.clear();
+        for (const auto &[handle, transfer] : _active) {
+            if (transfer->request->stop.stop_requested())
+                cancelled.push_back(handle);
+        }
+        for (auto *handle : cancelled) {
+            complete(handle, CURLE_ABORTED_BY_CALLBACK);
+        }
+
+        int running = 0;
+        curl_multi_perform(_multi, &running);
+        int queued = 0;
+        while (const CURLMsg *message = curl_multi_info_read(_multi, &queued)) {
+            if (message->msg != CURLMSG_DONE)
+                continue;
+            // The message is freed along with the handle's place in the multi handle.
+            CURL *handle = message->easy_handle;
+            const CURLcode code = message->data.result;
+            complete(handle, code);
+        }
+
+        curl_multi_poll(_multi, nullptr, 0, static_cast<int>(kEnginePollInterval.count()),
+                        nullptr);
+    }
+
+    // Shutting down: whatever is left is abandoned, and its callers told so.
+    while (!_active.empty()) {
+        complete(_active.begin()->first, CURLE_ABORTED_BY_CALLBACK);
+    }
+    std::lock_guard lock(_mutex);
+    for (auto &transfer : _pending) {
+        transfer->result.curlcode = CURLE_ABORTED_BY_CALLBACK;
+        transfer->result.curlErrorString = "abandoned at shutdown";
+        --_inFlight;
+        transfer->onStop.reset();
+        transfer->request.reset();
+        transfer->done(std::move(transfer->result));
+    }
+    _pending.clear();
+}
+
+void HttpEngine::complete(CURL *handle, const CURLcode code) {
+    const auto found = _active.find(handle);
+    if (found == _active.end())
+        return;
+    auto transfer = std::move(found->second);
+    _active.erase(found);
+    curl_multi_remove_handle(_multi, handle);
+    transfer->request->finish(transfer->result, code);
+    settle(std::move(transfer));
+}
+
+void HttpEngine::settle(std::unique_ptr<Transfer> transfer) {
+    transfer->onStop.reset();
+    // The handle goes back to the pool before the caller hears, so a follow-up call can reuse it.
+    transfer->request.reset(); {
+        std::lock_guard lock(_mutex);
+        --_inFlight;
+    }
+    transfer->done(std::move(transfer->result));
+}
@@ -0,0 +1,247 @@
+/**
+ * @file jsonSelect.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "metadata/http/jsonSelect.hpp"
+
+#include <bit>
+#include <charconv>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <tuple>
+
+using Json = nlohmann::json;
+
+namespace json_select {
+namespace {
+/**
+ * Undoes a pointer token's escapes: ~1 is '/', ~0 is '~'.
+ */
+std::string unescape(const std::string_view token) {
+    std::string out;
+    out.reserve(token.size());
+    for (std::size_t i = 0; i < token.size(); ++i) {
+        if (token[i] == '~' && i + 1 < token.size() &&
+            (token[i + 1] == '0' || token[i + 1] == '1')) {
+            out += token[++i] == '0' ? '~' : '/';
+        } else {
+            out += token[i];
+        }
+    }
+    return out;
+}
+
+std::optional<std::int64_t> parseInteger(const std::string_view text) {
+    std::int64_t value = 0;
+    const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || end != text.data() + text.size())
+        return std::nullopt;
+    return value;
+}
+} // namespace
+
+std::optional<std::int64_t> Value::asInteger() const {
+    if (kind == Kind::Integer)
+        return integer;
+    if (kind == Kind::String)
+        return parseInteger(string);
+    return std::nullopt;
+}
+
+bool Selector::Token::matchesKey(const std::string_view name) const {
+    return !any && key == name;
+}
+
+bool Selector::Token::matchesIndex(const std::size_t at) const {
+    return any || index == at;
+}
+
+Selector::Selector(const std::initializer_list<std::string_view> pointers) {
+    if (pointers.size() > kMaxPointers)
+        throw std::invalid_argument("json_select::Selector holds at most 64 pointers");
+    _pointers.reserve(pointers.size());
+    for (auto pointer : pointers) {
+        if (!pointer.empty() && pointer.front() != '/')
+            throw std::invalid_argument("json_select::Selector takes JSON pointers only");
+        std::vector<Token> tokens;
+        while (!pointer.empty()) {
+            pointer.remove_prefix(1);
+            const auto end = pointer.find('/');
+            Token token{.key = unescape(pointer.substr(0, end))};
+            token.any = token.key == "*";
+            if (const auto index = parseInteger(token.key); index && *index >= 0)
+                token.index = static_cast<std::size_t>(*index);
+            tokens.push_back(std::move(token));
+            pointer = end == std::string_view::npos ? std::string_view{} : pointer.substr(end);
+        }
+        _pointers.push_back(std::move(tokens));
+    }
+}
+
+std::size_t Selector::size() const {
+    return _pointers.size();
+}
+
+/**
+ * An nlohmann SAX handler that follows the path of each value and hands over the ones a pointer
+ * selects. Each open object or array is a frame holding the pointers still on course below it, as
+ * bits; a frame none are on course for is read past without comparing anything.
+ */
+class Handler {
+public:
+    Handler(const Selector &selector, const std::function<void(const Match &)> &onMatch)
+        : _pointers(selector._pointers), _onMatch(onMatch) {
+        _frames.reserve(16);
+        _alive = _pointers.size() == kMaxPointers ? ~std::uint64_t{0}
+                                                  : (std::uint64_t{1} << _pointers.size()) - 1;
+    }
+
+    bool null() {
+        scalar(Value{});
+        return true;
+    }
+
+    bool boolean(const bool value) {
+        scalar(Value{.kind = Value::Kind::Boolean, .boolean = value});
+        return true;
+    }
+
+    bool number_integer(const Json::number_integer_t value) {
+        scalar(Value{.kind = Value::Kind::Integer, .integer = value});
+        return true;
+    }
+
+    bool number_unsigned(const Json::number_unsigned_t value) {
+        scalar(Value{.kind = Value::Kind::Integer, .integer = static_cast<std::int64_t>(value)});
+        return true;
+    }
+
+    bool number_float(const Json::number_float_t value, const Json::string_t &) {
+        scalar(Value{.kind = Value::Kind::Float, .number = value});
+        return true;
+    }
+
+    bool string(Json::string_t &value) {
+        scalar(Value{.kind = Value::Kind::String, .string = value});
+        return true;
+    }
+
+    bool binary(Json::binary_t &) {
+        scalar(Value{});
+        return true;
+    }
+
+    bool start_object(std::size_t) {
+        open(false);
+        return true;
+    }
+
+    bool key(Json::string_t &value) {
+        auto &frame = _frames.back();
+        frame.next = 0;
+        for (auto bits = frame.alive; bits != 0; bits &= bits - 1) {
+            const auto p = static_cast<std::size_t>(std::countr_zero(bits));
+            if (_pointers[p][frame.depth].matchesKey(value))
+                frame.next |= std::uint64_t{1} << p;
+        }
+        return true;
+    }
+
+    bool end_object() {
+        _frames.pop_back();
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        open(true);
+        return true;
+    }
+
+    bool end_array() {
+        _frames.pop_back();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) {
+        return false;
+    }
+
+private:
+    struct Frame {
+        bool array = false;
+        /// Tokens on the path to the frame.
+        std::size_t depth = 0;
+        /// Pointers still on course inside the frame.
+        std::uint64_t alive = 0;
+        /// Pointers on course for the value about to be read.
+        std::uint64_t next = 0;
+        std::size_t nextIndex = 0;
+        /// Innermost array element the frame sits in.
+        std::size_t element = 0;
+    };
+
+    /**
+     * Works out which pointers the value about to be read is on course for.
+     * @return Those pointers, the tokens on its path, and the array element it sits in.
+     */
+    [[nodiscard]] std::tuple<std::uint64_t, std::size_t, std::size_t> beginValue() {
+        if (_frames.empty())
+            return {_alive, 0, 0};
+        auto &frame = _frames.back();
+        if (!frame.array)
+            return {frame.next, frame.depth + 1, frame.element};
+        const auto index = frame.nextIndex++;
+        std::uint64_t next = 0;
+        for (auto bits = frame.alive; bits != 0; bits &= bits - 1) {
+            const auto p = static_cast<std::size_t>(std::countr_zero(bits));
+            if (_pointers[p][frame.depth].matchesIndex(index))
+                next |= std::uint64_t{1} << p;
+        }
+        return {next, frame.depth + 1, index};
+    }
+
+    /// Hands the value to every pointer that ends at it.
+    void report(std::uint64_t bits, const std::size_t depth, const std::size_t element,
+                const Value &value) {
+        for (; bits != 0; bits &= bits - 1) {
+            const auto p = static_cast<std::size_t>(std::countr_zero(bits));
+            if (_pointers[p].size() == depth)
+                _onMatch(Match{.pointer = p, .element = element, .value = value});
+        }
+    }
+
+    void scalar(const Value &value) {
+        const auto [next, depth, element] = beginValue();
+        report(next, depth, element, value);
+    }
+
+    void open(const bool array) {
+        const auto [next, depth, element] = beginValue();
+        report(next, depth, element,
+               Value{.kind = array ? Value::Kind::Array : Value::Kind::Object});
+        // Only pointers reaching further stay on course inside.
+        std::uint64_t alive = 0;
+        for (auto bits = next; bits != 0; bits &= bits - 1) {
+            const auto p = static_cast<std::size_t>(std::countr_zero(bits));
+            if (_pointers[p].size() > depth)
+                alive |= std::uint64_t{1} << p;
+        }
+        _frames.push_back(Frame{.array = array, .depth = depth, .alive = alive,
+                                .element = element});
+    }
+
+    const std::vector<std::vector<Selector::Token> > &_pointers;
+    const std::function<void(const Match &)> &_onMatch;
+    /// Every pointer, for the document itself.
+    std::uint64_t _alive = 0;
+    std::vector<Frame> _frames{};
+};
+
+bool select(const std::string_view json, const Selector &selector,
+            const std::function<void(const Match &)> &onMatch) {
+    Handler handler(selector, onMatch);
+    return Json::sax_parse(json.begin(), json.end(), &handler);
+}
+} // namespace json_select
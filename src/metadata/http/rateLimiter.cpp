@@ -0,0 +1,194 @@
+/**
+ * @file rateLimiter.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "metadata/http/rateLimiter.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+
+namespace {
+/// Short of a whole token by no more than this counts as whole, so rounding in the refill never
+/// leaves a caller waiting out a sliver of a nanosecond.
+constexpr double kTokenSlack{1e-9};
+
+std::size_t slotOf(const CallPriority priority) {
+    return priority == CallPriority::Interactive ? 0 : 1;
+}
+
+/**
+ * Every process-wide limiter, by host. Limiters are never removed, so the pointers handed out stay
+ * valid.
+ */
+struct Registry {
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<RateLimiter>, std::less<> > limiters;
+
+    Registry() {
+        limiters.emplace("ws.audioscrobbler.com", std::make_unique<RateLimiter>(kLastFmRateLimit));
+        limiters.emplace("api.imgur.com", std::make_unique<RateLimiter>(kImgurRateLimit));
+    }
+};
+
+Registry &registry() {
+    static Registry instance;
+    return instance;
+}
+} // namespace
+
+std::chrono::microseconds RateWaitStats::meanWait() const {
+    const auto calls = granted + refused;
+    if (calls == 0)
+        return {};
+    return totalWait / static_cast<std::int64_t>(calls);
+}
+
+RateLimiter::RateLimiter(const RateLimit limit)
+    : _limit{limit.perSecond, std::max(limit.burst, 1.0)}, _tokens(_limit.burst),
+      _refilled(Clock::now()) {
+}
+
+bool RateLimiter::acquire(const CallContext &context) {
+    const auto started = Clock::now();
+    const auto slot = slotOf(context.priority);
+    std::unique_lock lock(_mutex);
+    const auto ticket = _nextTicket++;
+    _queues[slot].push_back(ticket);
+    ++_generation;
+
+    bool granted = false;
+    while (!context.stop.stop_requested()) {
+        const auto now = Clock::now();
+        refill(now);
+        auto wake = context.deadline;
+        if (turn() == context.priority && _queues[slot].front() == ticket) {
+            const auto ready = nextToken(now);
+            if (ready <= now) {
+                if (_limit.perSecond > 0)
+                    _tokens = std::max(_tokens - 1, 0.0);
+                granted = true;
+                break;
+            }
+            // A token past the deadline is never had, so it is not waited for either.
+            if (context.deadline && ready > *context.deadline)
+                break;
+            wake = ready;
+        } else if (context.expired()) {
+            break;
+        }
+
+        // Woken early by anyone joining or leaving the queues, since that may make it our turn.
+        const auto seen = _generation;
+        const auto moved = [&] { return _generation != seen; };
+        if (wake) {
+            _changed.wait_until(lock, context.stop, *wake, moved);
+        } else {
+            _changed.wait(lock, context.stop, moved);
+        }
+    }
+
+    std::erase(_queues[slot], ticket);
+    if (granted) {
+        _interactiveStreak = context.priority == CallPriority::Interactive
+                                 ? _interactiveStreak + 1
+                                 : 0;
+    }
+    ++_generation;
+    record(context.priority, granted, Clock::now() - started);
+    lock.unlock();
+    _changed.notify_all();
+    return granted;
+}
+
+void RateLimiter::setLimit(const RateLimit limit) {
+    {
+        std::lock_guard lock(_mutex);
+        refill(Clock::now());
+        _limit = RateLimit{limit.perSecond, std::max(limit.burst, 1.0)};
+        _tokens = std::min(_tokens, _limit.burst);
+        ++_generation;
+    }
+    _changed.notify_all();
+}
+
+std::array<RateWaitStats, 2> RateLimiter::stats() const {
+    std::lock_guard lock(_mutex);
+    return _stats;
+}
+
+RateLimiter *RateLimiter::forHost(const std::string_view host) {
+    auto &[mutex, limiters] = registry();
+    std::lock_guard lock(mutex);
+    const auto found = limiters.find(host);
+    return found == limiters.end() ? nullptr : found->second.get();
+}
+
+void RateLimiter::limitHost(const std::string_view host, const RateLimit limit) {
+    auto &[mutex, limiters] = registry();
+    std::lock_guard lock(mutex);
+    if (const auto found = limiters.find(host); found != limiters.end()) {
+        found->second->setLimit(limit);
+    } else {
+        limiters.emplace(std::string(host), std::make_unique<RateLimiter>(limit));
+    }
+}
+
+std::vector<RateLimiterStats> RateLimiter::snapshot() {
+    auto &[mutex, limiters] = registry();
+    std::lock_guard lock(mutex);
+    std::vector<RateLimiterStats> out;
+    out.reserve(limiters.size());
+    for (const auto &[host, limiter] : limiters) {
+        const auto [interactive, bulk] = limiter->stats();
+        out.push_back(RateLimiterStats{.host = host, .interactive = interactive, .bulk = bulk});
+    }
+    return out;
+}
+
+void RateLimiter::refill(const Clock::time_point now) {
+    if (_limit.perSecond > 0 && now > _refilled) {
+        const std::chrono::duration<double> elapsed = now - _refilled;
+        _tokens = std::min(_limit.burst, _tokens + elapsed.count() * _limit.perSecond);
+    }
+    _refilled = std::max(_refilled, now);
+}
+
+CallPriority RateLimiter::turn() const {
+    if (_queues[slotOf(CallPriority::Bulk)].empty())
+        return CallPriority::Interactive;
+    if (_queues[slotOf(CallPriority::Interactive)].empty())
+        return CallPriority::Bulk;
+    return _interactiveStreak >= kInteractiveShare ? CallPriority::Bulk : CallPriority::Interactive;
+}
+
+RateLimiter::Clock::time_point RateLimiter::nextToken(const Clock::time_point now) const {
+    if (_limit.perSecond <= 0 || _tokens >= 1 - kTokenSlack)
+        return now;
+    // Rounded up, so that waking at it always finds the token whole.
+    return now + std::chrono::ceil<Clock::duration>(
+               std::chrono::duration<double>((1 - _tokens) / _limit.perSecond));
+}
+
+void RateLimiter::record(const CallPriority priority, const bool granted,
+                         const Clock::duration waited) {
+    auto &stats = _stats[slotOf(priority)];
+    ++(granted ? stats.granted : stats.refused);
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(waited);
+    stats.totalWait += micros;
+    stats.longestWait = std::max(stats.longestWait, micros);
+}
+
+std::string_view hostOf(std::string_view url) {
+    if (const auto scheme = url.find("://"); scheme != std::string_view::npos)
+        url.remove_prefix(scheme + 3);
+    url = url.substr(0, url.find_first_of("/?#"));
+    if (const auto user = url.rfind('@'); user != std::string_view::npos)
+        url.remove_prefix(user + 1);
+    if (url.starts_with('['))
+        return url.substr(0, url.find(']') + 1); // IPv6 literal, whose colons are not a port
+    return url.substr(0, url.find(':'));
+}
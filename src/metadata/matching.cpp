@@ -71,11 +71,17 @@ bool substringMatch(const std::string &s1, const std::string &s2) {
 
 }
 
-bool fuzzyMatch(const std::string &a, const std::string &b, const bool allowSubstring) {
+double matchScore(const std::string &a, const std::string &b, const bool allowSubstring) {
     // Lowercase once here; both the ratio and the substring check work on the lowered forms.
     const std::string la = toLowerCase(a);
     const std::string lb = toLowerCase(b);
 
-    return similarityRatio(la, lb) >= kMatchGenerosity ||
-           (allowSubstring && substringMatch(la, lb));
+    const double ratio = similarityRatio(la, lb);
+    if (allowSubstring && ratio < kSubstringScore && substringMatch(la, lb))
+        return kSubstringScore;
+    return ratio;
+}
+
+bool fuzzyMatch(const std::string &a, const std::string &b, const bool allowSubstring) {
+    return matchScore(a, b, allowSubstring) >= kMatchGenerosity;
 }
\ No newline at end of file
@@ -0,0 +1,187 @@
+/**
+ * @file artwork.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "metadata/sources/artwork.hpp"
+
+#include <charconv>
+#include <optional>
+
+namespace {
+/// Host Apple serves its artwork from; only its urls name a rendition that can be rewritten.
+constexpr std::string_view kArtworkHost{"mzstatic.com"};
+
+constexpr bool isDigit(const char c) {
+    return c >= '0' && c <= '9';
+}
+
+constexpr bool isLower(const char c) {
+    return c >= 'a' && c <= 'z';
+}
+
+constexpr bool isSpace(const char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+std::string_view extension(const ArtworkFormat format) {
+    return format == ArtworkFormat::Webp ? "webp" : "jpg";
+}
+
+void appendNumber(std::string &out, const unsigned value) {
+    char buf[8];
+    const auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, end);
+}
+
+/// Appends the crop code, and the quality a jpeg is asked for at.
+void appendCrop(std::string &out, const std::string_view crop, const ArtworkFormat format) {
+    out += crop;
+    if (format == ArtworkFormat::Jpeg) {
+        out += '-';
+        appendNumber(out, kArtworkQuality);
+    }
+}
+
+/**
+ * Where an artwork url names its rendition: its last path segment, when that reads
+ * "<w>x<h><crop>[-<quality>].<ext>".
+ */
+struct Rendition {
+    std::size_t begin;
+    std::size_t end;
+    std::string_view crop;
+};
+
+std::optional<Rendition> findRendition(const std::string_view url) {
+    if (url.find(kArtworkHost) == std::string_view::npos)
+        return std::nullopt;
+    std::size_t end = url.find_first_of("?#");
+    if (end == std::string_view::npos)
+        end = url.size();
+    const auto slash = url.rfind('/', end == 0 ? 0 : end - 1);
+    if (slash == std::string_view::npos)
+        return std::nullopt;
+    const std::size_t begin = slash + 1;
+    const auto segment = url.substr(begin, end - begin);
+
+    std::size_t i = 0;
+    const auto skip = [&](auto accept) {
+        const std::size_t from = i;
+        while (i < segment.size() && accept(segment[i]))
+            ++i;
+        return i > from;
+    };
+    const auto take = [&](const char c) {
+        if (i < segment.size() && segment[i] == c) {
+            ++i;
+            return true;
+        }
+        return false;
+    };
+
+    if (!skip(isDigit) || !take('x') || !skip(isDigit))
+        return std::nullopt;
+    const std::size_t cropBegin = i;
+    if (!skip(isLower))
+        return std::nullopt;
+    const auto crop = segment.substr(cropBegin, i - cropBegin);
+    if (take('-') && !skip(isDigit))
+        return std::nullopt;
+    if (!take('.') || !skip(isLower) || i != segment.size())
+        return std::nullopt;
+    return Rendition{begin, end, crop};
+}
+}
+
+std::string fillArtwork(const std::string_view pattern, const ArtworkSize &size) {
+    std::string out;
+    out.reserve(pattern.size() + 8);
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+        if (pattern[i] == '{' && i + 2 < pattern.size() && pattern[i + 2] == '}') {
+            switch (pattern[i + 1]) {
+            case 'w':
+            case 'h':
+                appendNumber(out, size.edge);
+                i += 2;
+                continue;
+            case 'c':
+                appendCrop(out, "bb", size.format);
+                i += 2;
+                continue;
+            case 'f':
+                out += extension(size.format);
+                i += 2;
+                continue;
+            default:
+                break;
+            }
+        }
+        out += pattern[i];
+    }
+    return out;
+}
+
+std::string resizeArtwork(const std::string_view url, const ArtworkSize &size) {
+    const auto rendition = findRendition(url);
+    if (!rendition)
+        return std::string(url);
+
+    std::string out;
+    out.reserve(url.size() + 8);
+    out.append(url.substr(0, rendition->begin));
+    appendNumber(out, size.edge);
+    out += 'x';
+    appendNumber(out, size.edge);
+    appendCrop(out, rendition->crop, size.format);
+    out += '.';
+    out += extension(size.format);
+    out.append(url.substr(rendition->end));
+    return out;
+}
+
+std::string artworkFromSrcset(const std::string_view srcset, const ArtworkSize &size) {
+    std::string_view fit;
+    unsigned fitWidth = 0;
+    std::string_view largest;
+    unsigned largestWidth = 0;
+
+    std::size_t pos = 0;
+    while (pos < srcset.size()) {
+        while (pos < srcset.size() && (isSpace(srcset[pos]) || srcset[pos] == ','))
+            ++pos;
+        const std::size_t urlBegin = pos;
+        while (pos < srcset.size() && !isSpace(srcset[pos]) && srcset[pos] != ',')
+            ++pos;
+        const auto url = srcset.substr(urlBegin, pos - urlBegin);
+        while (pos < srcset.size() && isSpace(srcset[pos]))
+            ++pos;
+        const std::size_t descriptorBegin = pos;
+        while (pos < srcset.size() && srcset[pos] != ',')
+            ++pos;
+        if (url.empty())
+            continue;
+
+        // Only a width descriptor ("296w") says anything about size; a density ("2x") does not.
+        unsigned width = 0;
+        const auto descriptor = srcset.substr(descriptorBegin, pos - descriptorBegin);
+        if (const auto [end, ec] = std::from_chars(descriptor.data(),
+                                                   descriptor.data() + descriptor.size(), width);
+            ec != std::errc{} || end == descriptor.data() + descriptor.size() || *end != 'w') {
+            width = 0;
+        }
+
+        if (largest.empty() || width > largestWidth) {
+            largest = url;
+            largestWidth = width;
+        }
+        if (width >= size.edge && (fit.empty() || width < fitWidth)) {
+            fit = url;
+            fitWidth = width;
+        }
+    }
+
+    const auto chosen = fit.empty() ? largest : fit;
+    return chosen.empty() ? std::string{} : resizeArtwork(chosen, size);
+}
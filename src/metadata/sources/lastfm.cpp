@@ -5,51 +5,17 @@
  */
 
 #include "metadata/sources/lastfm.hpp"
-#include "metadata/matching.hpp"
 #include "metadata/http/curlWrapper.hpp"
 #include "security/credentials.hpp"
+#include "metadata/sources/lastfm_request.hpp"
 #include "log/log.hpp"
-#include "system/winrt.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <thread>
-#include <winrt/Windows.Storage.Streams.h>
-#include <winrt/Windows.Security.Cryptography.h>
-#include <winrt/Windows.Security.Cryptography.Core.h>
-#include <nlohmann/json.hpp>
 #include <conio.h>
 
-using Json = nlohmann::json;
-
 namespace {
-/**
-* Computes the MD5 hash of a given input string.
-* @param input Input to hash.
-* @return Hashed output.
-*/
-std::string Md5(const std::string &input) {
-    WinRtInit::initialize();
-    namespace crypto = winrt::Windows::Security::Cryptography;
-    try {
-        // Held per thread
-        static thread_local const auto provider =
-            crypto::Core::HashAlgorithmProvider::OpenAlgorithm(
-                crypto::Core::HashAlgorithmNames::Md5());
-
-        const auto *inBytes = reinterpret_cast<const uint8_t *>(input.data());
-        const auto inBuffer = crypto::CryptographicBuffer::CreateFromByteArray(
-            {inBytes, inBytes + input.size()});
-        const auto outBuffer = provider.HashData(inBuffer);
-        return winrt::to_string(crypto::CryptographicBuffer::EncodeToHexString(outBuffer));
-    } catch (const winrt::hresult_error &e) {
-        logging::get("lastfm")->error("MD5 hashing failed: {}", winrt::to_string(e.message()));
-        return {};
-    } catch (...) {
-        logging::get("lastfm")->error("MD5 hashing failed with an unknown error");
-        return {};
-    }
-}
-
 /**
  * Trims trailing album identifiers.
  * @param input Album name.
@@ -68,64 +34,86 @@ std::string trimAlbumName(const std::string &input) {
 
 }
 
-bool LastFm::scrobble(const Track &track) const {
-    if (!_authenticated.load(std::memory_order::memory_order_relaxed))
-        return false;
+bool LastFm::playedEnough(const Track &track) const {
     const auto curr = track.timing.current();
     const auto total = track.timing.total();
-    if (curr <= kTrackLengthForScrobble || (
-            curr < total && std::chrono::duration<double>(curr) / std::chrono::duration<
-                double>(total) <= kTrackLengthPercentageForScrobble))
-        return false;
+    return curr > kTrackLengthForScrobble && (
+               curr >= total || std::chrono::duration<double>(curr) / std::chrono::duration<
+                   double>(total) > kTrackLengthPercentageForScrobble);
+}
 
-    std::string body;
-
-    const std::string timestamp = std::to_string(track.timing.start());
-    const std::string artist = CurlWrapper::escape(track.identity.artist);
-    const std::string title = CurlWrapper::escape(track.identity.title);
-    const std::string album = CurlWrapper::escape(trimAlbumName(track.identity.album));
-    const std::string hash = Md5(
-        "album" + trimAlbumName(track.identity.album) + "api_key" + _apikey + "artist" + track.
-        identity.artist + "method" + "track.scrobble" + "sk" + _sessionKey + "timestamp" + timestamp
-        + "track" + track.identity.title + _apiSecret);
-    if (hash.empty()) {
-        logging::get("lastfm")->error("Skipping scrobble of '{} - {}': could not sign the request",
-                                      track.identity.artist, track.identity.title);
-        return false;
+bool LastFm::scrobble(const Track &track) const {
+    return scrobbleTracks(std::span(&track, 1), CallPriority::Interactive).front() !=
+           ScrobbleStatus::Failed;
+}
+
+std::vector<ScrobbleStatus> LastFm::scrobbleBatch(const std::span<const Track> tracks) const {
+    // Only a replay of the journal hands over more than the play just made; nobody waits on it.
+    return scrobbleTracks(tracks, CallPriority::Bulk);
+}
+
+std::vector<ScrobbleStatus> LastFm::scrobbleTracks(const std::span<const Track> tracks,
+                                                   const CallPriority priority) const {
+    std::vector statuses(tracks.size(), ScrobbleStatus::Failed);
+    if (!_authenticated.load(std::memory_order::memory_order_relaxed))
+        return statuses;
+
+    // Plays not yet played far enough are left out of the requests; their indices map what each
+    // request answers back onto the plays it carried.
+    std::vector<Track> sendable;
+    std::vector<std::size_t> indices;
+    for (std::size_t i = 0; i < tracks.size(); ++i) {
+        if (playedEnough(tracks[i])) {
+            sendable.push_back(tracks[i]);
+            indices.push_back(i);
+        }
     }
 
-    body += "method=track.scrobble";
-    body += "&api_key=" + _apikey;
-    body += "&artist=" + artist;
-    body += "&track=" + title;
-    body += "&album=" + album;
-    body += "&timestamp=" + timestamp;
-    body += "&sk=" + _sessionKey;
-    body += "&api_sig=" + hash;
+    for (std::size_t from = 0; from < sendable.size(); from += kScrobbleBatchLimit) {
+        const auto count = std::min(kScrobbleBatchLimit, sendable.size() - from);
+        const auto answered =
+            submitScrobbles(std::span(sendable).subspan(from, count), priority);
+        for (std::size_t k = 0; k < count; ++k) {
+            statuses[indices[from + k]] = answered[k];
+        }
+    }
+    return statuses;
+}
 
-    const std::string url = "https://ws.audioscrobbler.com/2.0/";
+std::vector<ScrobbleStatus> LastFm::submitScrobbles(const std::span<const Track> tracks,
+                                                    const CallPriority priority) const {
+    std::vector failed(tracks.size(), ScrobbleStatus::Failed);
+    const auto &first = tracks.front().identity;
+    const auto describe = tracks.size() == 1
+                              ? fmt::format("'{} - {}'", first.artist, first.title)
+                              : fmt::format("{} plays", tracks.size());
+
+    LastFmRequest request("track.scrobble", _apikey);
+    request.set("sk", _sessionKey);
+    for (std::size_t k = 0; k < tracks.size(); ++k) {
+        const auto index = "[" + std::to_string(k) + "]";
+        request.set("album" + index, trimAlbumName(tracks[k].identity.album))
+               .set("artist" + index, tracks[k].identity.artist)
+               .set("timestamp" + index, std::to_string(tracks[k].timing.start()))
+               .set("track" + index, tracks[k].identity.title);
+    }
+    request.sign(_apiSecret);
 
     std::unique_ptr<CurlWrapper> curl = nullptr;
     try {
-        curl = std::make_unique<CurlWrapper>(url);
+        curl = std::make_unique<CurlWrapper>(std::string(kLastFmEndpoint));
     } catch (const CurlInitError &e) {
-        logging::get("lastfm")->error("Skipping scrobble of '{} - {}': {}", track.identity.artist,
-                                      track.identity.title, e.what());
-        return false;
+        logging::get("lastfm")->error("Skipping scrobble of {}: {}", describe, e.what());
+        return failed;
     }
 
-    curl->usePost(body);
+    curl->usePost(request.body());
+    curl->setContext(CallContext{.priority = priority});
     const auto r = curl->performCall();
-    if (!r.okOrWarn("lastfm", "track.scrobble for '{} - {}'", track.identity.artist,
-                    track.identity.title))
-        return false;
-
-    if (r.output.find("lfm status=\"ok\"") != std::string::npos) {
-        return true;
-    }
-    logging::get("lastfm")->warn("track.scrobble rejected for '{} - {}': {}", track.identity.artist,
-                                 track.identity.title, r.briefBody());
-    return false;
+    // A refused call still carries its error code in the body, whatever the HTTP status.
+    if (!r.transferredOrWarn("lastfm", "track.scrobble for {}", describe))
+        return failed;
+    return parseScrobbles(r.output, tracks.size());
 }
 
 LastFm::LastFm(const std::string &apikey, const std::string &apiSecret) {
@@ -147,13 +135,8 @@ LastFm::LastFm(const std::string &apikey, const std::string &apiSecret) {
 }
 
 LastFm::Session LastFm::getNewSession(const std::string &token) const {
-    std::string url = "https://ws.audioscrobbler.com/2.0/?method=auth.getSession&api_key=" + _apikey
-                      + "&token=" + token;
-    const std::string hash = Md5(
-        "api_key" + _apikey + "method" + "auth.getSession" + "token" + token + _apiSecret);
-    if (hash.empty())
-        return {};
-    url += "&api_sig=" + hash + "&format=json";
+    const auto url = LastFmRequest("auth.getSession", _apikey).set("token", token)
+                                                               .sign(_apiSecret).url();
 
     std::unique_ptr<CurlWrapper> curl = nullptr;
     try {
@@ -168,29 +151,37 @@ LastFm::Session LastFm::getNewSession(const std::string &token) const {
     const auto r = curl->performCall();
     if (!r.transferredOrWarn("lastfm", "auth.getSession"))
         return {};
-    try {
-        Json j = Json::parse(r.output);
-        if (j.contains("session") && j["session"].contains("key")) {
-            Session session;
-            session.key = j["session"]["key"].get<std::string>();
-            // The response already names the user, so no user.getInfo call is needed.
-            if (j["session"].contains("name"))
-                session.name = j["session"]["name"].get<std::string>();
-            return session;
-        }
-        // Expected while the user has not yet approved the token; polled every 5s.
-        return {};
-    } catch (const Json::exception &e) {
+    static const json_select::Selector kSelector{
+        "/error", "/message", "/session/key", "/session/name"
+    };
+    LastFmStatus status{.ok = true};
+    Session session;
+    const bool parsed = json_select::select(r.output, kSelector, [&](const json_select::Match &m) {
+        if (takeLastFmStatus(m, status) || m.value.kind != json_select::Value::Kind::String)
+            return;
+        (m.pointer == 2 ? session.key : session.name) = m.value.string;
+    });
+    if (!parsed) {
         // The body carries the session key on success, so it is never logged.
-        logging::get("lastfm")->warn("Malformed auth.getSession response: {}", e.what());
+        logging::get("lastfm")->warn("Malformed auth.getSession response");
         return {};
     }
+    if (!status.ok) {
+        // Expected while the user has not yet approved the token; polled every 5s.
+        if (status.error != LastFmError::UnauthorizedToken) {
+            logging::get("lastfm")->warn("auth.getSession refused: {} (error {})", status.message,
+                                         static_cast<int>(status.error));
+        }
+        return {};
+    }
+    // The response already names the user, so no user.getInfo call is needed.
+    if (session.key.empty())
+        logging::get("lastfm")->warn("auth.getSession response contained no session");
+    return session;
 }
 
 std::string LastFm::requestAuthToken() const {
-    const std::string url = "https://ws.audioscrobbler.com/2.0/?method=auth.gettoken&api_key=" +
-                            _apikey +
-                            "&format=json";
+    const auto url = LastFmRequest("auth.getToken", _apikey).url();
     std::unique_ptr<CurlWrapper> curl = nullptr;
     try {
         curl = std::make_unique<CurlWrapper>(url);
@@ -199,32 +190,32 @@ std::string LastFm::requestAuthToken() const {
         return {};
     }
     const auto r = curl->performCall();
-    if (!r.okOrWarn("lastfm", "auth.getToken"))
+    if (!r.transferredOrWarn("lastfm", "auth.getToken"))
         return {};
 
-    try {
-        Json j = Json::parse(r.output);
-        if (!j.contains("token")) {
-            logging::get("lastfm")->warn("auth.getToken response contained no token");
-            return {};
-        }
-
-        return j["token"].get<std::string>();
-    } catch (const Json::exception &e) {
-        logging::get("lastfm")->warn("Malformed auth.getToken response: {}", e.what());
+    static const json_select::Selector kSelector{"/error", "/message", "/token"};
+    LastFmStatus status{.ok = true};
+    std::string token;
+    const bool parsed = json_select::select(r.output, kSelector, [&](const json_select::Match &m) {
+        if (!takeLastFmStatus(m, status) && m.value.kind == json_select::Value::Kind::String)
+            token = m.value.string;
+    });
+    if (!parsed) {
+        logging::get("lastfm")->warn("Malformed auth.getToken response: {}", r.briefBody());
         return {};
     }
+    if (!status.ok) {
+        logging::get("lastfm")->warn("auth.getToken refused: {} (error {})", status.message,
+                                     static_cast<int>(status.error));
+        return {};
+    }
+    if (token.empty())
+        logging::get("lastfm")->warn("auth.getToken response contained no token");
+    return token;
 }
 
 std::string LastFm::testSessionKey(const std::string &key) const {
-    std::string url = "https://ws.audioscrobbler.com/2.0/?method=user.getInfo&api_key=" + _apikey +
-                      "&sk=" + key;
-    const std::string hash = Md5(
-        "api_key" + _apikey + "method" + "user.getInfo" + "sk" + key + _apiSecret);
-    if (hash.empty()) {
-        return {};
-    }
-    url += "&api_sig=" + hash + "&format=json";
+    const auto url = LastFmRequest("user.getInfo", _apikey).set("sk", key).sign(_apiSecret).url();
 
     std::unique_ptr<CurlWrapper> curl = nullptr;
     try {
@@ -234,21 +225,30 @@ std::string LastFm::testSessionKey(const std::string &key) const {
         return {};
     }
     const auto r = curl->performCall();
-    if (!r.okOrWarn("lastfm", "user.getInfo while validating the stored session key"))
+    if (!r.transferredOrWarn("lastfm", "user.getInfo while validating the stored session key"))
         return {};
 
-    try {
-        if (const Json j = Json::parse(r.output); j.contains("user")) {
-            return j.at("user").at("name").get<std::string>();
-        }
-        // No "user" object means the stored key was rejected; re-auth is required.
-        logging::get("lastfm")->warn("Stored session key was rejected by user.getInfo");
-        return {};
-    } catch (const Json::exception &e) {
+    static const json_select::Selector kSelector{"/error", "/message", "/user/name"};
+    LastFmStatus status{.ok = true};
+    std::string name;
+    const bool parsed = json_select::select(r.output, kSelector, [&](const json_select::Match &m) {
+        if (!takeLastFmStatus(m, status) && m.value.kind == json_select::Value::Kind::String)
+            name = m.value.string;
+    });
+    if (!parsed) {
         // The request is signed with the session key, so the body is never logged.
-        logging::get("lastfm")->warn("Malformed user.getInfo response: {}", e.what());
+        logging::get("lastfm")->warn("Malformed user.getInfo response");
+        return {};
+    }
+    if (!status.ok) {
+        // A rejected key means re-auth is required.
+        logging::get("lastfm")->warn("Stored session key was rejected by user.getInfo: {} "
+                                     "(error {})", status.message, static_cast<int>(status.error));
         return {};
     }
+    if (name.empty())
+        logging::get("lastfm")->warn("user.getInfo response named no user");
+    return name;
 }
 
 bool LastFm::authenticateUser() {
@@ -315,54 +315,28 @@ LastFm::~LastFm() {
     }
 }
 
-SearchResult LastFm::searchTrack(const Track &track) {
+SearchResult LastFm::searchTrack(const Track &track, const CallContext &context) {
     if (_apikey.empty())
         return {};
     const std::string kNumSearchResults = "5";
     std::unique_ptr<CurlWrapper> curl = nullptr;
     try {
-        const std::string url = "https://ws.audioscrobbler.com/2.0/?method=track.search&track=" +
-                                CurlWrapper::escape(track.identity.title) + "&artist=" +
-                                CurlWrapper::escape(track.identity.artist) + "&limit=" +
-                                kNumSearchResults + "&format=json" + "&api_key=" + _apikey;
+        const auto url = LastFmRequest("track.search", _apikey).set("track", track.identity.title)
+                                                              .set("artist", track.identity.artist)
+                                                              .set("limit", kNumSearchResults)
+                                                              .url();
         curl = std::make_unique<CurlWrapper>(url);
     } catch (const CurlInitError &e) {
         logging::get("lastfm")->error("Search for '{} - {}' failed: {}", track.identity.artist,
                                       track.identity.title, e.what());
-        return {};
+        return SearchResult{.failed = true};
     }
+    curl->setContext(context);
     const auto r = curl->performCall();
     if (!r.okOrWarn("lastfm", "track.search for '{} - {}'", track.identity.artist,
                     track.identity.title))
-        return {};
-    try {
-        Json j = Json::parse(r.output)["results"];
-        Json tracks = j["trackmatches"].value("track", Json::array());
-
-        for (const auto &found : tracks) {
-            const std::string title = found.value("name", "");
-            const std::string artist = found.value("artist", "");
-            const std::string url = found.value("url", "");
-
-            // Titles carry source-appended decoration ("… (Remastered)"), so allow a substring
-            // match there; artists don't, so hold them to the ratio to avoid pulling in "X"
-            // against "X Tribute".
-            const auto title_sim = fuzzyMatch(title, track.identity.title, /*allowSubstring=*/true);
-            const auto artist_sim = fuzzyMatch(artist, track.identity.artist);
-
-            if (title_sim && artist_sim) {
-                return {{}, url};
-            }
-        }
-        // No result cleared the fuzzy-match threshold
-        logging::get("lastfm")->debug("No match for '{} - {}' among {} result(s)",
-                                      track.identity.artist, track.identity.title, tracks.size());
-        return {};
-    } catch (const Json::exception &e) {
-        logging::get("lastfm")->warn("Malformed track.search response for '{} - {}': {}",
-                                     track.identity.artist, track.identity.title, e.what());
-        return {};
-    }
+        return SearchResult{.failed = true};
+    return parseSearch(r.output, track.identity);
 }
 
 bool LastFm::authed() const {
@@ -377,37 +351,19 @@ bool LastFm::setPlaying(const Track &track) const {
     if (!_authenticated.load(std::memory_order::memory_order_relaxed))
         return false;
 
-    const std::string url = "https://ws.audioscrobbler.com/2.0/";
-    std::string body;
     const std::string duration = std::to_string(
         std::chrono::duration_cast<std::chrono::seconds>(track.timing.total()).count());
-    const std::string artist = CurlWrapper::escape(track.identity.artist);
-    const std::string album = CurlWrapper::escape(trimAlbumName(track.identity.album));
-    const std::string title = CurlWrapper::escape(track.identity.title);
-
-    const std::string hash = Md5(
-        "album" + trimAlbumName(track.identity.album) + "api_key" + _apikey + "artist" + track.
-        identity.artist + "duration" + duration + "method" + "track.updateNowPlaying" + "sk" +
-        _sessionKey + "track" + track.identity.title + _apiSecret);
-    if (hash.empty()) {
-        logging::get("lastfm")->error(
-            "Skipping now-playing update for '{} - {}': could not sign the request",
-            track.identity.artist, track.identity.title);
-        return false;
-    }
-
-    body += "method=track.updateNowPlaying";
-    body += "&api_key=" + _apikey;
-    body += "&artist=" + artist;
-    body += "&track=" + title;
-    body += "&album=" + album;
-    body += "&duration=" + duration;
-    body += "&sk=" + _sessionKey;
-    body += "&api_sig=" + hash;
+    LastFmRequest request("track.updateNowPlaying", _apikey);
+    request.set("artist", track.identity.artist)
+           .set("track", track.identity.title)
+           .set("album", trimAlbumName(track.identity.album))
+           .set("duration", duration)
+           .set("sk", _sessionKey)
+           .sign(_apiSecret);
 
     std::unique_ptr<CurlWrapper> curl = nullptr;
     try {
-        curl = std::make_unique<CurlWrapper>(url);
+        curl = std::make_unique<CurlWrapper>(std::string(kLastFmEndpoint));
     } catch (const CurlInitError &e) {
         logging::get("lastfm")->error("Set now playing for '{} - {}' failed: {}",
                                       track.identity.artist, track.identity.title, e.what());
@@ -415,17 +371,19 @@ bool LastFm::setPlaying(const Track &track) const {
     }
 
     curl->addHeader("Content-Type: application/x-www-form-urlencoded");
-    curl->usePost(body);
+    curl->usePost(request.body());
     const auto &r = curl->performCall();
-    if (!r.okOrWarn("lastfm", "track.updateNowPlaying for '{} - {}'", track.identity.artist,
-                    track.identity.title))
+    if (!r.transferredOrWarn("lastfm", "track.updateNowPlaying for '{} - {}'",
+                             track.identity.artist, track.identity.title))
         return false;
 
-    if (r.output.find("lfm status=\"ok\"") != std::string::npos) {
-        logging::get("lastfm")->info("Successfully set new LastFm now playing");
-        return true;
+    if (const auto status = parseLastFmStatus(r.output); !status.ok) {
+        logging::get("lastfm")->warn("track.updateNowPlaying refused for '{} - {}': {} (error {})",
+                                     track.identity.artist, track.identity.title,
+                                     status.message.empty() ? r.briefBody() : status.message,
+                                     static_cast<int>(status.error));
+        return false;
     }
-    logging::get("lastfm")->warn("track.updateNowPlaying rejected for '{} - {}': {}",
-                                 track.identity.artist, track.identity.title, r.briefBody());
-    return false;
+    logging::get("lastfm")->info("Successfully set new LastFm now playing");
+    return true;
 }
\ No newline at end of file
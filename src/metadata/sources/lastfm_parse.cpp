@@ -0,0 +1,152 @@
+/**
+ * @file lastfm_parse.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ *
+ * Reading Last.fm's responses, kept apart from the calls that fetch them so the tests can link it
+ * without the credential store.
+ */
+
+#include "metadata/sources/lastfm.hpp"
+#include "metadata/matching.hpp"
+#include "metadata/sources/lastfm_request.hpp"
+#include "log/log.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <nlohmann/json.hpp>
+
+using Json = nlohmann::json;
+
+namespace {
+/// ignoredMessage code for a play turned away because the day's scrobble limit was reached.
+constexpr std::string_view kDailyLimitCode{"5"};
+}
+
+SearchResult LastFm::parseSearch(const std::string_view body, const TrackIdentity &track) {
+    // Only these are read; images, listener counts and the rest are skipped as they are parsed.
+    static const json_select::Selector kSelector{
+        "/error", "/message", "/results/trackmatches/track",
+        "/results/trackmatches/track/*/name", "/results/trackmatches/track/*/artist",
+        "/results/trackmatches/track/*/url"
+    };
+    enum Field : std::size_t { Tracks = kLastFmStatusPointers, Name, Artist, Url };
+
+    struct Candidate {
+        std::string title;
+        std::string artist;
+        std::string url;
+    };
+    Candidate candidate;
+    std::optional<std::size_t> element;
+    std::size_t results = 0;
+    std::optional<SearchResult> match;
+    // Results are scored as each one ends, so their fields are only ever held one at a time.
+    const auto consider = [&] {
+        if (!element || match)
+            return;
+        ++results;
+        // Titles carry source-appended decoration ("… (Remastered)"), so allow a substring
+        // match there; artists don't, so hold them to the ratio to avoid pulling in "X"
+        // against "X Tribute".
+        const auto title_sim = matchScore(candidate.title, track.title, /*allowSubstring=*/true);
+        const auto artist_sim = matchScore(candidate.artist, track.artist);
+        if (title_sim >= kMatchGenerosity && artist_sim >= kMatchGenerosity) {
+            match = SearchResult{
+                .web_url = candidate.url,
+                .confidence = static_cast<std::uint8_t>(std::min(title_sim, artist_sim))
+            };
+        }
+        candidate.title.clear();
+        candidate.artist.clear();
+        candidate.url.clear();
+    };
+
+    LastFmStatus status{.ok = true};
+    bool listed = false;
+    const bool parsed = json_select::select(body, kSelector, [&](const json_select::Match &m) {
+        if (takeLastFmStatus(m, status))
+            return;
+        if (m.pointer == Tracks) {
+            listed = m.value.kind == json_select::Value::Kind::Array;
+            return;
+        }
+        if (m.value.kind != json_select::Value::Kind::String)
+            return;
+        if (element != m.element) {
+            consider();
+            element = m.element;
+        }
+        auto &field = m.pointer == Name     ? candidate.title
+                      : m.pointer == Artist ? candidate.artist
+                                            : candidate.url;
+        field = m.value.string;
+    });
+    consider();
+
+    if (!parsed || (status.ok && !listed)) {
+        logging::get("lastfm")->warn("Malformed track.search response for '{} - {}'",
+                                     track.artist, track.title);
+        return SearchResult{.failed = true};
+    }
+    if (!status.ok) {
+        logging::get("lastfm")->warn("track.search refused for '{} - {}': {} (error {})",
+                                     track.artist, track.title, status.message,
+                                     static_cast<int>(status.error));
+        return SearchResult{.failed = true};
+    }
+    if (match)
+        return *match;
+    // No result cleared the fuzzy-match threshold
+    logging::get("lastfm")->debug("No match for '{} - {}' among {} result(s)",
+                                  track.artist, track.title, results);
+    return {};
+}
+
+std::vector<ScrobbleStatus> LastFm::parseScrobbles(const std::string_view body,
+                                                   const std::size_t count) {
+    std::vector statuses(count, ScrobbleStatus::Failed);
+    try {
+        const Json j = Json::parse(body);
+        if (const auto status = lastFmStatus(j); !status.ok) {
+            logging::get("lastfm")->warn("track.scrobble refused: {} (error {})", status.message,
+                                         static_cast<int>(status.error));
+            return statuses;
+        }
+        // A single play comes back as an object rather than an array of one.
+        Json scrobbles = j.at("scrobbles").at("scrobble");
+        if (!scrobbles.is_array())
+            scrobbles = Json::array({std::move(scrobbles)});
+
+        for (std::size_t k = 0; k < std::min(count, scrobbles.size()); ++k) {
+            const auto &ignored = scrobbles[k].value("ignoredMessage", Json::object());
+            // Documented as a string, but read either way.
+            const auto &rawCode = ignored.value("code", Json("0"));
+            const std::string code = rawCode.is_string() ? rawCode.get<std::string>()
+                                                         : rawCode.dump();
+            if (code == "0") {
+                statuses[k] = ScrobbleStatus::Accepted;
+            } else if (code == kDailyLimitCode) {
+                // Over the day's limit the play is still owed; it is tried again later.
+                logging::get("lastfm")->warn("track.scrobble deferred: daily scrobble limit "
+                                             "reached");
+            } else {
+                statuses[k] = ScrobbleStatus::Ignored;
+                logging::get("lastfm")->info("Last.fm ignored the scrobble of '{} - {}': {} "
+                                             "(code {})",
+                                             scrobbles[k].value("artist", Json::object()).value(
+                                                 "#text", ""),
+                                             scrobbles[k].value("track", Json::object()).value(
+                                                 "#text", ""),
+                                             ignored.value("#text", ""), code);
+            }
+        }
+        if (scrobbles.size() < count) {
+            logging::get("lastfm")->warn("track.scrobble answered for {} of {} plays",
+                                         scrobbles.size(), count);
+        }
+    } catch (const Json::exception &e) {
+        logging::get("lastfm")->warn("Malformed track.scrobble response: {}", e.what());
+    }
+    return statuses;
+}
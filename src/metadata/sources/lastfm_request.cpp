@@ -0,0 +1,216 @@
+/**
+ * @file lastfm_request.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "metadata/sources/lastfm_request.hpp"
+#include "security/md5.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <nlohmann/json.hpp>
+
+using Json = nlohmann::json;
+
+namespace {
+/// Appended to every call, after api_sig: never signed.
+constexpr std::string_view kFormat{"format=json"};
+
+/**
+ * Percent-encodes a value onto out, leaving only RFC 3986's unreserved characters as they are, as
+ * curl_easy_escape does.
+ */
+void appendEscaped(std::string &out, const std::string_view value) {
+    constexpr std::string_view kDigits{"0123456789ABCDEF"};
+    for (const char c : value) {
+        const auto byte = static_cast<unsigned char>(c);
+        if ((byte >= 'A' && byte <= 'Z') || (byte >= 'a' && byte <= 'z') ||
+            (byte >= '0' && byte <= '9') || byte == '-' || byte == '.' || byte == '_' ||
+            byte == '~') {
+            out += c;
+        } else {
+            out += '%';
+            out += kDigits[byte >> 4];
+            out += kDigits[byte & 0x0F];
+        }
+    }
+}
+
+/**
+ * The text between two markers, searching from the first.
+ * @return The text; empty if either marker is missing.
+ */
+std::string_view between(const std::string_view body, const std::string_view open,
+                         const std::string_view close) {
+    const auto start = body.find(open);
+    if (start == std::string_view::npos)
+        return {};
+    const auto from = start + open.size();
+    const auto end = body.find(close, from);
+    if (end == std::string_view::npos)
+        return {};
+    return body.substr(from, end - from);
+}
+
+/// Reads the XML form of a response.
+LastFmStatus parseXmlStatus(const std::string_view body) {
+    LastFmStatus status;
+    const auto state = between(body, "<lfm status=\"", "\"");
+    if (state.empty()) {
+        status.message = "Not a Last.fm response";
+        return status;
+    }
+    if (state == "ok") {
+        status.ok = true;
+        return status;
+    }
+    const auto error = body.find("<error code=\"");
+    if (error == std::string_view::npos) {
+        return status;
+    }
+    const auto code = between(body.substr(error), "\"", "\"");
+    int value = 0;
+    if (std::from_chars(code.data(), code.data() + code.size(), value).ec == std::errc{}) {
+        status.error = static_cast<LastFmError>(value);
+    }
+    status.message = std::string(between(body.substr(error), ">", "</error>"));
+    return status;
+}
+} // namespace
+
+LastFmRequest::LastFmRequest(const std::string_view method, const std::string_view apiKey) {
+    _params.reserve(8);
+    set("api_key", std::string(apiKey));
+    set("method", std::string(method));
+}
+
+LastFmRequest &LastFmRequest::set(const std::string_view name, std::string value) {
+    const auto at = std::ranges::lower_bound(_params, name, {},
+                                             [](const auto &param) -> std::string_view {
+                                                 return param.first;
+                                             });
+    if (at != _params.end() && at->first == name) {
+        at->second = std::move(value);
+    } else {
+        _params.emplace(at, std::string(name), std::move(value));
+    }
+    return *this;
+}
+
+LastFmRequest &LastFmRequest::sign(std::string secret) {
+    _secret = std::move(secret);
+    return *this;
+}
+
+std::string LastFmRequest::body() const {
+    return encode({});
+}
+
+std::string LastFmRequest::url() const {
+    std::string prefix{kLastFmEndpoint};
+    prefix += '?';
+    return encode(prefix);
+}
+
+std::size_t LastFmRequest::size() const {
+    return _params.size();
+}
+
+std::string LastFmRequest::encode(const std::string_view prefix) const {
+    // Escaping at most triples a parameter; '=' and '&' join each.
+    std::size_t reserve = prefix.size() + kFormat.size() + 9 + kMd5HexLength;
+    for (const auto &[name, value] : _params) {
+        reserve += 3 * (name.size() + value.size()) + 2;
+    }
+    std::string out;
+    out.reserve(reserve);
+    out += prefix;
+
+    Md5 signature;
+    for (const auto &[name, value] : _params) {
+        signature.update(name).update(value);
+        appendEscaped(out, name);
+        out += '=';
+        appendEscaped(out, value);
+        out += '&';
+    }
+    if (!_secret.empty()) {
+        const auto hash = signature.update(_secret).hexDigest();
+        out += "api_sig=";
+        out.append(hash.begin(), hash.end());
+        out += '&';
+    }
+    out += kFormat;
+    return out;
+}
+
+bool LastFmStatus::retryable() const {
+    switch (error) {
+        case LastFmError::OperationFailed:
+        case LastFmError::ServiceOffline:
+        case LastFmError::TemporaryError:
+        case LastFmError::RateLimitExceeded:
+            return true;
+        default:
+            return false;
+    }
+}
+
+LastFmStatus lastFmStatus(const Json &json) {
+    LastFmStatus status;
+    if (!json.is_object()) {
+        status.message = "Not a Last.fm response";
+        return status;
+    }
+    const auto error = json.find("error");
+    if (error == json.end()) {
+        status.ok = true;
+        return status;
+    }
+    if (error->is_number_integer()) {
+        status.error = static_cast<LastFmError>(error->get<int>());
+    } else if (error->is_string()) {
+        int value = 0;
+        const auto &text = error->get_ref<const std::string &>();
+        std::from_chars(text.data(), text.data() + text.size(), value);
+        status.error = static_cast<LastFmError>(value);
+    }
+    if (const auto message = json.find("message"); message != json.end() && message->is_string()) {
+        status.message = message->get<std::string>();
+    }
+    return status;
+}
+
+bool takeLastFmStatus(const json_select::Match &match, LastFmStatus &status) {
+    if (match.pointer >= kLastFmStatusPointers)
+        return false;
+    if (match.pointer == 0) {
+        status.ok = false;
+        status.error = static_cast<LastFmError>(match.value.asInteger().value_or(0));
+    } else if (match.value.kind == json_select::Value::Kind::String) {
+        status.message = match.value.string;
+    }
+    return true;
+}
+
+LastFmStatus parseLastFmStatus(const std::string_view body) {
+    const auto first = body.find_first_not_of(" \t\r\n");
+    if (first != std::string_view::npos && body[first] == '<') {
+        return parseXmlStatus(body);
+    }
+    static const json_select::Selector kSelector{"/error", "/message", ""};
+    LastFmStatus status{.ok = true};
+    bool object = false;
+    const bool parsed = json_select::select(body, kSelector, [&](const json_select::Match &match) {
+        if (!takeLastFmStatus(match, status))
+            object = match.value.kind == json_select::Value::Kind::Object;
+    });
+    if (!parsed) {
+        return LastFmStatus{.message = "Malformed response"};
+    }
+    if (!object) {
+        return LastFmStatus{.message = "Not a Last.fm response"};
+    }
+    return status;
+}
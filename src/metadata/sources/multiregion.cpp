@@ -0,0 +1,186 @@
+/**
+ * @file multiregion.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "metadata/sources/multiregion.hpp"
+#include "log/log.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <stop_token>
+#include <utility>
+
+namespace {
+/// Prefix of the state rows an artist's storefront is kept under.
+constexpr std::string_view kAffinityState{"region|"};
+
+std::string affinityKey(const std::string &artist) {
+    std::string key{kAffinityState};
+    for (const unsigned char c : artist) {
+        key += static_cast<char>(std::tolower(c));
+    }
+    return key;
+}
+
+/// Whether a storefront had the track: a search that failed or matched nothing did not.
+bool found(const SearchHarvest &harvest) {
+    return !harvest.result.failed &&
+           (!harvest.result.image_url.empty() || !harvest.result.web_url.empty());
+}
+}
+
+struct MultiRegionScraper::Race {
+    std::mutex mutex;
+    std::condition_variable_any answered;
+    std::vector<std::optional<SearchHarvest> > answers;
+};
+
+MultiRegionScraper::MultiRegionScraper(MetadataCache &cache, RegionPlan plan,
+                                       RegionSource makeSource)
+    : _cache(cache), _plan(std::move(plan)), _makeSource(std::move(makeSource)) {
+}
+
+std::string MultiRegionScraper::identify() {
+    return sourceFor(_plan.primary)->identify();
+}
+
+SearchResult MultiRegionScraper::searchTrack(const Track &track, const CallContext &context) {
+    return harvestTrack(track, context).result;
+}
+
+std::optional<ScraperRegions> MultiRegionScraper::affinity(const std::string &artist) const {
+    if (const auto code = _cache.readState(affinityKey(artist))) {
+        return parseRegion(*code);
+    }
+    return std::nullopt;
+}
+
+std::vector<ScraperRegions> MultiRegionScraper::order(const Track &track) const {
+    std::vector<ScraperRegions> regions;
+    if (const auto learned = affinity(track.identity.artist)) {
+        regions.push_back(*learned);
+    }
+    const auto add = [&regions](const ScraperRegions region) {
+        if (std::ranges::find(regions, region) == regions.end()) {
+            regions.push_back(region);
+        }
+    };
+    add(_plan.primary);
+    for (const auto region : _plan.fallbacks) {
+        add(region);
+    }
+    return regions;
+}
+
+std::shared_ptr<MetadataWebSource> MultiRegionScraper::sourceFor(const ScraperRegions region) {
+    std::lock_guard lock(_mutex);
+    auto &source = _sources[region];
+    if (!source) {
+        source = _makeSource(region);
+    }
+    return source;
+}
+
+SearchHarvest MultiRegionScraper::harvestTrack(const Track &track, const CallContext &context) {
+    const auto regions = order(track);
+    const auto race = std::make_shared<Race>();
+    race->answers.resize(regions.size());
+
+    // The searches are cancelled together: by the caller, or once one of them has the track.
+    std::stop_source cancel;
+    const std::stop_callback forward(context.stop, [&cancel] { cancel.request_stop(); });
+    const CallContext inner{cancel.get_token(), context.deadline, context.priority};
+
+    // Each storefront's search runs on HttpEngine's I/O thread and posts its answer here; the race
+    // is shared with them, since the ones cancelled may answer after this lookup has returned.
+    const auto start = [&](const std::size_t index) {
+        const auto region = regions[index];
+        const auto post = [race, index](SearchHarvest harvest) {
+            {
+                std::lock_guard lock(race->mutex);
+                race->answers[index] = std::move(harvest);
+            }
+            race->answered.notify_all();
+        };
+        try {
+            sourceFor(region)->harvestTrackAsync(track, inner, post);
+        } catch (const std::exception &e) {
+            logging::get("scraper")->warn("Searching the {} storefront threw: {}",
+                                          to_string(region), e.what());
+            post(SearchHarvest{SearchResult{.failed = true}});
+        }
+    };
+    // Waits for done, giving up at until, the caller's deadline or the caller's stop.
+    const auto waitFor = [&](std::unique_lock<std::mutex> &lock,
+                             const std::optional<std::chrono::steady_clock::time_point> until,
+                             const auto done) {
+        auto by = context.deadline;
+        if (until && (!by || *until < *by)) {
+            by = until;
+        }
+        if (by) {
+            race->answered.wait_until(lock, context.stop, *by, done);
+        } else {
+            race->answered.wait(lock, context.stop, done);
+        }
+    };
+    // The first storefront, in order, that has the track among those that have answered.
+    const auto winner = [&]() -> std::optional<std::size_t> {
+        for (std::size_t i = 0; i < race->answers.size(); ++i) {
+            if (race->answers[i] && found(*race->answers[i])) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    };
+
+    start(0);
+    std::unique_lock lock(race->mutex);
+    waitFor(lock, std::chrono::steady_clock::now() + _plan.hedgeDelay,
+            [&] { return race->answers[0].has_value(); });
+
+    if (!winner() && regions.size() > 1 && !context.stop.stop_requested() && !context.expired()) {
+        lock.unlock();
+        for (std::size_t i = 1; i < regions.size(); ++i) {
+            start(i);
+        }
+        lock.lock();
+        waitFor(lock, std::nullopt, [&] {
+            return winner() || std::ranges::all_of(race->answers, [](const auto &answer) {
+                return answer.has_value();
+            });
+        });
+    } else if (!winner()) {
+        waitFor(lock, std::nullopt, [&] { return race->answers[0].has_value(); });
+    }
+
+    const auto won = winner();
+    SearchHarvest out;
+    if (won) {
+        out = *race->answers[*won];
+    } else {
+        // Failed only if every storefront asked failed; a single one saying "not here" is a miss.
+        const auto failed = [](const auto &answer) { return answer && answer->result.failed; };
+        const auto silent = [](const auto &answer) { return !answer.has_value(); };
+        out.result.failed = std::ranges::any_of(race->answers, failed) &&
+                            std::ranges::all_of(race->answers, [&](const auto &answer) {
+                                return failed(answer) || silent(answer);
+                            });
+    }
+    lock.unlock();
+    cancel.request_stop(); // the storefronts still searching abort their transfers
+
+    if (won) {
+        const auto region = regions[*won];
+        const auto learned = affinity(track.identity.artist);
+        if (region != learned.value_or(_plan.primary)) {
+            _cache.writeState(affinityKey(track.identity.artist), to_string(region));
+            logging::get("scraper")->debug("'{}' is found in the {} storefront from now on",
+                                           track.identity.artist, to_string(region));
+        }
+    }
+    return out;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file regions.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "metadata/sources/regions.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <stdexcept>
+
+namespace {
+constexpr std::array<std::string_view, static_cast<size_t>(ScraperRegions::_COUNT)> kRegions = {
+    "ae", "ag", "ai", "am", "ar", "at", "au", "az", "bb", "be",
+    "bg", "bh", "bm", "bo", "br", "bs", "bw", "by", "bz", "ca",
+    "cf", "ch", "ci", "cl", "cm", "cn", "co", "cr", "cz", "de",
+    "dk", "dm", "do", "ec", "ee", "eg", "es", "fi", "fr", "gb",
+    "gd", "ge", "gn", "gq", "gr", "gt", "gw", "gy", "hk", "hn",
+    "hr", "hu", "id", "ie", "il", "in", "it", "jm", "jo", "jp",
+    "kg", "kn", "kr", "kw", "ky", "kz", "la", "lc", "li", "lt",
+    "lu", "lv", "ma", "md", "me", "mg", "mk", "ml", "mo", "ms",
+    "mt", "mu", "mx", "my", "mz", "ne", "ng", "ni", "nl", "no",
+    "nz", "om", "pa", "pe", "ph", "pl", "pr", "pt", "py", "qa",
+    "ro", "ru", "sa", "se", "sg", "si", "sk", "sn", "sr", "sv",
+    "tc", "th", "tj", "tm", "tn", "tr", "tt", "tw", "ua", "ug",
+    "us", "uy", "uz", "vc", "ve", "vg", "vn", "za"
+};
+}
+
+std::string to_string(const ScraperRegions region) {
+    const auto index = static_cast<size_t>(region);
+    if (index >= static_cast<size_t>(ScraperRegions::_COUNT)) {
+        throw std::out_of_range("Unknown region enum value");
+    }
+    return std::string(kRegions[index]);
+}
+
+std::optional<ScraperRegions> parseRegion(const std::string_view code) {
+    if (code.size() != 2)
+        return std::nullopt;
+    const char buf[2] = {static_cast<char>(std::tolower(static_cast<unsigned char>(code[0]))),
+                         static_cast<char>(std::tolower(static_cast<unsigned char>(code[1])))};
+    const std::string_view lower{buf, 2};
+    // The table is in code order, so its index is the enum value.
+    const auto it = std::ranges::lower_bound(kRegions, lower);
+    if (it == kRegions.end() || *it != lower)
+        return std::nullopt;
+    return static_cast<ScraperRegions>(it - kRegions.begin());
+}
+
+bool isValidRegion(const std::string_view region) {
+    return parseRegion(region).has_value();
+}
@@ -5,54 +5,26 @@
  */
 
 #include "metadata/sources/scraper.hpp"
+#include "metadata/sources/artwork.hpp"
 #include "metadata/matching.hpp"
 #include "log/log.hpp"
 
+#include <algorithm>
 #include <memory>
-#include <regex>
-#include <array>
+#include <optional>
+#include <string_view>
+#include <vector>
 
 #include "metadata/http/curlWrapper.hpp"
 #include <libxml/HTMLparser.h>
-#include <libxml/xpath.h>
+#include <nlohmann/json.hpp>
 
-namespace {
-constexpr std::array<std::string_view, static_cast<size_t>(ScraperRegions::_COUNT)> kRegions = {
-    "ae", "ag", "ai", "am", "ar", "at", "au", "az", "bb", "be",
-    "bg", "bh", "bm", "bo", "br", "bs", "bw", "by", "bz", "ca",
-    "cf", "ch", "ci", "cl", "cm", "cn", "co", "cr", "cz", "de",
-    "dk", "dm", "do", "ec", "ee", "eg", "es", "fi", "fr", "gb",
-    "gd", "ge", "gn", "gq", "gr", "gt", "gw", "gy", "hk", "hn",
-    "hr", "hu", "id", "ie", "il", "in", "it", "jm", "jo", "jp",
-    "kg", "kn", "kr", "kw", "ky", "kz", "la", "lc", "li", "lt",
-    "lu", "lv", "ma", "md", "me", "mg", "mk", "ml", "mo", "ms",
-    "mt", "mu", "mx", "my", "mz", "ne", "ng", "ni", "nl", "no",
-    "nz", "om", "pa", "pe", "ph", "pl", "pr", "pt", "py", "qa",
-    "ro", "ru", "sa", "se", "sg", "si", "sk", "sn", "sr", "sv",
-    "tc", "th", "tj", "tm", "tn", "tr", "tt", "tw", "ua", "ug",
-    "us", "uy", "uz", "vc", "ve", "vg", "vn", "za"
-};
-}
-
-constexpr bool isValidRegion(const std::string_view &region) {
-    if (region.size() != 2)
-        return false;
-    char buf[2] = {static_cast<char>(std::tolower(static_cast<unsigned char>(region[0]))),
-                   static_cast<char>(std::tolower(static_cast<unsigned char>(region[1])))};
-    const std::string_view lower{buf, 2};
-    return std::ranges::binary_search(kRegions, lower);
-}
+using Json = nlohmann::json;
 
-std::string to_string(ScraperRegions region) {
-    const auto index = static_cast<size_t>(region);
-    if (index >= static_cast<size_t>(ScraperRegions::_COUNT)) {
-        throw std::out_of_range("Unknown region enum value");
-    }
-    return std::string(kRegions[index]);
-}
-
-Scraper::Scraper(const std::string &region) {
+Scraper::Scraper(const std::string &region, const ScraperMode mode, const ArtworkSize &artwork) {
     _region = region;
+    _mode = mode;
+    _artwork = artwork;
 }
 
 std::string Scraper::identify() {
@@ -60,27 +32,9 @@ std::string Scraper::identify() {
 }
 
 namespace {
-std::string getAttribute(const xmlNodePtr &node, const char *attribute) {
-    if (!node)
-        return "";
-    xmlChar *value = xmlGetProp(node, reinterpret_cast<const xmlChar *>(attribute));
-    if (!value)
-        return "";
-    std::string out = reinterpret_cast<char *>(value);
-    xmlFree(value);
-    return out;
-}
-
-std::string getText(const xmlNodePtr &node) {
-    if (!node)
-        return "";
-    xmlChar *content = xmlNodeGetContent(node); // Gets content of node and descendants
-    if (!content)
-        return "";
-    std::string out = reinterpret_cast<char *>(content);
-    xmlFree(content);
-    return out;
-}
+/// Bytes handed to the parser at a time. Between chunks the scan checks whether it is done, so
+/// the rest of the page is never parsed once the result is confirmed.
+constexpr std::size_t kParseChunk{16 * 1024};
 
 std::string normalize(const std::string &text) {
     const size_t start = text.find_first_not_of(" \t\n\r");
@@ -97,153 +51,531 @@ std::string normalize(const std::string &text) {
     return trimmed;
 }
 
-xmlNodePtr findDescendantWithAttr(const xmlNodePtr &node, const char *tag_name,
-                                  const char *attr_name,
-                                  const char *attr_value) {
-    for (xmlNodePtr current = node; current; current = current->next) {
-        if (current->type == XML_ELEMENT_NODE) {
-            if (!tag_name || xmlStrcasecmp(current->name,
-                                           reinterpret_cast<const xmlChar *>(tag_name)) == 0) {
-                if (std::string attr = getAttribute(current, attr_name);
-                    !attr.empty() && attr == attr_value) {
-                    return current;
-                }
-            }
-        }
-        // Recurse into children
-        if (current->children) {
-            if (xmlNodePtr found = findDescendantWithAttr(
-                current->children, tag_name, attr_name, attr_value)) {
-                return found;
-            }
+/**
+ * Looks up an attribute in the name/value list a SAX start callback is handed.
+ * @return The value, or empty if the element does not carry the attribute.
+ */
+std::string_view attribute(const xmlChar **attrs, const std::string_view name) {
+    for (; attrs && attrs[0]; attrs += 2) {
+        if (reinterpret_cast<const char *>(attrs[0]) == name) {
+            return attrs[1] ? reinterpret_cast<const char *>(attrs[1]) : "";
         }
     }
-    return nullptr;
+    return "";
 }
 
-xmlNodePtr findDivWithClass(const xmlNodePtr &node, const std::string &class_value) {
-    for (xmlNodePtr current = node; current; current = current->next) {
-        if (current->type == XML_ELEMENT_NODE && xmlStrcasecmp(
-                current->name, reinterpret_cast<const xmlChar *>("div"))
-            == 0) {
-            if (std::string classes = getAttribute(current, "class");
-                !classes.empty() && classes.find(class_value) != std::string::npos) {
-                return current;
+/**
+ * One search result, gathered as the parser passes through its <li>.
+ */
+struct Candidate {
+    std::string title;
+    std::string artist;
+    std::string href;
+    std::string srcset;
+};
+
+/**
+ * What the SAX callbacks share while a search page streams through the parser. Only the
+ * desktop-search-page subtree is looked at, and nothing of the page is kept but the candidate
+ * being read and the best one so far. Depths are those of the open elements, counted from 1.
+ */
+struct PageScan {
+    std::string title;
+    std::string artist;
+    htmlParserCtxtPtr parser = nullptr;
+
+    int depth = 0;
+    int rootDepth = 0; ///< of the desktop-search-page div; 0 until it opens
+    int itemDepth = 0; ///< of the <li> being read; 0 between results
+    int titleDepth = 0;
+    int artistDepth = 0;
+    Candidate candidate{};
+
+    std::optional<Candidate> best{};
+    double bestScore = 0;
+    /// Set once nothing later on the page can change the result.
+    bool done = false;
+
+    void finish() {
+        done = true;
+        xmlStopParser(parser);
+    }
+
+    void onStart(const std::string_view name, const xmlChar **attrs) {
+        ++depth;
+        if (rootDepth == 0) {
+            if (name == "div" &&
+                attribute(attrs, "class").find("desktop-search-page") != std::string_view::npos) {
+                rootDepth = depth;
             }
+            return;
         }
-        if (current->children) {
-            if (xmlNodePtr found = findDivWithClass(current->children, class_value)) {
-                return found;
+        if (itemDepth == 0) {
+            if (name == "li") {
+                itemDepth = depth;
+                candidate = {};
             }
+            return;
+        }
+
+        const auto testId = attribute(attrs, "data-testid");
+        if (testId == "track-lockup-title" && titleDepth == 0 && candidate.title.empty()) {
+            titleDepth = depth;
+        } else if (name == "span" && testId == "track-lockup-subtitle" && artistDepth == 0 &&
+                   candidate.artist.empty()) {
+            artistDepth = depth;
+        } else if (name == "a" && testId == "click-action" && candidate.href.empty()) {
+            candidate.href = attribute(attrs, "href");
+        } else if (name == "source" && attribute(attrs, "type") == "image/jpeg" &&
+                   candidate.srcset.empty()) {
+            candidate.srcset = attribute(attrs, "srcset");
+        }
+    }
+
+    void onText(const std::string_view text) {
+        if (titleDepth != 0) {
+            candidate.title += text;
+        }
+        if (artistDepth != 0) {
+            candidate.artist += text;
+        }
+    }
+
+    void onEnd() {
+        if (depth == titleDepth) {
+            titleDepth = 0;
+        }
+        if (depth == artistDepth) {
+            artistDepth = 0;
+        }
+        if (depth == itemDepth) {
+            itemDepth = 0;
+            weigh();
+        }
+        if (depth == rootDepth && !done) {
+            finish(); // past the results
+        }
+        --depth;
+    }
+
+    /// Scores the candidate just read, stopping the parse at the first close match.
+    void weigh() {
+        const std::string found_title = normalize(candidate.title);
+        const std::string found_artist = normalize(candidate.artist);
+        if (found_title.empty() || found_artist.empty())
+            return;
+
+        // Titles carry source-appended decoration ("… (Remastered)"), so allow a substring match
+        // there; artists don't, so hold them to the ratio to avoid pulling in "X" against
+        // "X Tribute".
+        const double score = std::min(matchScore(found_title, title, /*allowSubstring=*/true),
+                                      matchScore(found_artist, artist));
+        if (score < kMatchGenerosity || score <= bestScore)
+            return;
+        best = std::move(candidate);
+        bestScore = score;
+        if (score >= kConfidentMatch) {
+            finish();
         }
     }
-    return nullptr;
+};
+
+void onStartElement(void *ctx, const xmlChar *name, const xmlChar **attrs) {
+    static_cast<PageScan *>(ctx)->onStart(reinterpret_cast<const char *>(name), attrs);
 }
 
-bool trackMatches(const xmlNodePtr &li_node, const std::string &target_title,
-                  const std::string &target_artist) {
-    xmlNodePtr title_node = findDescendantWithAttr(li_node, nullptr, "data-testid",
-                                                   "track-lockup-title");
-    xmlNodePtr artist_node = findDescendantWithAttr(li_node, "span", "data-testid",
-                                                    "track-lockup-subtitle");
+void onEndElement(void *ctx, const xmlChar *) {
+    static_cast<PageScan *>(ctx)->onEnd();
+}
+
+void onCharacters(void *ctx, const xmlChar *text, const int length) {
+    static_cast<PageScan *>(ctx)->onText(
+        std::string_view(reinterpret_cast<const char *>(text), static_cast<std::size_t>(length)));
+}
 
-    if (!title_node || !artist_node)
-        return false;
+/**
+ * Streams a search page through libxml2's SAX parser, never building its tree. Results are taken
+ * in page order; the first close match ends the parse, and failing one, the closest loose match
+ * on the page is taken.
+ * @return The match's link, artwork and score, or an empty result if none matched. Nullopt if the
+ * parser could not be started.
+ */
+std::optional<SearchResult> parsePage(const std::string_view html, const TrackIdentity &track,
+                                      const ArtworkSize &artwork) {
+    htmlSAXHandler sax{};
+    sax.startElement = onStartElement;
+    sax.endElement = onEndElement;
+    sax.characters = onCharacters;
+    sax.cdataBlock = onCharacters;
 
-    const std::string found_title = normalize(getText(title_node));
-    const std::string found_artist = normalize(getText(artist_node));
+    PageScan scan;
+    scan.title = track.title;
+    scan.artist = track.artist;
+    const std::unique_ptr<htmlParserCtxt, decltype(&htmlFreeParserCtxt)> parser{
+        htmlCreatePushParserCtxt(&sax, &scan, nullptr, 0, nullptr, XML_CHAR_ENCODING_UTF8),
+        &htmlFreeParserCtxt
+    };
+    if (!parser)
+        return std::nullopt;
+    htmlCtxtUseOptions(parser.get(), HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING | HTML_PARSE_NONET);
+    scan.parser = parser.get();
 
-    if (found_title.empty() || found_artist.empty())
-        return false;
+    for (std::size_t offset = 0; offset < html.size() && !scan.done; offset += kParseChunk) {
+        const auto length = std::min(kParseChunk, html.size() - offset);
+        htmlParseChunk(parser.get(), html.data() + offset, static_cast<int>(length), 0);
+    }
+    if (!scan.done) {
+        htmlParseChunk(parser.get(), nullptr, 0, 1);
+    }
 
-    // Titles carry source-appended decoration ("… (Remastered)"), so allow a substring match there;
-    // artists don't, so hold them to the ratio to avoid pulling in "X" against "X Tribute".
-    return fuzzyMatch(found_title, target_title, /*allowSubstring=*/true) &&
-           fuzzyMatch(found_artist, target_artist);
+    SearchResult r;
+    if (scan.best) {
+        r.confidence = static_cast<std::uint8_t>(scan.bestScore);
+        r.web_url = scan.best->href;
+        if (!scan.best->srcset.empty()) {
+            r.image_url = artworkFromSrcset(scan.best->srcset, artwork);
+        }
+    }
+    return r;
 }
 
-xmlNodePtr findMatchingListItem(const xmlNodePtr &node, const std::string &title,
-                                const std::string &artist) {
-    for (xmlNodePtr current = node; current; current = current->next) {
-        if (current->type == XML_ELEMENT_NODE && xmlStrcasecmp(
-                current->name, reinterpret_cast<const xmlChar *>("li"))
-            == 0) {
-            if (trackMatches(current, title, artist)) {
-                return current;
-            }
+/// What marks the script element the page's payload is embedded in.
+constexpr std::string_view kPayloadMarker{R"(id="serialized-server-data")"};
+
+/**
+ * Finds the payload's JSON in a page without parsing the page.
+ * @return The script element's text, or empty if the page carries none.
+ */
+std::string_view findPayload(const std::string_view page) {
+    const auto marker = page.find(kPayloadMarker);
+    if (marker == std::string_view::npos)
+        return {};
+    const auto open = page.find('>', marker);
+    if (open == std::string_view::npos)
+        return {};
+    const auto close = page.find("</script>", open);
+    if (close == std::string_view::npos)
+        return {};
+    return page.substr(open + 1, close - open - 1);
+}
+
+/**
+ * An nlohmann SAX handler that keeps the songs of a payload and nothing else. Each open object
+ * or array is a frame; a value is offered to the few frames above it, and a frame takes it when
+ * the value's path from that frame is one a song's field lives at. A frame that closes holding a
+ * song's title, link and song kind is kept.
+ */
+class PayloadScan {
+public:
+    std::vector<ScrapedSong> songs{};
+
+    bool null() {
+        name();
+        return true;
+    }
+
+    bool boolean(bool) {
+        name();
+        return true;
+    }
+
+    bool number_integer(const Json::number_integer_t value) {
+        number(value);
+        return true;
+    }
+
+    bool number_unsigned(const Json::number_unsigned_t value) {
+        number(static_cast<std::int64_t>(value));
+        return true;
+    }
+
+    bool number_float(Json::number_float_t, const Json::string_t &) {
+        name();
+        return true;
+    }
+
+    bool string(Json::string_t &value) {
+        text(name(), value);
+        return true;
+    }
+
+    bool binary(Json::binary_t &) {
+        name();
+        return true;
+    }
+
+    bool start_object(std::size_t) {
+        open(false);
+        return true;
+    }
+
+    bool key(Json::string_t &value) {
+        _frames.back().pendingKey = std::move(value);
+        return true;
+    }
+
+    bool end_object() {
+        close();
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        open(true);
+        return true;
+    }
+
+    bool end_array() {
+        close();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) {
+        return false; // keep what was read before the fault
+    }
+
+private:
+    struct Frame {
+        std::string key; ///< under which the frame sits in its parent; an index within an array
+        bool array = false;
+        std::size_t nextIndex = 0;
+        std::string pendingKey{};
+        ScrapedSong song{};
+        std::string kind{};
+    };
+
+    /// A song's fields sit at most this many frames below the song.
+    static constexpr std::size_t kReach = 3;
+
+    std::vector<Frame> _frames{};
+
+    /// Takes the name the next value or frame goes by in the innermost frame.
+    std::string name() {
+        if (_frames.empty())
+            return {};
+        auto &top = _frames.back();
+        return top.array ? std::to_string(top.nextIndex++) : std::move(top.pendingKey);
+    }
+
+    void open(const bool array) {
+        Frame frame;
+        frame.key = name();
+        frame.array = array;
+        _frames.push_back(std::move(frame));
+    }
+
+    void close() {
+        auto frame = std::move(_frames.back());
+        _frames.pop_back();
+        auto &song = frame.song;
+        if (song.title.empty() || song.url.empty())
+            return;
+        // The lockups name their kind; failing that, only a song carries a duration.
+        if (frame.kind.empty() ? song.duration.count() <= 0 : frame.kind != "song")
+            return;
+        if (std::ranges::any_of(songs, [&](const ScrapedSong &s) { return s.url == song.url; }))
+            return; // the same song on another shelf of the page
+        songs.push_back(std::move(song));
+    }
+
+    /**
+     * Whether a value named @p leaf sits at @p path below frame @p frame.
+     */
+    [[nodiscard]] bool at(const std::size_t frame, const std::string_view leaf,
+                          const std::initializer_list<std::string_view> path) const {
+        if (frame + path.size() != _frames.size())
+            return false;
+        auto step = path.begin();
+        for (std::size_t i = frame + 1; i < _frames.size(); ++i, ++step) {
+            if (_frames[i].key != *step)
+                return false;
         }
-        if (current->children) {
-            if (xmlNodePtr found = findMatchingListItem(current->children, title, artist)) {
-                return found;
+        return leaf == *step;
+    }
+
+    void text(const std::string &leaf, std::string &value) {
+        // Outermost first: the title of a song's subtitle link is the song's artist, not a title.
+        for (std::size_t i = _frames.size() > kReach ? _frames.size() - kReach : 0;
+             i < _frames.size(); ++i) {
+            auto &frame = _frames[i];
+            auto &song = frame.song;
+            if (at(i, leaf, {"title"}) && song.title.empty()) {
+                song.title = std::move(value);
+            } else if ((at(i, leaf, {"artistName"}) ||
+                        at(i, leaf, {"subtitleLinks", "0", "title"})) && song.artist.empty()) {
+                song.artist = std::move(value);
+            } else if ((at(i, leaf, {"albumName"}) ||
+                        at(i, leaf, {"tertiaryLinks", "0", "title"})) && song.album.empty()) {
+                song.album = std::move(value);
+            } else if (at(i, leaf, {"contentDescriptor", "url"}) && song.url.empty()) {
+                song.url = std::move(value);
+            } else if (at(i, leaf, {"contentDescriptor", "kind"}) && frame.kind.empty()) {
+                frame.kind = std::move(value);
+            } else if (at(i, leaf, {"artwork", "dictionary", "url"}) && song.artwork.empty()) {
+                song.artwork = std::move(value);
+            } else {
+                continue;
             }
+            return;
         }
     }
-    return nullptr;
+
+    void number(const std::int64_t value) {
+        const auto leaf = name();
+        if (_frames.empty())
+            return;
+        if (auto &song = _frames.back().song;
+            (leaf == "duration" || leaf == "durationInMillis") && song.duration.count() == 0) {
+            song.duration = std::chrono::milliseconds{value};
+        }
+    }
+};
+
+/**
+ * What the source offers for one of a payload's songs.
+ */
+SearchResult resultOf(const ScrapedSong &song, const double score, const ArtworkSize &artwork) {
+    SearchResult r;
+    r.confidence = static_cast<std::uint8_t>(score);
+    r.web_url = song.url;
+    if (!song.artwork.empty()) {
+        r.image_url = fillArtwork(song.artwork, artwork);
+    }
+    return r;
+}
+
+/// Confidence the first song listed beside a match is kept with: short of kConfidentMatch, since
+/// it was never searched for. Each place further down the page takes a point off.
+constexpr double kHarvestConfidence{kConfidentMatch - 1};
+
+/// Least confidence a song listed beside a match is kept with, however far down the page it is.
+constexpr double kHarvestFloor{kMatchGenerosity};
+
+/**
+ * Ranks a payload's songs against a track. The closest title and artist wins; between equals,
+ * the closer album. Every other song is handed back as it is listed, with a confidence from its
+ * place on the page, so that a match found by asking for it outranks it.
+ * @return The match's link, artwork and score, or an empty result if none matched; and the rest.
+ */
+SearchHarvest rankSongs(const std::vector<ScrapedSong> &songs, const TrackIdentity &track,
+                        const ArtworkSize &artwork) {
+    const ScrapedSong *best = nullptr;
+    double bestScore = 0;
+    double bestAlbum = 0;
+    for (const auto &song : songs) {
+        const std::string found_title = normalize(song.title);
+        const std::string found_artist = normalize(song.artist);
+        if (found_title.empty() || found_artist.empty())
+            continue;
+        // Same allowance as the markup scan: substrings for titles, the ratio for artists.
+        const double score = std::min(matchScore(found_title, track.title, /*allowSubstring=*/true),
+                                      matchScore(found_artist, track.artist));
+        if (score < kMatchGenerosity || score < bestScore)
+            continue;
+        const double album = track.album.empty() ? 0 : matchScore(normalize(song.album),
+                                                                   track.album);
+        if (score == bestScore && album <= bestAlbum)
+            continue;
+        best = &song;
+        bestScore = score;
+        bestAlbum = album;
+    }
+
+    SearchHarvest harvest;
+    if (best) {
+        harvest.result = resultOf(*best, bestScore, artwork);
+    }
+    for (const auto &song : songs) {
+        if (&song == best)
+            continue;
+        HarvestedSong other;
+        other.identity.title = song.title;
+        other.identity.artist = song.artist;
+        other.identity.album = song.album;
+        const auto place = static_cast<double>(harvest.others.size());
+        other.result = resultOf(song, std::max(kHarvestFloor, kHarvestConfidence - place),
+                                artwork);
+        harvest.others.push_back(std::move(other));
+    }
+    return harvest;
+}
+
+}
+
+std::vector<ScrapedSong> Scraper::payloadSongs(const std::string_view page) {
+    const auto payload = findPayload(page);
+    if (payload.empty())
+        return {};
+    PayloadScan scan;
+    Json::sax_parse(payload.begin(), payload.end(), &scan);
+    return std::move(scan.songs);
 }
 
+SearchResult Scraper::searchTrack(const Track &track, const CallContext &context) {
+    return harvestTrack(track, context).result;
 }
 
-SearchResult Scraper::searchTrack(const Track &track) {
+SearchHarvest Scraper::harvestTrack(const Track &track, const CallContext &context) {
+    const auto curl = searchRequest(track, context);
+    if (!curl)
+        return SearchHarvest{SearchResult{.failed = true}};
+    return read(curl->performCall(), track.identity, _mode, _artwork);
+}
+
+void Scraper::harvestTrackAsync(const Track &track, const CallContext &context,
+                                std::function<void(SearchHarvest)> done) {
+    auto curl = searchRequest(track, context);
+    if (!curl) {
+        done(SearchHarvest{SearchResult{.failed = true}});
+        return;
+    }
+    CurlWrapper::performAsync(
+        std::move(curl), [identity = track.identity, mode = _mode, artwork = _artwork,
+                          done = std::move(done)](const CurlResult &result) {
+            done(read(result, identity, mode, artwork));
+        });
+}
+
+std::unique_ptr<CurlWrapper> Scraper::searchRequest(const Track &track,
+                                                    const CallContext &context) const {
     const std::string term = CurlWrapper::escape(
         track.identity.title + " " + track.identity.album + " " + track.identity.artist);
-    const std::string url = "https://music.apple.com/" + _region + "/search?term=" + term;
+    const std::string url = std::string(kScraperEndpoint) + _region + "/search?term=" + term;
     std::unique_ptr<CurlWrapper> curl = nullptr;
     try {
         curl = std::make_unique<CurlWrapper>(url);
     } catch (const CurlInitError &e) {
         logging::get("scraper")->error("Search for '{} - {}' failed: {}", track.identity.artist,
                                        track.identity.title, e.what());
-        return {};
+        return nullptr;
     }
     curl->setUserAgent();
-    const auto result = curl->performCall();
-    if (!result.okOrWarn("scraper", "Search for '{} - {}'", track.identity.artist,
-                         track.identity.title)) {
-        return {};
-    }
+    curl->setContext(context);
+    return curl;
+}
 
-    const std::unique_ptr<xmlDoc, decltype(&xmlFreeDoc)> doc{
-        htmlReadMemory(result.output.c_str(), static_cast<int>(result.output.size()), nullptr,
-                       nullptr, HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING),
-        &xmlFreeDoc
-    };
-    if (!doc) {
-        logging::get("scraper")->warn("Could not parse the Apple Music page for '{} - {}'",
-                                      track.identity.artist, track.identity.title);
-        return {};
+SearchHarvest Scraper::read(const CurlResult &result, const TrackIdentity &track,
+                            const ScraperMode mode, const ArtworkSize &artwork) {
+    if (!result.okOrWarn("scraper", "Search for '{} - {}'", track.artist, track.title)) {
+        return SearchHarvest{SearchResult{.failed = true}};
     }
+    return parse(result.output, track, mode, artwork);
+}
 
-    SearchResult r;
-    const std::string kTargetSize = "1000x1000bb-60";
-
-    if (xmlNodePtr root = xmlDocGetRootElement(doc.get())) {
-        if (xmlNodePtr search_root = findDivWithClass(root, "desktop-search-page")) {
-            if (xmlNodePtr li_node = findMatchingListItem(search_root, track.identity.title,
-                                                          track.identity.artist)) {
-                xmlNodePtr anchor_node = findDescendantWithAttr(
-                    li_node, "a", "data-testid", "click-action");
-                r.web_url = getAttribute(anchor_node, "href");
-
-                xmlNodePtr source_node = findDescendantWithAttr(
-                    li_node, "source", "type", "image/jpeg");
-                if (std::string srcset = getAttribute(source_node, "srcset"); !srcset.empty()) {
-                    std::regex url_regex(R"((https?://[^ ,]+))");
-                    if (std::smatch match; std::regex_search(srcset, match, url_regex)) {
-                        std::string image_url = match[1];
-
-                        std::regex size_regex(R"((\d+x\d+bb-\d+))");
-                        if (std::smatch size_match; std::regex_search(
-                            image_url, size_match, size_regex)) {
-                            r.image_url = std::regex_replace(image_url, size_regex, kTargetSize);
-                        } else {
-                            // If no size component is found, use the original URL
-                            r.image_url = image_url;
-                        }
-                    }
-                }
-            }
+SearchHarvest Scraper::parse(const std::string_view page, const TrackIdentity &track,
+                             const ScraperMode mode, const ArtworkSize &artwork) {
+    if (mode == ScraperMode::Payload) {
+        if (const auto songs = payloadSongs(page); !songs.empty()) {
+            return rankSongs(songs, track, artwork);
         }
+        logging::get("scraper")->debug("No payload on the Apple Music page for '{} - {}', "
+                                       "reading the markup", track.artist, track.title);
     }
 
-    return r;
-}
\ No newline at end of file
+    auto r = parsePage(page, track, artwork);
+    if (!r) {
+        logging::get("scraper")->warn("Could not parse the Apple Music page for '{} - {}'",
+                                      track.artist, track.title);
+        return SearchHarvest{SearchResult{.failed = true}};
+    }
+    return SearchHarvest{*r};
+}
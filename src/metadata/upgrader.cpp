@@ -0,0 +1,72 @@
+/**
+ * @file upgrader.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "metadata/upgrader.hpp"
+#include "metadata/cache_codec.hpp"
+#include "log/log.hpp"
+
+#include <utility>
+
+namespace {
+/// The state row the walk's place in the cache is kept under: the trackKey() last tried.
+constexpr std::string_view kCursorState{"upgrader|cursor"};
+}
+
+CacheUpgrader::CacheUpgrader(MetadataCache &cache, const Enricher &enricher,
+                             const UpgradeSchedule &schedule)
+    : _cache(cache), _enricher(enricher), _schedule(schedule),
+      _thread{[this](std::stop_token stop) { walk(std::move(stop)); }} {
+}
+
+CacheUpgrader::~CacheUpgrader() = default;
+
+std::size_t CacheUpgrader::upgraded() const {
+    return _upgraded.load();
+}
+
+void CacheUpgrader::walk(const std::stop_token &stop) {
+    const auto log = logging::get("enricher");
+    std::string cursor = _cache.readState(kCursorState).value_or("");
+    std::size_t tried = 0;
+
+    while (rest(stop, _schedule.interval)) {
+        const auto next = _cache.findUpgradeable(cursor, 1);
+        if (next.empty()) {
+            // The end of the cache: start over from the first row after a rest.
+            if (!cursor.empty() || tried > 0) {
+                log->debug("Upgrade pass done after {} candidate(s)", tried);
+            }
+            cursor.clear();
+            tried = 0;
+            _cache.writeState(kCursorState, cursor);
+            if (!rest(stop, _schedule.rest)) {
+                return;
+            }
+            continue;
+        }
+
+        const auto &candidate = next.front();
+        cursor = cache_codec::trackKey(candidate.track);
+        ++tried;
+        try {
+            const CallContext context{.stop = stop, .priority = CallPriority::Bulk};
+            if (_enricher.upgrade(candidate.track, context)) {
+                _upgraded.fetch_add(1);
+            }
+        } catch (const std::exception &e) {
+            log->warn("Upgrading '{} - {}' threw: {}", candidate.track.identity.artist,
+                      candidate.track.identity.title, e.what());
+        }
+        _cache.writeState(kCursorState, cursor);
+    }
+}
+
+bool CacheUpgrader::rest(const std::stop_token &stop, const std::chrono::milliseconds duration) {
+    std::unique_lock lock{_mutex};
+    // Nothing but the stop request wakes the walk early.
+    return !_wake.wait_for(lock, stop, duration, [] { return false; }) &&
+           !stop.stop_requested();
+}
@@ -5,14 +5,12 @@
  */
 
 #include <memory>
-#include <nlohmann/json.hpp>
 #include "metadata/uploaders/imgur.hpp"
 
 #include "metadata/http/curlWrapper.hpp"
+#include "metadata/http/jsonSelect.hpp"
 #include "log/log.hpp"
 
-using Json = nlohmann::json;
-
 Imgur::Imgur(const std::string &apikey) {
     _apikey = apikey;
 }
@@ -21,7 +19,8 @@ std::string Imgur::identify() {
     return kIDENTITY;
 }
 
-UploadResult Imgur::uploadImage(const std::vector<unsigned char> &bytes, ImageType type) {
+UploadResult Imgur::uploadImage(const std::vector<unsigned char> &bytes, ImageType type,
+                                const CallContext &context) {
     const auto &logger = logging::get("imgur");
 
     std::unique_ptr<CurlWrapper> curl = nullptr;
@@ -29,30 +28,39 @@ UploadResult Imgur::uploadImage(const std::vector<unsigned char> &bytes, ImageTy
         curl = std::make_unique<CurlWrapper>("https://api.imgur.com/3/image");
     } catch (const CurlInitError &e) {
         logger->error("Skipping upload of {} byte(s): {}", bytes.size(), e.what());
-        return {};
+        return UploadResult{.failed = true};
     }
     curl->addHeader("Authorization: Client-ID " + _apikey);
     curl->addMime(bytes, "image");
+    curl->setContext(context);
     const auto r = curl->performCall();
 
     // Most often a bad/rate-limited client ID
     if (!r.okOrWarn("imgur", "Upload of {} byte(s)", bytes.size())) {
-        return {};
+        return UploadResult{.failed = true};
     }
 
-    try {
-        if (Json j = Json::parse(r.output); j["success"] == true) {
-            if (!j["data"].contains("link") || !j["data"]["link"].is_string()) {
-                logger->warn("Upload succeeded but the response carried no image link");
-                return {};
-            }
-            return UploadResult{j["data"]["link"]};
+    static const json_select::Selector kSelector{"/success", "/data/link"};
+    bool success = false;
+    std::string link;
+    const bool parsed = json_select::select(r.output, kSelector, [&](const json_select::Match &m) {
+        if (m.pointer == 0) {
+            success = m.value.kind == json_select::Value::Kind::Boolean && m.value.boolean;
+        } else if (m.value.kind == json_select::Value::Kind::String) {
+            link = m.value.string;
         }
-
+    });
+    if (!parsed) {
+        logger->warn("Malformed upload response: {}", r.briefBody());
+        return UploadResult{.failed = true};
+    }
+    if (!success) {
         logger->warn("Imgur rejected the upload: {}", r.briefBody());
-        return {};
-    } catch (const Json::exception &e) {
-        logger->warn("Malformed upload response: {}", e.what());
-        return {};
+        return UploadResult{.failed = true};
+    }
+    if (link.empty()) {
+        logger->warn("Upload succeeded but the response carried no image link");
+        return UploadResult{.failed = true};
     }
+    return UploadResult{link};
 }
\ No newline at end of file
@@ -8,8 +8,14 @@
 #include "orchestrator/scrobble_driver.hpp"
 
 #include <chrono>
+#include <mutex>
 #include <utility>
 
+Orchestrator::~Orchestrator() {
+    // Lets an enrichment still sitting in the worker's queue bail out instead of making its calls.
+    _enrichment.request_stop();
+}
+
 void Orchestrator::registerEnricher(std::unique_ptr<Enricher> enricher) {
     _enricher = std::move(enricher);
 }
@@ -18,6 +24,10 @@ void Orchestrator::registerScrobbler(std::shared_ptr<Scrobbler> scrobbler) {
     _scrobbles.registerScrobbler(std::move(scrobbler));
 }
 
+void Orchestrator::registerScrobbleJournal(std::unique_ptr<ScrobbleJournal> journal) {
+    _scrobbles.registerJournal(std::move(journal));
+}
+
 void Orchestrator::registerPoller(std::unique_ptr<Poller> poller) {
     _poller = std::move(poller);
 }
@@ -26,6 +36,10 @@ void Orchestrator::registerRichPresence(std::unique_ptr<Presence> discord) {
     _discord = std::move(discord);
 }
 
+void Orchestrator::registerWakeup(std::function<void()> wakeup) {
+    _wakeup = std::move(wakeup);
+}
+
 bool Orchestrator::isRestart(const Track &track) const {
     return track.timing.current() + kRestartThreshold < _position;
 }
@@ -35,6 +49,8 @@ void Orchestrator::clearTrack() {
         return; // Nothing was being presented, so there is nothing to tear down.
     }
     _log->info("Playback ended");
+    _enrichment.request_stop();
+    _enrichment = std::stop_source{};
     _current = {};
     _position = std::chrono::nanoseconds::zero();
     _scrobbles.reset();
@@ -59,6 +75,48 @@ void Orchestrator::updatePauseDetails() {
     _log->debug("Playback paused");
 }
 
+void Orchestrator::startEnrichment(const Track &track,
+                                   std::optional<std::vector<unsigned char> > thumbnail) {
+    // Whatever the previous track's enrichment finds no longer describes what is playing.
+    _enrichment.request_stop();
+    _enrichment = std::stop_source{};
+    if (!_enricher) {
+        return;
+    }
+
+    _enrichments.submit([this, enricher = _enricher.get(), token = _enrichment.get_token(), track,
+        thumbnail = std::move(thumbnail)] {
+        if (token.stop_requested()) {
+            return; // The track changed while this sat in the queue.
+        }
+        auto enriched = enricher->enrich(track, thumbnail,
+                                         std::chrono::steady_clock::now() + kEnrichBudget); {
+            std::lock_guard lock{_enrichedMutex};
+            _enriched.push_back(Enrichment{.track = token, .enriched = std::move(enriched)});
+        }
+        if (_wakeup) {
+            _wakeup();
+        }
+    });
+}
+
+void Orchestrator::drainEnrichments() {
+    std::vector<Enrichment> landed; {
+        std::lock_guard lock{_enrichedMutex};
+        landed.swap(_enriched);
+    }
+    for (auto &[track, enriched] : landed) {
+        if (track.stop_requested()) {
+            continue; // Made for a track the user has since moved on from.
+        }
+        // Only the metadata is taken: timing, status and pause are fresher on this cycle's poll.
+        _current.image = std::move(enriched.image);
+        _current.songUrls = std::move(enriched.songUrls);
+        _log->debug("Enrichment landed for '{}' by '{}'", _current.track.identity.title,
+                    _current.track.identity.artist);
+    }
+}
+
 void Orchestrator::run() {
     if (!_poller) {
         return;
@@ -73,8 +131,10 @@ void Orchestrator::run() {
     }
 
     if (track.identity != _current.track.identity) {
-        _current = _enricher ? _enricher->enrich(track, image) : EnrichedTrack{.track = track};
-        _current.pause.since.reset();
+        // Published bare straight away; the metadata follows once the enrichment lands, so the
+        // presence never shows the previous track while the network is slow.
+        _current = EnrichedTrack{.track = track};
+        startEnrichment(track, std::move(image));
         _scrobbles.reset();
         _log->info("Track change: '{}' by '{}' ({})", _current.track.identity.title,
                    _current.track.identity.artist, _current.track.identity.album);
@@ -92,6 +152,7 @@ void Orchestrator::run() {
     }
     _position = _current.track.timing.current();
 
+    drainEnrichments();
     updatePauseDetails();
     _scrobbles.tick(_current.track);
 
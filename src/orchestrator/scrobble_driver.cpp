@@ -18,6 +18,7 @@ ScrobbleDriver::ScrobbleDriver(const ScrobbleSchedule &schedule) : _schedule(sch
 ScrobbleDriver::~ScrobbleDriver() {
     // Lets an attempt still sitting in the worker's queue bail out instead of making its call.
     _play.request_stop();
+    _lifetime.request_stop();
 }
 
 void ScrobbleDriver::registerScrobbler(std::shared_ptr<Scrobbler> scrobbler) {
@@ -25,16 +26,28 @@ void ScrobbleDriver::registerScrobbler(std::shared_ptr<Scrobbler> scrobbler) {
     _targets.push_back(Target{
         .scrobbler = std::move(scrobbler),
         .nowPlaying = {.nextAttempt = now},
-        .scrobble = {.nextAttempt = now}
+        .scrobble = {.nextAttempt = now},
+        .replay = {.nextAttempt = now}
     });
 }
 
+void ScrobbleDriver::registerJournal(std::unique_ptr<ScrobbleJournal> journal) {
+    _journal = std::move(journal);
+}
+
 ScrobbleDriver::Pending &ScrobbleDriver::slotFor(Target &target, const Attempt kind) {
     return kind == Attempt::NowPlaying ? target.nowPlaying : target.scrobble;
 }
 
 const char *ScrobbleDriver::name(const Attempt kind) {
-    return kind == Attempt::NowPlaying ? "now-playing update" : "scrobble";
+    switch (kind) {
+    case Attempt::NowPlaying:
+        return "now-playing update";
+    case Attempt::Scrobble:
+        return "scrobble";
+    default:
+        return "journal replay";
+    }
 }
 
 bool ScrobbleDriver::scrobbleThresholdMet(const Track &track) {
@@ -55,12 +68,19 @@ void ScrobbleDriver::reset() {
     for (auto &target: _targets) {
         target.nowPlaying = Pending{.nextAttempt = now};
         target.scrobble = Pending{.nextAttempt = now};
+        // The play's entry, if it has not been scrobbled, is left for the replay to pick up.
+        target.journaled = false;
+        target.entry.reset();
     }
 }
 
 void ScrobbleDriver::tick(const Track &current) {
     drainResults();
     driveAttempts(current);
+    if (_journal) {
+        // Whatever this cycle recorded and acknowledged goes to disk in one write.
+        _journal->sync();
+    }
 }
 
 void ScrobbleDriver::drainResults() {
@@ -69,6 +89,16 @@ void ScrobbleDriver::drainResults() {
         results.swap(_results);
     }
     for (const auto &result: results) {
+        if (result.entry) {
+            _targets[result.target].carried.erase(*result.entry);
+        }
+        if (_journal) {
+            _journal->acknowledge(result.scrobbled);
+        }
+        if (result.kind == Attempt::Replay) {
+            applyReplay(result);
+            continue;
+        }
         if (!result.play.stop_requested()) {
             applyResult(result);
             continue;
@@ -119,6 +149,84 @@ void ScrobbleDriver::applyResult(const AttemptResult &result) {
                 target.scrobbler->identify(), retry.count());
 }
 
+void ScrobbleDriver::applyReplay(const AttemptResult &result) {
+    auto &target = _targets[result.target];
+    target.replay.phase = Phase::Waiting;
+    if (!result.scrobbled.empty()) {
+        _log->info("Scrobbled {} journaled play(s) at {}", result.scrobbled.size(),
+                   target.scrobbler->identify());
+    }
+    if (result.accepted) {
+        target.replay.nextAttempt = std::chrono::steady_clock::now();
+        return;
+    }
+    target.replay.nextAttempt = std::chrono::steady_clock::now() + _schedule.scrobbleRetry;
+    _log->debug("Rejected {} at {}, retrying in {}ms", name(result.kind),
+                target.scrobbler->identify(), _schedule.scrobbleRetry.count());
+}
+
+void ScrobbleDriver::journalPlay(Target &target, const Track &current) {
+    if (!_journal || target.journaled || target.scrobble.phase == Phase::Done ||
+        !scrobbleThresholdMet(current)) {
+        return;
+    }
+    target.journaled = true;
+    target.entry = _journal->record(target.scrobbler->identify(), current);
+    if (!target.entry) {
+        // The same play, already scrobbled before it was interrupted and picked up again.
+        target.scrobble.phase = Phase::Done;
+        _log->debug("'{}' by '{}' was already scrobbled at {}", current.identity.title,
+                    current.identity.artist, target.scrobbler->identify());
+    }
+}
+
+void ScrobbleDriver::driveReplay(const std::size_t index) {
+    auto &target = _targets[index];
+    if (target.replay.phase != Phase::Waiting ||
+        std::chrono::steady_clock::now() < target.replay.nextAttempt ||
+        target.scrobble.phase == Phase::InFlight) {
+        return;
+    }
+    auto batch = _journal->pending(target.scrobbler->identify(),
+                                   kJournalBatch + 1 + target.carried.size());
+    std::erase_if(batch, [&target](const JournalEntry &entry) {
+        return entry.id == target.entry || target.carried.contains(entry.id);
+    });
+    if (batch.size() > kJournalBatch) {
+        batch.resize(kJournalBatch);
+    }
+    if (batch.empty()) {
+        return;
+    }
+    target.replay.phase = Phase::InFlight;
+
+    _worker.submit([this, index, batch = std::move(batch), lifetime = _lifetime.get_token(),
+        scrobbler = target.scrobbler] {
+        if (lifetime.stop_requested()) {
+            return;
+        }
+        std::vector<Track> tracks;
+        tracks.reserve(batch.size());
+        for (const auto &entry: batch) {
+            tracks.push_back(entry.track());
+        }
+        const auto statuses = scrobbler->scrobbleBatch(tracks);
+
+        AttemptResult result{.target = index, .kind = Attempt::Replay, .accepted = true};
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            // A play the scrobbler ignored (too old, a filtered artist) would be ignored again,
+            // so it is let go as well. A failed one is kept, in order, for the next try.
+            if (i < statuses.size() && statuses[i] != ScrobbleStatus::Failed) {
+                result.scrobbled.push_back(batch[i].id);
+            } else {
+                result.accepted = false;
+            }
+        }
+        std::lock_guard lock{_resultsMutex};
+        _results.push_back(std::move(result));
+    });
+}
+
 void ScrobbleDriver::driveAttempts(const Track &current) {
     const auto now = std::chrono::steady_clock::now();
     for (std::size_t index = 0; index < _targets.size(); ++index) {
@@ -126,6 +234,10 @@ void ScrobbleDriver::driveAttempts(const Track &current) {
         if (!target.scrobbler->authed()) {
             continue;
         }
+        journalPlay(target, current);
+        if (_journal) {
+            driveReplay(index);
+        }
         for (const auto kind: {Attempt::NowPlaying, Attempt::Scrobble}) {
             auto &pending = slotFor(target, kind);
 
@@ -146,6 +258,10 @@ void ScrobbleDriver::driveAttempts(const Track &current) {
             if (kind == Attempt::Scrobble && !scrobbleThresholdMet(current)) {
                 continue;
             }
+            // Nor is a scrobbler handed a scrobble while it works through a replay.
+            if (kind == Attempt::Scrobble && target.replay.phase == Phase::InFlight) {
+                continue;
+            }
             // A now-playing update announces the track as being listened to right now, so it is held
             // while paused — the initial send just as much as the refresh guarded above. A play that
             // begins paused stays silent until it resumes.
@@ -161,20 +277,38 @@ void ScrobbleDriver::driveAttempts(const Track &current) {
 
 void ScrobbleDriver::submitAttempt(const std::size_t target, const Attempt kind,
                                    const Track &track) {
-    _worker.submit([this, target, kind, play = _play.get_token(), track,
+    const auto entry = kind == Attempt::Scrobble ? _targets[target].entry : std::nullopt;
+    if (entry) {
+        _targets[target].carried.insert(*entry);
+    }
+    _worker.submit([this, target, kind, play = _play.get_token(), track, entry,
         scrobbler = _targets[target].scrobbler] {
         if (play.stop_requested()) {
-            return; // The play ended while this attempt sat in the queue.
+            // The play ended while this attempt sat in the queue. A journaled play is still
+            // reported, so its entry is released to the replay.
+            if (entry) {
+                std::lock_guard lock{_resultsMutex};
+                _results.push_back(AttemptResult{
+                    .play = play, .identity = track.identity, .target = target, .kind = kind,
+                    .entry = entry
+                });
+            }
+            return;
         }
         const bool accepted =
                 kind == Attempt::NowPlaying ? scrobbler->setPlaying(track) : scrobbler->scrobble(track);
-        std::lock_guard lock{_resultsMutex};
-        _results.push_back(AttemptResult{
+        AttemptResult result{
             .play = play,
             .identity = track.identity,
             .target = target,
             .kind = kind,
-            .accepted = accepted
-        });
+            .accepted = accepted,
+            .entry = entry
+        };
+        if (accepted && entry) {
+            result.scrobbled.push_back(*entry);
+        }
+        std::lock_guard lock{_resultsMutex};
+        _results.push_back(std::move(result));
     });
 }
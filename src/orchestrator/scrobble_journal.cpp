@@ -0,0 +1,369 @@
+/**
+ * @file scrobble_journal.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "orchestrator/scrobble_journal.hpp"
+#include "log/log.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <ranges>
+#include <string_view>
+#include <system_error>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+/// Opens every journal file, so a file that is something else is never read as one.
+constexpr std::string_view kMagic{"MPSJ\x01", 5};
+
+/// Put, with the time, after the name of a file that is not a journal as it is moved aside.
+constexpr std::string_view kSetAsideSuffix{".unreadable-"};
+
+/// Kinds of record. On disk: never reorder or remove one.
+enum class RecordKind : std::uint8_t {
+    Play = 1,
+    Ack = 2,
+};
+
+/// A record longer than this is taken as a torn length, not a record.
+constexpr std::uint32_t kMaxRecord = 1u << 20;
+
+constexpr std::array<std::uint32_t, 256> kCrcTable = [] {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < table.size(); ++i) {
+        std::uint32_t c = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}();
+
+/// CRC-32 (IEEE), as zlib computes it.
+std::uint32_t crc32(const std::string_view data) {
+    std::uint32_t c = 0xFFFFFFFFu;
+    for (const unsigned char byte : data) {
+        c = kCrcTable[(c ^ byte) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+template<typename T>
+void put(std::string &buf, const T value) {
+    buf.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void putString(std::string &buf, const std::string &value) {
+    put(buf, static_cast<std::uint32_t>(value.size()));
+    buf += value;
+}
+
+template<typename T>
+bool read(const std::string_view buf, std::size_t &offset, T &out) {
+    if (offset + sizeof(T) > buf.size())
+        return false;
+    std::memcpy(&out, buf.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+bool readString(const std::string_view buf, std::size_t &offset, std::string &out) {
+    std::uint32_t length = 0;
+    if (!read(buf, offset, length) || offset + length > buf.size())
+        return false;
+    out.assign(buf.data() + offset, length);
+    offset += length;
+    return true;
+}
+
+/// Frames a payload as a record: its length, then its CRC-32, then the payload.
+void putRecord(std::string &buf, const std::string &payload) {
+    put(buf, static_cast<std::uint32_t>(payload.size()));
+    put(buf, crc32(payload));
+    buf += payload;
+}
+
+std::string playPayload(const JournalEntry &entry) {
+    std::string payload;
+    put(payload, RecordKind::Play);
+    put(payload, entry.id);
+    put(payload, entry.timestamp);
+    put(payload, static_cast<std::int64_t>(entry.length.count()));
+    putString(payload, entry.target);
+    putString(payload, entry.identity.title);
+    putString(payload, entry.identity.artist);
+    putString(payload, entry.identity.album);
+    return payload;
+}
+
+std::optional<JournalEntry> parsePlay(const std::string_view payload, std::size_t offset) {
+    JournalEntry entry;
+    std::int64_t length = 0;
+    if (!read(payload, offset, entry.id) || !read(payload, offset, entry.timestamp) ||
+        !read(payload, offset, length) || !readString(payload, offset, entry.target) ||
+        !readString(payload, offset, entry.identity.title) ||
+        !readString(payload, offset, entry.identity.artist) ||
+        !readString(payload, offset, entry.identity.album)) {
+        return std::nullopt;
+    }
+    entry.length = std::chrono::milliseconds{length};
+    return entry;
+}
+
+/// Flushes a file through the OS's cache to the disk.
+bool flushToDisk(std::FILE *file) {
+    if (std::fflush(file) != 0)
+        return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+std::int64_t ticks(const std::chrono::steady_clock::time_point point) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(point.time_since_epoch()).count();
+}
+} // namespace
+
+Track JournalEntry::track() const {
+    Track track;
+    track.identity = identity;
+    track.status = Stopped;
+    // TrackTiming runs on the steady clock, which does not survive a restart; the play's wall time
+    // is carried over as the same distance into the past.
+    const auto ago = std::chrono::system_clock::now() -
+                     std::chrono::sys_seconds{std::chrono::seconds{timestamp}};
+    const auto start = std::chrono::steady_clock::now() -
+                       std::chrono::duration_cast<std::chrono::steady_clock::duration>(ago);
+    track.timing.set(ticks(start), ticks(start + length));
+    return track;
+}
+
+ScrobbleJournal::ScrobbleJournal(std::filesystem::path path) : _path(std::move(path)) {
+    if (_path.empty()) {
+        return;
+    }
+    std::error_code ec;
+    create_directories(_path.parent_path(), ec);
+    load();
+}
+
+ScrobbleJournal::~ScrobbleJournal() {
+    sync();
+    if (_file) {
+        std::fclose(_file);
+    }
+}
+
+void ScrobbleJournal::load() {
+    std::string data;
+    if (std::ifstream in(_path, std::ios::binary); in) {
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Set when the file has to be written afresh: it is new, not a journal, or has a torn tail.
+    bool rewrite = false;
+    std::size_t offset = 0;
+    if (data.empty()) {
+        rewrite = true;
+    } else if (!std::string_view(data).starts_with(kMagic)) {
+        // Something else, or a journal this build cannot read: it may still hold plays owed, so it
+        // is moved aside for a look rather than written over.
+        auto aside = _path;
+        aside += std::string(kSetAsideSuffix) +
+                std::to_string(std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count());
+        std::error_code ec;
+        std::filesystem::rename(_path, aside, ec);
+        if (ec) {
+            logging::get("scrobbler")->error("{} is not a scrobble journal and could not be moved "
+                                             "aside ({}), plays are kept in memory only",
+                                             _path.string(), ec.message());
+            _path.clear();
+            return;
+        }
+        logging::get("scrobbler")->warn("{} is not a scrobble journal, moved it to {} and "
+                                        "started a new one", _path.string(), aside.string());
+        rewrite = true;
+        offset = data.size();
+    } else {
+        offset = kMagic.size();
+    }
+
+    while (!rewrite && offset < data.size()) {
+        std::uint32_t length = 0;
+        std::uint32_t crc = 0;
+        std::size_t at = offset;
+        if (!read(data, at, length) || !read(data, at, crc) || length > kMaxRecord ||
+            at + length > data.size()) {
+            rewrite = true;
+            break;
+        }
+        const std::string_view payload(data.data() + at, length);
+        std::size_t cursor = 0;
+        RecordKind kind{};
+        if (crc32(payload) != crc || !read(payload, cursor, kind)) {
+            rewrite = true;
+            break;
+        }
+        if (kind == RecordKind::Play) {
+            auto entry = parsePlay(payload, cursor);
+            if (!entry) {
+                rewrite = true;
+                break;
+            }
+            _nextId = std::max(_nextId, entry->id + 1);
+            _seen.emplace(std::pair{entry->target, entry->timestamp}, entry->id);
+            _pending.emplace(entry->id, std::move(*entry));
+        } else if (kind == RecordKind::Ack) {
+            std::uint64_t id = 0;
+            while (read(payload, cursor, id)) {
+                _dead += _pending.erase(id);
+            }
+            ++_dead;
+        }
+        // A kind this build does not know is skipped: its length still frames it.
+        offset = at + length;
+    }
+
+    if (rewrite && offset < data.size()) {
+        logging::get("scrobbler")->warn("Dropped {} torn byte(s) from the end of {}",
+                                        data.size() - offset, _path.string());
+    }
+    if (!_pending.empty()) {
+        logging::get("scrobbler")->info("{} play(s) waiting to be scrobbled", _pending.size());
+    }
+    if (rewrite || _dead >= kJournalCompactAfter) {
+        compact();
+    } else {
+        openForAppend();
+    }
+}
+
+void ScrobbleJournal::openForAppend() {
+    _file = std::fopen(_path.string().c_str(), "ab");
+    if (!_file) {
+        logging::get("scrobbler")->error("Could not open scrobble journal {}, plays are kept "
+                                         "in memory only", _path.string());
+    }
+}
+
+void ScrobbleJournal::compact() {
+    if (_file) {
+        std::fclose(_file);
+        _file = nullptr;
+    }
+    auto temp = _path;
+    temp += ".tmp";
+
+    std::string contents{kMagic};
+    for (const auto &entry : _pending | std::views::values) {
+        putRecord(contents, playPayload(entry));
+    }
+    std::FILE *out = std::fopen(temp.string().c_str(), "wb");
+    const bool written = out && std::fwrite(contents.data(), 1, contents.size(), out) ==
+                         contents.size() && flushToDisk(out);
+    if (out) {
+        std::fclose(out);
+    }
+    std::error_code ec;
+    if (written) {
+        std::filesystem::rename(temp, _path, ec);
+    }
+    if (!written || ec) {
+        logging::get("scrobbler")->warn("Could not compact scrobble journal {}", _path.string());
+    } else {
+        _dead = 0;
+    }
+    openForAppend();
+}
+
+std::optional<std::uint64_t> ScrobbleJournal::record(const std::string &target,
+                                                     const Track &track) {
+    const auto timestamp = track.timing.start();
+    const auto [seen, added] = _seen.emplace(std::pair{target, timestamp}, _nextId);
+    if (!added) {
+        if (_pending.contains(seen->second)) {
+            return seen->second;
+        }
+        return std::nullopt;
+    }
+    JournalEntry entry{
+        .id = _nextId++,
+        .target = target,
+        .identity = track.identity,
+        .timestamp = timestamp,
+        .length = std::chrono::duration_cast<std::chrono::milliseconds>(track.timing.total())
+    };
+    putRecord(_unsynced, playPayload(entry));
+    const auto id = entry.id;
+    _pending.emplace(id, std::move(entry));
+    return id;
+}
+
+void ScrobbleJournal::acknowledge(const std::span<const std::uint64_t> ids) {
+    std::string payload;
+    put(payload, RecordKind::Ack);
+    std::size_t acknowledged = 0;
+    for (const auto id : ids) {
+        if (_pending.erase(id) != 0) {
+            put(payload, id);
+            ++acknowledged;
+        }
+    }
+    if (acknowledged == 0) {
+        return;
+    }
+    putRecord(_unsynced, payload);
+    _dead += acknowledged + 1;
+}
+
+std::vector<JournalEntry> ScrobbleJournal::pending(const std::string &target,
+                                                   const std::size_t limit) const {
+    std::vector<JournalEntry> entries;
+    for (const auto &entry : _pending | std::views::values) {
+        if (entries.size() >= limit) {
+            break;
+        }
+        if (entry.target == target) {
+            entries.push_back(entry);
+        }
+    }
+    return entries;
+}
+
+std::size_t ScrobbleJournal::size() const {
+    return _pending.size();
+}
+
+void ScrobbleJournal::sync() {
+    if (_unsynced.empty()) {
+        return;
+    }
+    bool written = true;
+    if (_file) {
+        written = std::fwrite(_unsynced.data(), 1, _unsynced.size(), _file) == _unsynced.size() &&
+                  flushToDisk(_file);
+        if (!written) {
+            logging::get("scrobbler")->warn("Could not write scrobble journal {}",
+                                            _path.string());
+        }
+    }
+    _unsynced.clear();
+    // A failed append may have left part of a record behind, which would hide every record after
+    // it; the rewrite puts the whole of what is outstanding back.
+    if (!_path.empty() && (!written || _dead >= kJournalCompactAfter)) {
+        compact();
+    }
+}
@@ -6,21 +6,31 @@
 
 #include "orchestrator/worker.hpp"
 
+#include <algorithm>
 #include <utility>
 
-Worker::Worker() : _thread{[this](std::stop_token stop) { drain(std::move(stop)); }} {
+WorkerPool::WorkerPool(const std::size_t threads) {
+    _threads.reserve(std::max<std::size_t>(threads, 1));
+    for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); ++i) {
+        _threads.emplace_back([this](std::stop_token stop) { drain(std::move(stop)); });
+    }
 }
 
-Worker::~Worker() = default;
+WorkerPool::~WorkerPool() {
+    // Ask every thread at once, so none waits on another's join before it starts winding down.
+    for (auto &thread : _threads) {
+        thread.request_stop();
+    }
+}
 
-void Worker::submit(std::function<void()> job) { {
+void WorkerPool::submit(std::function<void()> job) { {
         std::lock_guard lock{_mutex};
         _jobs.push_back(std::move(job));
     }
     _queued.notify_one();
 }
 
-void Worker::drain(const std::stop_token &stop) {
+void WorkerPool::drain(const std::stop_token &stop) {
     while (true) {
         std::function < void() > job; {
             std::unique_lock lock{_mutex};
@@ -0,0 +1,141 @@
+/**
+ * @file md5.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "security/md5.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace {
+/// Per-round shift amounts.
+constexpr std::array<std::uint32_t, 64> kShifts = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+/// floor(abs(sin(i + 1)) * 2^32), as tabled in RFC 1321.
+constexpr std::array<std::uint32_t, 64> kSines = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613,
+    0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193,
+    0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d,
+    0x02441453, 0xd8a1e681, 0xe7d3fbc8, 0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+    0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122,
+    0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+    0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665, 0xf4292244,
+    0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb,
+    0xeb86d391,
+};
+
+std::uint32_t loadLittleEndian(const std::uint8_t *bytes) {
+    return static_cast<std::uint32_t>(bytes[0]) | static_cast<std::uint32_t>(bytes[1]) << 8 |
+           static_cast<std::uint32_t>(bytes[2]) << 16 | static_cast<std::uint32_t>(bytes[3]) << 24;
+}
+} // namespace
+
+Md5::Md5() : _state{0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476} {
+}
+
+Md5 &Md5::update(const std::string_view data) {
+    const auto *in = reinterpret_cast<const std::uint8_t *>(data.data());
+    std::size_t remaining = data.size();
+    auto buffered = static_cast<std::size_t>(_length % 64);
+    _length += remaining;
+
+    // Top up a partly filled block first.
+    if (buffered != 0) {
+        const auto take = std::min(remaining, 64 - buffered);
+        std::memcpy(_buffer.data() + buffered, in, take);
+        in += take;
+        remaining -= take;
+        buffered += take;
+        if (buffered < 64) {
+            return *this;
+        }
+        transform(_buffer.data());
+    }
+    // Whole blocks are hashed straight from the input.
+    for (; remaining >= 64; in += 64, remaining -= 64) {
+        transform(in);
+    }
+    if (remaining != 0) {
+        std::memcpy(_buffer.data(), in, remaining);
+    }
+    return *this;
+}
+
+std::array<std::uint8_t, 16> Md5::digest() {
+    const std::uint64_t bits = _length * 8;
+
+    // A 1 bit, zeros up to 8 bytes short of a block, then the input's length in bits.
+    std::array<std::uint8_t, 72> padding{0x80};
+    const auto buffered = static_cast<std::size_t>(_length % 64);
+    const std::size_t padLength = buffered < 56 ? 56 - buffered : 120 - buffered;
+    update({reinterpret_cast<const char *>(padding.data()), padLength});
+    for (int i = 0; i < 8; ++i) {
+        padding[i] = static_cast<std::uint8_t>(bits >> (8 * i));
+    }
+    update({reinterpret_cast<const char *>(padding.data()), 8});
+
+    std::array<std::uint8_t, 16> out{};
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        out[i] = static_cast<std::uint8_t>(_state[i / 4] >> (8 * (i % 4)));
+    }
+    return out;
+}
+
+Md5::Hex Md5::hexDigest() {
+    constexpr std::string_view kDigits{"0123456789abcdef"};
+    Hex hex{};
+    const auto bytes = digest();
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        hex[2 * i] = kDigits[bytes[i] >> 4];
+        hex[2 * i + 1] = kDigits[bytes[i] & 0x0F];
+    }
+    return hex;
+}
+
+Md5::Hex Md5::hex(const std::string_view data) {
+    return Md5{}.update(data).hexDigest();
+}
+
+void Md5::transform(const std::uint8_t *block) {
+    std::array<std::uint32_t, 16> words{};
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        words[i] = loadLittleEndian(block + 4 * i);
+    }
+
+    auto [a, b, c, d] = _state;
+    for (std::uint32_t i = 0; i < 64; ++i) {
+        std::uint32_t f = 0;
+        std::uint32_t g = 0;
+        if (i < 16) {
+            f = (b & c) | (~b & d);
+            g = i;
+        } else if (i < 32) {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) % 16;
+        } else if (i < 48) {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) % 16;
+        } else {
+            f = c ^ (b | ~d);
+            g = (7 * i) % 16;
+        }
+        f += a + kSines[i] + words[g];
+        a = d;
+        d = c;
+        c = b;
+        b += std::rotl(f, static_cast<int>(kShifts[i]));
+    }
+    _state[0] += a;
+    _state[1] += b;
+    _state[2] += c;
+    _state[3] += d;
+}
@@ -9,11 +9,13 @@
 
 std::ostream &operator<<(std::ostream &os, const SearchResult &result) {
     os << "SearchResult { image_url: " << result.image_url << ", web_url: " << result.web_url
-        << ", image_type: " << result.image_type << " }";
+        << ", image_type: " << result.image_type << ", confidence: "
+        << static_cast<int>(result.confidence) << ", failed: " << result.failed << " }";
     return os;
 }
 
 std::ostream &operator<<(std::ostream &os, const UploadResult &result) {
-    os << "UploadResult { image_url: " << result.image_url << " }";
+    os << "UploadResult { image_url: " << result.image_url << ", failed: " << result.failed
+        << " }";
     return os;
 }
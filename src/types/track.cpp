@@ -161,7 +161,8 @@ std::ostream &operator<<(std::ostream &os, const ImageType &type) {
 
 std::ostream &operator<<(std::ostream &os, const ImageUrl &image) {
     os << "ImageUrl { url: " << image.url << ", type: " << image.type << ", source: "
-        << image.source << " }";
+        << image.source << ", quality: " << to_string(image.quality) << ", confidence: "
+        << static_cast<int>(image.confidence) << " }";
     return os;
 }
 
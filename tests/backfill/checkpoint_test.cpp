@@ -0,0 +1,101 @@
+/**
+ * @file checkpoint_test.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include "backfill/checkpoint.hpp"
+
+namespace {
+/**
+ * A checkpoint path under temp, removed on destruction along with its temporary file.
+ */
+class TempCheckpoint {
+public:
+    TempCheckpoint() {
+        static std::mt19937_64 rng{std::random_device{}()};
+        _path = std::filesystem::temp_directory_path() /
+                ("musicpp_checkpoint_test_" + std::to_string(rng()));
+    }
+
+    ~TempCheckpoint() {
+        std::error_code ec;
+        remove(_path, ec);
+        auto temp = _path;
+        temp += ".tmp";
+        remove(temp, ec);
+    }
+
+    TempCheckpoint(const TempCheckpoint &) = delete;
+
+    TempCheckpoint &operator=(const TempCheckpoint &) = delete;
+
+    [[nodiscard]] const std::filesystem::path &path() const { return _path; }
+
+    void write(const std::string &contents) const {
+        std::ofstream(_path) << contents;
+    }
+
+private:
+    std::filesystem::path _path;
+};
+} // namespace
+
+TEST_CASE("With no checkpoint a backfill starts from the first track", "[backfill]") {
+    const TempCheckpoint file;
+    const Checkpoint checkpoint(file.path());
+    CHECK(checkpoint.resumeFrom() == 0);
+}
+
+TEST_CASE("An existing checkpoint is read back", "[backfill]") {
+    const TempCheckpoint file;
+    file.write("42\n");
+    Checkpoint checkpoint(file.path());
+    CHECK(checkpoint.resumeFrom() == 42);
+
+    // Tracks before it were done last time; it only moves on from there.
+    checkpoint.markDone(3);
+    checkpoint.markDone(42);
+    checkpoint.flush();
+    CHECK(Checkpoint(file.path()).resumeFrom() == 43);
+}
+
+TEST_CASE("An unreadable checkpoint starts from the first track", "[backfill]") {
+    const TempCheckpoint file;
+    file.write("not a number\n");
+    CHECK(Checkpoint(file.path()).resumeFrom() == 0);
+}
+
+TEST_CASE("Tracks done out of order only move the checkpoint past the contiguous run",
+          "[backfill]") {
+    const TempCheckpoint file;
+    {
+        Checkpoint checkpoint(file.path());
+        checkpoint.markDone(2);
+        checkpoint.markDone(0);
+        checkpoint.markDone(4);
+        checkpoint.flush();
+        // Track 1 is still out, so 2 and 4 would be done again after a restart.
+        CHECK(Checkpoint(file.path()).resumeFrom() == 1);
+
+        checkpoint.markDone(1);
+        checkpoint.flush();
+        CHECK(Checkpoint(file.path()).resumeFrom() == 3);
+
+        checkpoint.markDone(3);
+    }
+    // Written once more as it goes out of scope.
+    CHECK(Checkpoint(file.path()).resumeFrom() == 5);
+}
+
+TEST_CASE("A checkpoint with no path is kept in memory only", "[backfill]") {
+    Checkpoint checkpoint({});
+    checkpoint.markDone(0);
+    checkpoint.flush();
+    CHECK(checkpoint.resumeFrom() == 0);
+}
@@ -0,0 +1,181 @@
+/**
+ * @file library_test.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "backfill/library.hpp"
+
+namespace {
+/**
+ * A track list under temp with the given extension, removed on destruction.
+ */
+class TempList {
+public:
+    TempList(const std::string &extension, const std::string &contents) {
+        static std::mt19937_64 rng{std::random_device{}()};
+        _path = std::filesystem::temp_directory_path() /
+                ("musicpp_library_test_" + std::to_string(rng()) + extension);
+        std::ofstream(_path, std::ios::binary) << contents;
+    }
+
+    ~TempList() {
+        std::error_code ec;
+        remove(_path, ec);
+    }
+
+    TempList(const TempList &) = delete;
+
+    TempList &operator=(const TempList &) = delete;
+
+    [[nodiscard]] const std::filesystem::path &path() const { return _path; }
+
+private:
+    std::filesystem::path _path;
+};
+
+std::vector<TrackIdentity> csv(const std::string &text) {
+    std::istringstream in(text);
+    return readCsv(in);
+}
+
+std::vector<TrackIdentity> jsonLines(const std::string &text) {
+    std::istringstream in(text);
+    return readJsonLines(in);
+}
+
+/// A Library.xml export holding the given track dicts, in the layout Apple Music writes.
+std::string libraryXml(const std::string &tracks) {
+    return R"(<?xml version="1.0" encoding="UTF-8"?>
+<plist version="1.0">
+<dict>
+	<key>Major Version</key><integer>1</integer>
+	<key>Application Version</key><string>1.5.0.124</string>
+	<key>Tracks</key>
+	<dict>
+)" + tracks + R"(	</dict>
+	<key>Playlists</key>
+	<array>
+	</array>
+</dict>
+</plist>
+)";
+}
+} // namespace
+
+TEST_CASE("A CSV is read by its header's column names", "[backfill]") {
+    const auto tracks = csv("Year,ARTIST,Name,Album\n"
+                            "1975,Queen,Bohemian Rhapsody,A Night at the Opera\n"
+                            "1977,Queen,We Will Rock You\n");
+    REQUIRE(tracks.size() == 2);
+    CHECK(tracks[0].title == "Bohemian Rhapsody");
+    CHECK(tracks[0].artist == "Queen");
+    CHECK(tracks[0].album == "A Night at the Opera");
+    // A short row leaves the columns it lacks empty.
+    CHECK(tracks[1].title == "We Will Rock You");
+    CHECK(tracks[1].album.empty());
+}
+
+TEST_CASE("Quoted CSV fields may hold commas, escaped quotes and line breaks", "[backfill]") {
+    const auto tracks = csv("title,artist,album\r\n"
+                            "\"Killer Queen\",\"Queen\",\"Sheer Heart Attack\"\r\n"
+                            "\"Say \"\"Hello\"\"\",\"Earth, Wind & Fire\",\"\"\r\n"
+                            "\"Two\nLines\",Queen,Innuendo\n");
+    REQUIRE(tracks.size() == 3);
+    CHECK(tracks[0].title == "Killer Queen");
+    CHECK(tracks[0].album == "Sheer Heart Attack");
+    CHECK(tracks[1].title == "Say \"Hello\"");
+    CHECK(tracks[1].artist == "Earth, Wind & Fire");
+    CHECK(tracks[1].album.empty());
+    CHECK(tracks[2].title == "Two\nLines");
+    CHECK(tracks[2].album == "Innuendo");
+}
+
+TEST_CASE("A CSV whose header names no title or artist gives nothing", "[backfill]") {
+    CHECK(csv("song,band\nBohemian Rhapsody,Queen\n").empty());
+    CHECK(csv("title,album\nBohemian Rhapsody,A Night at the Opera\n").empty());
+    CHECK(csv("").empty());
+}
+
+TEST_CASE("CSV rows without a title or an artist are skipped", "[backfill]") {
+    const auto tracks = csv("title,artist\n,Queen\nBohemian Rhapsody,\n\nInnuendo,Queen\n");
+    REQUIRE(tracks.size() == 1);
+    CHECK(tracks[0].title == "Innuendo");
+}
+
+TEST_CASE("JSON lines are read, skipping blank and malformed lines", "[backfill]") {
+    const auto tracks = jsonLines(
+        R"({"title": "Bohemian Rhapsody", "artist": "Queen", "album": "A Night at the Opera"})"
+        "\n\n"
+        R"({"name": "Sigur Rós", "artist": "Hoppípolla"})"
+        "\n"
+        R"({"title": "cut off)"
+        "\n"
+        R"(["Innuendo", "Queen"])"
+        "\n"
+        R"({"title": "No artist"})"
+        "\r\n");
+    REQUIRE(tracks.size() == 2);
+    CHECK(tracks[0].title == "Bohemian Rhapsody");
+    CHECK(tracks[0].album == "A Night at the Opera");
+    CHECK(tracks[1].title == "Sigur Rós");
+    CHECK(tracks[1].album.empty());
+}
+
+TEST_CASE("A Library.xml export's tracks are read", "[backfill]") {
+    const TempList list(".xml", libraryXml(R"(		<key>1001</key>
+		<dict>
+			<key>Track ID</key><integer>1001</integer>
+			<key>Name</key><string>Bohemian Rhapsody</string>
+			<key>Artist</key><string>Queen</string>
+			<key>Album</key><string>A Night at the Opera</string>
+		</dict>
+		<key>1002</key>
+		<dict>
+			<key>Track ID</key><integer>1002</integer>
+			<key>Name</key><string>Voice Memo</string>
+		</dict>
+		<key>1003</key>
+		<dict>
+			<key>Track ID</key><integer>1003</integer>
+			<key>Name</key><string>Don&apos;t Stop Me Now</string>
+			<key>Artist</key><string>Queen</string>
+		</dict>
+)"));
+    const auto tracks = readLibrary(list.path());
+    REQUIRE(tracks.size() == 2);
+    CHECK(tracks[0].title == "Bohemian Rhapsody");
+    CHECK(tracks[0].artist == "Queen");
+    CHECK(tracks[0].album == "A Night at the Opera");
+    CHECK(tracks[1].title == "Don't Stop Me Now");
+    CHECK(tracks[1].album.empty());
+}
+
+TEST_CASE("A Library.xml without a Tracks dictionary gives nothing", "[backfill]") {
+    const TempList plist(".xml", "<?xml version=\"1.0\"?>\n<plist><dict></dict></plist>\n");
+    CHECK(readLibraryXml(plist.path()).empty());
+    const TempList broken(".xml", "<plist><dict><key>Tracks</key>");
+    CHECK(readLibraryXml(broken.path()).empty());
+}
+
+TEST_CASE("A track list's format is picked by its extension", "[backfill]") {
+    const TempList csvList(".CSV", "title,artist\nBohemian Rhapsody,Queen\n");
+    const TempList jsonList(".ndjson", R"({"title": "Innuendo", "artist": "Queen"})" "\n");
+    const TempList unknown(".txt", "title,artist\nBohemian Rhapsody,Queen\n");
+
+    const auto fromCsv = readLibrary(csvList.path());
+    REQUIRE(fromCsv.size() == 1);
+    CHECK(fromCsv[0].title == "Bohemian Rhapsody");
+    const auto fromJson = readLibrary(jsonList.path());
+    REQUIRE(fromJson.size() == 1);
+    CHECK(fromJson[0].title == "Innuendo");
+    CHECK(readLibrary(unknown.path()).empty());
+    CHECK(readLibrary(std::filesystem::temp_directory_path() / "musicpp_no_such_list.csv").empty());
+}
@@ -0,0 +1,73 @@
+/**
+ * @file artwork_test.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include "metadata/sources/artwork.hpp"
+
+namespace {
+const std::string kThumb = "https://is1-ssl.mzstatic.com/image/thumb/Music/v4/ab/cd/ef/x.jpg/";
+
+constexpr ArtworkSize kLarge{1000, ArtworkFormat::Jpeg};
+constexpr ArtworkSize kWebp{300, ArtworkFormat::Webp};
+} // namespace
+
+TEST_CASE("A template is filled in for the rendition wanted", "[artwork]") {
+    const std::string pattern = kThumb + "{w}x{h}{c}.{f}";
+
+    CHECK(fillArtwork(pattern, kLarge) == kThumb + "1000x1000bb-60.jpg");
+    CHECK(fillArtwork(pattern, kWebp) == kThumb + "300x300bb.webp");
+    CHECK(fillArtwork(pattern, {}) == kThumb + "512x512bb-60.jpg");
+}
+
+TEST_CASE("A template without placeholders is left as it is", "[artwork]") {
+    CHECK(fillArtwork("https://img/{x}/a.jpg", kLarge) == "https://img/{x}/a.jpg");
+    CHECK(fillArtwork("https://img/{w", kLarge) == "https://img/{w");
+    CHECK(fillArtwork("", kLarge).empty());
+}
+
+TEST_CASE("An Apple artwork url is rewritten to the rendition wanted", "[artwork]") {
+    CHECK(resizeArtwork(kThumb + "296x296bb-60.jpg", kLarge) == kThumb + "1000x1000bb-60.jpg");
+    CHECK(resizeArtwork(kThumb + "296x296bb.webp", kLarge) == kThumb + "1000x1000bb-60.jpg");
+    CHECK(resizeArtwork(kThumb + "296x296bb-60.jpg", kWebp) == kThumb + "300x300bb.webp");
+    // The crop code and anything past the path are kept.
+    CHECK(resizeArtwork(kThumb + "600x600cc.jpg?v=2", kWebp) == kThumb + "300x300cc.webp?v=2");
+}
+
+TEST_CASE("Any other url is left as it is", "[artwork]") {
+    // Another host, even with a size segment.
+    CHECK(resizeArtwork("https://i.imgur.com/296x296bb-60.jpg", kLarge) ==
+          "https://i.imgur.com/296x296bb-60.jpg");
+    CHECK(resizeArtwork("https://lastfm.freetls.fastly.net/i/u/300x300/abc.png", kLarge) ==
+          "https://lastfm.freetls.fastly.net/i/u/300x300/abc.png");
+    // Apple's host without a rendition to rewrite.
+    CHECK(resizeArtwork(kThumb + "cover.jpg", kLarge) == kThumb + "cover.jpg");
+    CHECK(resizeArtwork(kThumb + "296x296bb-.jpg", kLarge) == kThumb + "296x296bb-.jpg");
+    CHECK(resizeArtwork(kThumb + "296x296.jpg", kLarge) == kThumb + "296x296.jpg");
+}
+
+TEST_CASE("A srcset gives the smallest candidate big enough", "[artwork]") {
+    const std::string srcset = kThumb + "296x296bb-60.jpg 296w, " +
+                               kThumb + "592x592bb-60.jpg 592w, " +
+                               kThumb + "1200x1200bb-60.jpg 1200w";
+
+    CHECK(artworkFromSrcset(srcset, kLarge) == kThumb + "1000x1000bb-60.jpg");
+    CHECK(artworkFromSrcset(srcset, kWebp) == kThumb + "300x300bb.webp");
+}
+
+TEST_CASE("A srcset with nothing big enough gives its largest", "[artwork]") {
+    // Off Apple's host nothing is rewritten, so which candidate was picked shows through.
+    CHECK(artworkFromSrcset("https://a/small.jpg 100w,https://a/big.jpg 400w", kLarge) ==
+          "https://a/big.jpg");
+    CHECK(artworkFromSrcset("  https://a/only.jpg  ", kLarge) == "https://a/only.jpg");
+    CHECK(artworkFromSrcset("https://a/1x.jpg 1x, https://a/2x.jpg 2x", kLarge) ==
+          "https://a/1x.jpg");
+}
+
+TEST_CASE("An empty srcset gives nothing", "[artwork]") {
+    CHECK(artworkFromSrcset("", kLarge).empty());
+    CHECK(artworkFromSrcset(" , ,", kLarge).empty());
+}
@@ -17,6 +17,40 @@ Track makeTrack(const std::string &title, const std::string &artist, const std::
     return track;
 }
 
+/**
+ * Writes an image in the layout rows were stored in before images were graded.
+ */
+std::string legacyImageValue(const std::string &source) {
+    std::string val(8, '\0');
+    val.push_back(static_cast<char>(Static));
+    const auto length = static_cast<uint32_t>(source.size());
+    val.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    return val + source + "https://img/a.jpg";
+}
+
+/**
+ * Writes a url list in the unversioned layout rows were stored in before interning.
+ */
+std::string legacyUrlValue(const std::vector<SongUrl> &urls) {
+    auto putU32 = [](std::string &buf, const uint32_t value) {
+        buf.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    };
+    std::string val;
+    putU32(val, static_cast<uint32_t>(urls.size()));
+    for (const auto &[url, source] : urls) {
+        putU32(val, static_cast<uint32_t>(source.size()));
+        val += source;
+        putU32(val, static_cast<uint32_t>(url.size()));
+        val += url;
+    }
+    return val;
+}
+
+const std::vector<SongUrl> kKnownUrls{
+    {"https://music.apple.com/ca/song/bohemian-rhapsody/1440650711", "Apple Music Web Scraper"},
+    {"https://www.last.fm/music/Queen/_/Bohemian+Rhapsody", "LastFm API"},
+};
+
 }
 
 TEST_CASE("keys are prefixed per value type and separate image from urls", "[codec]") {
@@ -46,14 +80,52 @@ TEST_CASE("image values round-trip with their write instant", "[codec]") {
     REQUIRE(parsed->written_at == written);
 }
 
+TEST_CASE("image values round-trip with their quality and confidence", "[codec]") {
+    ImageUrl image{"https://i.imgur.com/abc.png", Animated, "imgur"};
+    image.quality = ImageQuality::LowConfidence;
+    image.confidence = 72;
+
+    const auto parsed = cache_codec::parseImageValue(
+        cache_codec::createImageValue(image, cache_codec::nowSeconds()));
+
+    REQUIRE(parsed.has_value());
+    REQUIRE(parsed->image == image);
+}
+
+TEST_CASE("an image value written before grading reads as a match, or a fallback from Imgur",
+          "[codec]") {
+    const auto scraped = cache_codec::parseImageValue(legacyImageValue("Apple Music Web Scraper"));
+    REQUIRE(scraped.has_value());
+    REQUIRE(scraped->image.url == "https://img/a.jpg");
+    REQUIRE(scraped->image.quality == ImageQuality::Matched);
+    REQUIRE(scraped->image.confidence == 100);
+
+    const auto rehosted = cache_codec::parseImageValue(legacyImageValue("Imgur Image Host"));
+    REQUIRE(rehosted.has_value());
+    REQUIRE(rehosted->image.quality == ImageQuality::Fallback);
+}
+
+TEST_CASE("a track key parses back to the identity it was derived from", "[codec]") {
+    const Track track = makeTrack("a|b", "c", "");
+
+    const auto identity = cache_codec::parseTrackKey(cache_codec::trackKey(track));
+
+    REQUIRE(identity.has_value());
+    REQUIRE(identity->title == "a-b");
+    REQUIRE(identity->artist == "c");
+    REQUIRE(identity->album.empty());
+    REQUIRE_FALSE(cache_codec::parseTrackKey("only|two").has_value());
+}
+
 TEST_CASE("a truncated image value is rejected rather than half-parsed", "[codec]") {
     const ImageUrl image{"https://i.imgur.com/abc.png", Static, "imgur"};
     const std::string raw = cache_codec::createImageValue(image, cache_codec::nowSeconds());
 
     REQUIRE_FALSE(cache_codec::parseImageValue("").has_value());
-    // Cuts inside the timestamp, and inside the source length that follows it.
+    // Cuts inside the timestamp, inside the quality and confidence, and inside the source length.
     REQUIRE_FALSE(cache_codec::parseImageValue(raw.substr(0, 4)).has_value());
-    REQUIRE_FALSE(cache_codec::parseImageValue(raw.substr(0, 11)).has_value());
+    REQUIRE_FALSE(cache_codec::parseImageValue(raw.substr(0, 10)).has_value());
+    REQUIRE_FALSE(cache_codec::parseImageValue(raw.substr(0, 13)).has_value());
 }
 
 TEST_CASE("an image is fresh until the ttl elapses", "[codec]") {
@@ -108,4 +180,50 @@ TEST_CASE("merging song urls dedupes and drops empties", "[codec]") {
     REQUIRE(merged.size() == 2);
     REQUIRE(merged[1].source == "lastfm");
     REQUIRE(merged[1].url == "https://last.fm/song/1");
-}
\ No newline at end of file
+}
+
+TEST_CASE("known sources and url prefixes round-trip through their ids", "[codec]") {
+    const auto parsed = cache_codec::parseUrlValue(cache_codec::createUrlValue(kKnownUrls));
+
+    CHECK(parsed == kKnownUrls);
+}
+
+TEST_CASE("interning shrinks a url value several-fold", "[codec]") {
+    const auto interned = cache_codec::createUrlValue(kKnownUrls);
+    const auto legacy = legacyUrlValue(kKnownUrls);
+
+    // What is left is mostly the url remainders themselves.
+    CHECK(interned.size() * 2 < legacy.size());
+}
+
+TEST_CASE("rows written before interning still decode", "[codec]") {
+    const std::vector<SongUrl> urls{
+        {"https://music.apple.com/song/1", "applemusic"},
+        {"https://www.last.fm/music/Queen", "LastFm API"},
+    };
+
+    CHECK(cache_codec::parseUrlValue(legacyUrlValue(urls)) == urls);
+}
+
+TEST_CASE("a url value of an unknown version reads as empty", "[codec]") {
+    std::string raw = cache_codec::createUrlValue(kKnownUrls);
+    raw[1] = 99;
+
+    CHECK(cache_codec::parseUrlValue(raw).empty());
+}
+
+TEST_CASE("a truncated url value keeps the entries before the cut", "[codec]") {
+    const std::string raw = cache_codec::createUrlValue(kKnownUrls);
+
+    const auto parsed = cache_codec::parseUrlValue(raw.substr(0, raw.size() - 3));
+
+    REQUIRE(parsed.size() == 1);
+    CHECK(parsed[0] == kKnownUrls[0]);
+}
+
+TEST_CASE("an out-of-range interned id is rejected", "[codec]") {
+    // Tag, version, one entry, then a source id no build has ever assigned.
+    const std::string raw{'\xFF', '\x02', '\x01', '\x7F', '\x00', '\x00'};
+
+    CHECK(cache_codec::parseUrlValue(raw).empty());
+}
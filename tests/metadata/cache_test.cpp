@@ -153,4 +153,157 @@ TEST_CASE("opening the cache sweeps malformed image rows", "[cache]") {
     }
 
     REQUIRE_FALSE(temp.has(cache_codec::imageKey(track)));
-}
\ No newline at end of file
+}
+
+TEST_CASE("a batch lookup answers in input order", "[cache][batch]") {
+    const TempDb temp;
+    // Out of key order on purpose, with a miss in the middle and a track asked for twice.
+    const std::vector tracks{
+        makeTrack("Love of My Life"), makeTrack("Missing Track"), makeTrack("Bohemian Rhapsody"),
+        makeTrack("Love of My Life")
+    };
+
+    EnrichedTrack love;
+    love.track = tracks[0];
+    love.image = kImage;
+    EnrichedTrack bohemian;
+    bohemian.track = tracks[2];
+    bohemian.songUrls = kUrls; {
+        const MetadataCache cache(temp.path());
+        cache.writeEntry(love);
+        cache.writeEntry(bohemian);
+    }
+
+    const MetadataCache cache(temp.path());
+    const auto found = cache.findEntries(tracks);
+
+    REQUIRE(found.size() == 4);
+    REQUIRE(found[0].has_value());
+    CHECK(found[0]->track.identity.title == "Love of My Life");
+    CHECK(found[0]->image.url == kImage.url);
+    CHECK(found[0]->songUrls.empty());
+    CHECK_FALSE(found[1].has_value());
+    REQUIRE(found[2].has_value());
+    CHECK(found[2]->image.url.empty());
+    CHECK(found[2]->songUrls.size() == 1);
+    REQUIRE(found[3].has_value());
+    CHECK(found[3]->image.url == kImage.url);
+}
+
+TEST_CASE("a batch lookup agrees with single lookups", "[cache][batch]") {
+    const TempDb temp;
+    const Track linked = makeTrack("Linked Track");
+    const Track pictured = makeTrack("Pictured Track");
+
+    temp.put(cache_codec::imageKey(pictured),
+             cache_codec::createImageValue(kImage, cache_codec::nowSeconds()));
+    temp.put(cache_codec::urlKey(linked), cache_codec::createUrlValue(kUrls));
+
+    const MetadataCache cache(temp.path());
+    const std::vector tracks{linked, pictured};
+    const auto batch = cache.findEntries(tracks);
+
+    REQUIRE(batch.size() == 2);
+    for (std::size_t i = 0; i < tracks.size(); ++i) {
+        CHECK(batch[i] == cache.findEntry(tracks[i]));
+    }
+}
+
+TEST_CASE("an empty batch finds nothing", "[cache][batch]") {
+    const TempDb temp;
+    const MetadataCache cache(temp.path());
+
+    CHECK(cache.findEntries({}).empty());
+}
+
+TEST_CASE("a state row survives reopening the cache", "[cache][state]") {
+    const TempDb temp; {
+        const MetadataCache cache(temp.path());
+        cache.writeState("health|apple", std::string("\x01\x00\x02", 3));
+    }
+
+    const MetadataCache cache(temp.path()); // sweeps on open
+    const auto state = cache.readState("health|apple");
+
+    REQUIRE(state.has_value());
+    CHECK(*state == std::string("\x01\x00\x02", 3));
+    CHECK_FALSE(cache.readState("health|lastfm").has_value());
+}
+
+TEST_CASE("a state row is kept apart from the track rows", "[cache][state]") {
+    const TempDb temp;
+    const MetadataCache cache(temp.path());
+
+    cache.writeState("Bohemian Rhapsody", "state");
+
+    CHECK_FALSE(cache.findEntry(makeTrack("Bohemian Rhapsody")).has_value());
+    CHECK(temp.has(cache_codec::stateKey("Bohemian Rhapsody")));
+}
+
+TEST_CASE("the upgrade walk finds only images below a full match", "[cache][upgrade]") {
+    const TempDb temp;
+    const MetadataCache cache(temp.path());
+
+    const auto write = [&cache](const std::string &title, const ImageQuality quality) {
+        EnrichedTrack enriched;
+        enriched.track = makeTrack(title);
+        enriched.image = kImage;
+        enriched.image.quality = quality;
+        cache.writeEntry(enriched);
+    };
+    write("A", ImageQuality::Fallback);
+    write("B", ImageQuality::Matched);
+    write("C", ImageQuality::LowConfidence);
+    write("D", ImageQuality::Fallback);
+
+    const auto first = cache.findUpgradeable("", 2);
+    REQUIRE(first.size() == 2);
+    CHECK(first[0].track.identity == makeTrack("A").identity);
+    CHECK(first[0].image.quality == ImageQuality::Fallback);
+    CHECK(first[1].track.identity == makeTrack("C").identity);
+
+    // Carrying on after the last one found picks up where the walk left off, and runs out.
+    const auto rest = cache.findUpgradeable(cache_codec::trackKey(first[1].track), 2);
+    REQUIRE(rest.size() == 1);
+    CHECK(rest[0].track.identity == makeTrack("D").identity);
+}
+
+TEST_CASE("a harvest only fills in what the cache lacks", "[cache][harvest]") {
+    const TempDb temp;
+    const MetadataCache cache(temp.path());
+
+    EnrichedTrack own;
+    own.track = makeTrack("A");
+    own.image = kImage;
+    own.songUrls = kUrls;
+    cache.writeEntry(own);
+
+    const auto harvested = [](const std::string &title) {
+        EnrichedTrack enriched;
+        enriched.track = makeTrack(title);
+        enriched.image = ImageUrl{"https://img/" + title + ".jpg", Static, "applemusic",
+                                  ImageQuality::Harvested, 100};
+        enriched.songUrls = {{"https://music.apple.com/song/" + title, "applemusic"},
+                             {"https://last.fm/" + title, "lastfm"}};
+        return enriched;
+    };
+    const std::vector batch{harvested("A"), harvested("B")};
+
+    CHECK(cache.writeHarvest(batch) == 2);
+
+    // A's own image and Apple link stand; only the platform it had no link from is added.
+    const auto a = cache.findEntry(makeTrack("A"));
+    REQUIRE(a.has_value());
+    CHECK(a->image == kImage);
+    REQUIRE(a->songUrls.size() == 2);
+    CHECK(a->songUrls[0] == kUrls[0]);
+    CHECK(a->songUrls[1].source == "lastfm");
+
+    const auto b = cache.findEntry(makeTrack("B"));
+    REQUIRE(b.has_value());
+    CHECK(b->image.quality == ImageQuality::Harvested);
+    CHECK(b->songUrls.size() == 2);
+
+    // Harvesting the same songs again has nothing left to fill in.
+    CHECK(cache.writeHarvest(batch) == 0);
+}
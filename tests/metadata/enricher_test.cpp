@@ -5,11 +5,15 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <catch2/catch_test_macros.hpp>
+#include <chrono>
 #include <filesystem>
 #include <memory>
+#include <optional>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 #include "metadata/cache.hpp"
 #include "metadata/enricher.hpp"
@@ -62,9 +66,10 @@ public:
         : _name(std::move(name)), _result(std::move(result)) {
     }
 
-    SearchResult searchTrack(const Track &track) override {
+    SearchResult searchTrack(const Track &track, const CallContext &context) override {
         ++calls;
         asked = track.identity;
+        deadline = context.deadline;
         return _result;
     }
 
@@ -72,12 +77,76 @@ public:
 
     int calls = 0;
     TrackIdentity asked{};
+    std::optional<std::chrono::steady_clock::time_point> deadline{};
 
 private:
     std::string _name;
     SearchResult _result;
 };
 
+/**
+ * A source that takes its time answering, recording how many of its kind were searching at once.
+ */
+class SlowSource final : public MetadataWebSource {
+public:
+    SlowSource(std::string name, SearchResult result, const std::chrono::milliseconds latency)
+        : _name(std::move(name)), _result(std::move(result)), _latency(latency) {
+    }
+
+    SearchResult searchTrack(const Track &, const CallContext &) override {
+        const int now = ++inFlight;
+        int seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+        }
+        std::this_thread::sleep_for(_latency);
+        --inFlight;
+        return _result;
+    }
+
+    std::string identify() override { return _name; }
+
+    static inline std::atomic<int> inFlight{0};
+    static inline std::atomic<int> peak{0};
+
+private:
+    std::string _name;
+    SearchResult _result;
+    std::chrono::milliseconds _latency;
+};
+
+/**
+ * A source that takes its time answering, but gives up as soon as its caller stops waiting.
+ */
+class StallingSource final : public MetadataWebSource {
+public:
+    StallingSource(std::string name, SearchResult result, const std::chrono::milliseconds latency)
+        : _name(std::move(name)), _result(std::move(result)), _latency(latency) {
+    }
+
+    SearchResult searchTrack(const Track &, const CallContext &context) override {
+        ++calls;
+        const auto until = std::chrono::steady_clock::now() + _latency;
+        while (std::chrono::steady_clock::now() < until) {
+            if (context.stop.stop_requested()) {
+                cancelled = true;
+                return {};
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return _result;
+    }
+
+    std::string identify() override { return _name; }
+
+    std::atomic<int> calls{0};
+    std::atomic<bool> cancelled{false};
+
+private:
+    std::string _name;
+    SearchResult _result;
+    std::chrono::milliseconds _latency;
+};
+
 /**
  * An uploader handing back a scripted url, counting what it was asked to rehost.
  */
@@ -87,7 +156,8 @@ public:
                                                       _url(std::move(url)) {
     }
 
-    UploadResult uploadImage(const std::vector<unsigned char> &bytes, ImageType type) override {
+    UploadResult uploadImage(const std::vector<unsigned char> &bytes, ImageType type,
+                             const CallContext &) override {
         ++calls;
         received = bytes;
         receivedType = type;
@@ -105,6 +175,33 @@ private:
     std::string _url;
 };
 
+/**
+ * A source whose search lists other songs beside its answer, counting what it was asked.
+ */
+class HarvestingSource final : public MetadataWebSource {
+public:
+    HarvestingSource(std::string name, SearchHarvest harvest)
+        : _name(std::move(name)), _harvest(std::move(harvest)) {
+    }
+
+    SearchResult searchTrack(const Track &track, const CallContext &context) override {
+        return harvestTrack(track, context).result;
+    }
+
+    SearchHarvest harvestTrack(const Track &, const CallContext &) override {
+        ++calls;
+        return _harvest;
+    }
+
+    std::string identify() override { return _name; }
+
+    std::atomic<int> calls{0};
+
+private:
+    std::string _name;
+    SearchHarvest _harvest;
+};
+
 SearchResult found(const std::string &image, const std::string &web) {
     return SearchResult{.image_url = image, .web_url = web, .image_type = Static};
 }
@@ -113,6 +210,20 @@ SearchResult found(const std::string &image, const std::string &web) {
 SearchResult missed() { return SearchResult{}; }
 
 const std::vector<unsigned char> kThumbnail{0x89, 0x50, 0x4E, 0x47};
+
+/**
+ * Spins until a condition holds, so a test never hangs on a job that stalls.
+ */
+template<typename Predicate>
+bool waitFor(Predicate done, const std::chrono::milliseconds timeout = std::chrono::seconds(2)) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (done())
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return done();
+}
 } // namespace
 
 TEST_CASE("An image found by a source is returned", "[enricher]") {
@@ -344,4 +455,587 @@ TEST_CASE("A total failure to enrich is survivable", "[enricher]") {
     CHECK(enriched.songUrls.empty());
     CHECK(enriched.track.identity == track.identity);
     CHECK(enriched.track.status == Playing);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Sources are searched side by side", "[enricher][concurrency]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache);
+    SlowSource::peak = 0;
+
+    enricher.registerSource(std::make_shared<SlowSource>(
+        "apple", found("https://img/apple.jpg", "https://apple/queen"), 300ms));
+    enricher.registerSource(std::make_shared<SlowSource>(
+        "lastfm", found("", "https://lastfm/queen"), 300ms));
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto enriched = enricher.enrich(makeTrack(), std::nullopt);
+    const auto took = std::chrono::steady_clock::now() - start;
+
+    CHECK(SlowSource::peak.load() == 2);
+    CHECK(took < 550ms);
+    CHECK(enriched.image.url == "https://img/apple.jpg");
+    CHECK(enriched.songUrls.size() == 2);
+}
+
+TEST_CASE("A slower source still wins the image when registered first", "[enricher][concurrency]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache);
+
+    enricher.registerSource(std::make_shared<SlowSource>(
+        "apple", found("https://img/apple.jpg", ""), 150ms));
+    enricher.registerSource(std::make_shared<FakeSource>(
+        "lastfm", found("https://img/lastfm.jpg", "")));
+
+    const auto enriched = enricher.enrich(makeTrack(), std::nullopt);
+
+    // Answers are merged in registration order, not the order they landed in.
+    CHECK(enriched.image.source == "apple");
+}
+
+TEST_CASE("A source that misses the deadline is passed over", "[enricher][concurrency]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache, EnrichSchedule{.sourceDeadline = 100ms});
+
+    enricher.registerSource(std::make_shared<SlowSource>(
+        "apple", found("https://img/apple.jpg", "https://apple/queen"), 1s));
+    auto uploader = std::make_unique<FakeUploader>("imgur", "https://imgur/abc.png");
+    auto *seen = uploader.get();
+    enricher.registerUploader(std::move(uploader));
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto enriched = enricher.enrich(makeTrack(), kThumbnail);
+
+    CHECK(std::chrono::steady_clock::now() - start < 800ms);
+    // With the source still out, the uploader is the one to supply the image.
+    CHECK(seen->calls == 1);
+    CHECK(enriched.image.url == "https://imgur/abc.png");
+    CHECK(enriched.songUrls.empty());
+}
+
+TEST_CASE("A hedged primary that answers in time is the only one asked for the image",
+          "[enricher][hedged]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache, EnrichSchedule{.hedged = true, .hedgeDelay = 1s});
+
+    auto primary = std::make_shared<FakeSource>(
+        "apple", found("https://img/apple.jpg", "https://apple/queen"));
+    auto secondary = std::make_shared<StallingSource>(
+        "lastfm", found("https://img/lastfm.jpg", "https://lastfm/queen"), 10ms);
+    enricher.registerSource(primary);
+    enricher.registerSource(secondary);
+
+    const auto enriched = enricher.enrich(makeTrack(), std::nullopt);
+
+    CHECK(enriched.image.source == "apple");
+    CHECK(primary->calls == 1);
+    // Still asked, but only once the image was won, and only for its link.
+    CHECK(secondary->calls == 1);
+    CHECK(enriched.songUrls.size() == 2);
+}
+
+TEST_CASE("A hedged primary with no image hands over at once", "[enricher][hedged]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache, EnrichSchedule{.hedged = true, .hedgeDelay = 5s});
+
+    enricher.registerSource(std::make_shared<FakeSource>("apple", found("", "https://apple/queen")));
+    enricher.registerSource(std::make_shared<FakeSource>(
+        "lastfm", found("https://img/lastfm.jpg", "https://lastfm/queen")));
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto enriched = enricher.enrich(makeTrack(), std::nullopt);
+
+    // Nothing waits out the hedge delay on a contender that has already answered.
+    CHECK(std::chrono::steady_clock::now() - start < 1s);
+    CHECK(enriched.image.source == "lastfm");
+    CHECK(enriched.songUrls.size() == 2);
+}
+
+TEST_CASE("A slow contender beaten to the image is cancelled", "[enricher][hedged]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+
+    // The primary's link is already held, so it is only racing for the image.
+    const auto track = makeTrack();
+    EnrichedTrack cached;
+    cached.track = track;
+    cached.songUrls = {SongUrl{.url = "https://apple/queen", .source = "apple"}};
+    cache.writeEntry(cached);
+
+    Enricher enricher(cache, EnrichSchedule{.hedged = true, .hedgeDelay = 50ms});
+    auto primary = std::make_shared<StallingSource>(
+        "apple", found("https://img/apple.jpg", "https://apple/queen"), 5s);
+    enricher.registerSource(primary);
+    enricher.registerSource(std::make_shared<FakeSource>(
+        "lastfm", found("https://img/lastfm.jpg", "https://lastfm/queen")));
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto enriched = enricher.enrich(track, std::nullopt);
+
+    CHECK(std::chrono::steady_clock::now() - start < 1s);
+    CHECK(enriched.image.source == "lastfm");
+    CHECK(enriched.songUrls.size() == 2);
+    CHECK(waitFor([&primary] { return primary->cancelled.load(); }));
+}
+
+TEST_CASE("A hedged contender still owing a link is waited on", "[enricher][hedged]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache, EnrichSchedule{.hedged = true, .hedgeDelay = 20ms});
+
+    auto primary = std::make_shared<StallingSource>(
+        "apple", found("https://img/apple.jpg", "https://apple/queen"), 200ms);
+    enricher.registerSource(primary);
+    enricher.registerSource(std::make_shared<FakeSource>(
+        "lastfm", found("https://img/lastfm.jpg", "https://lastfm/queen")));
+
+    const auto enriched = enricher.enrich(makeTrack(), std::nullopt);
+
+    // The secondary won the image, but the primary's link was still worth its wait.
+    CHECK(enriched.image.source == "lastfm");
+    CHECK(enriched.songUrls.size() == 2);
+    CHECK_FALSE(primary->cancelled.load());
+}
+
+TEST_CASE("A hedged contender still out at the deadline lands in the cache", "[enricher][hedged]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache, EnrichSchedule{
+                          .sourceDeadline = 150ms, .hedged = true, .hedgeDelay = 20ms
+                      });
+
+    auto primary = std::make_shared<StallingSource>(
+        "apple", found("https://img/apple.jpg", "https://apple/queen"), 400ms);
+    enricher.registerSource(primary);
+    enricher.registerSource(std::make_shared<FakeSource>(
+        "lastfm", found("https://img/lastfm.jpg", "https://lastfm/queen")));
+
+    const auto track = makeTrack();
+    const auto start = std::chrono::steady_clock::now();
+    const auto enriched = enricher.enrich(track, std::nullopt);
+
+    CHECK(std::chrono::steady_clock::now() - start < 350ms);
+    CHECK(enriched.image.source == "lastfm");
+    CHECK(enriched.songUrls.size() == 1);
+
+    // Its link is kept for the next enrichment, but the image found in time stands.
+    REQUIRE(waitFor([&cache, &track] {
+        const auto cached = cache.findEntry(track);
+        return cached && cached->songUrls.size() == 2;
+    }));
+    CHECK(cache.findEntry(track)->image.source == "lastfm");
+    CHECK_FALSE(primary->cancelled.load());
+}
+
+TEST_CASE("A hedged enrichment with the image cached asks for every missing link at once",
+          "[enricher][hedged]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+
+    const auto track = makeTrack();
+    EnrichedTrack cached;
+    cached.track = track;
+    cached.image = ImageUrl{.url = "https://img/cached.jpg", .type = Static, .source = "apple"};
+    cache.writeEntry(cached);
+
+    Enricher enricher(cache, EnrichSchedule{.hedged = true, .hedgeDelay = 5s});
+    enricher.registerSource(std::make_shared<StallingSource>(
+        "apple", found("https://img/apple.jpg", "https://apple/queen"), 50ms));
+    enricher.registerSource(std::make_shared<StallingSource>(
+        "lastfm", found("https://img/lastfm.jpg", "https://lastfm/queen"), 50ms));
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto enriched = enricher.enrich(track, std::nullopt);
+
+    // Neither waits out the hedge delay behind the other.
+    CHECK(std::chrono::steady_clock::now() - start < 1s);
+    CHECK(enriched.image.url == "https://img/cached.jpg");
+    REQUIRE(enriched.songUrls.size() == 2);
+    CHECK(std::ranges::any_of(enriched.songUrls, [](const SongUrl &url) {
+        return url.source == "apple";
+    }));
+    CHECK(std::ranges::any_of(enriched.songUrls, [](const SongUrl &url) {
+        return url.source == "lastfm";
+    }));
+}
+
+TEST_CASE("A hedged race falls through to the uploaders", "[enricher][hedged][uploader]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache, EnrichSchedule{.hedged = true, .hedgeDelay = 1s});
+
+    enricher.registerSource(std::make_shared<FakeSource>("apple", missed()));
+    auto uploader = std::make_unique<FakeUploader>("imgur", "https://imgur/abc.png");
+    auto *seen = uploader.get();
+    enricher.registerUploader(std::move(uploader));
+
+    const auto enriched = enricher.enrich(makeTrack(), kThumbnail);
+
+    CHECK(seen->calls == 1);
+    CHECK(seen->received == kThumbnail);
+    CHECK(enriched.image.url == "https://imgur/abc.png");
+}
+
+TEST_CASE("A source failing over and over is passed over", "[enricher][health]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache);
+
+    auto down = std::make_shared<FakeSource>("apple", SearchResult{.failed = true});
+    enricher.registerSource(down);
+
+    for (std::uint32_t i = 0; i < kFailuresToOpen + 2; ++i)
+        (void) enricher.enrich(makeTrack(), std::nullopt);
+
+    CHECK(down->calls == static_cast<int>(kFailuresToOpen));
+    const auto health = enricher.health();
+    REQUIRE(health.size() == 1);
+    CHECK(health[0].name == "apple");
+    CHECK(health[0].openFor.count() > 0);
+}
+
+TEST_CASE("A source that only misses is never passed over", "[enricher][health]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache);
+
+    auto source = std::make_shared<FakeSource>("apple", missed());
+    enricher.registerSource(source);
+
+    for (std::uint32_t i = 0; i < kFailuresToOpen + 2; ++i)
+        (void) enricher.enrich(makeTrack(), std::nullopt);
+
+    CHECK(source->calls == static_cast<int>(kFailuresToOpen + 2));
+}
+
+TEST_CASE("A circuit opened before a restart is still open after it", "[enricher][health]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    {
+        Enricher enricher(cache);
+        enricher.registerSource(
+            std::make_shared<FakeSource>("apple", SearchResult{.failed = true}));
+        for (std::uint32_t i = 0; i < kFailuresToOpen; ++i)
+            (void) enricher.enrich(makeTrack(), std::nullopt);
+    }
+
+    Enricher enricher(cache);
+    auto source = std::make_shared<FakeSource>("apple", found("https://img/apple.jpg", ""));
+    enricher.registerSource(source);
+    (void) enricher.enrich(makeTrack(), std::nullopt);
+
+    CHECK(source->calls == 0);
+}
+
+TEST_CASE("Adaptive order asks the cheaper source first", "[enricher][health]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache, EnrichSchedule{.adaptiveOrder = true});
+
+    // Both have an image; whichever is merged first owns it.
+    enricher.registerSource(std::make_shared<SlowSource>(
+        "apple", found("https://img/apple.jpg", ""), 120ms));
+    enricher.registerSource(std::make_shared<FakeSource>(
+        "lastfm", found("https://img/lastfm.jpg", "")));
+
+    // The first enrichment knows nothing yet, so registration order stands.
+    CHECK(enricher.enrich(makeTrack("Love of My Life"), std::nullopt).image.source == "apple");
+    CHECK(enricher.enrich(makeTrack("Bohemian Rhapsody"), std::nullopt).image.source == "lastfm");
+}
+
+TEST_CASE("Concurrent enrichments of one track share a single search", "[enricher][singleflight]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache);
+
+    auto source = std::make_shared<StallingSource>(
+        "apple", found("https://img/apple.jpg", "https://apple/queen"), 100ms);
+    enricher.registerSource(source);
+
+    std::atomic pictured{0}; {
+        std::vector<std::jthread> callers;
+        for (int i = 0; i < 4; ++i) {
+            callers.emplace_back([&enricher, &pictured, i] {
+                auto track = makeTrack();
+                track.status = i % 2 == 0 ? Playing : Paused;
+                const auto enriched = enricher.enrich(track, std::nullopt);
+                // Each caller gets its own copy of the track back, with the shared finds.
+                if (enriched.image.url == "https://img/apple.jpg" && enriched.track.status ==
+                    track.status)
+                    ++pictured;
+            });
+        }
+    }
+
+    CHECK(source->calls.load() == 1);
+    CHECK(pictured.load() == 4);
+}
+
+TEST_CASE("A caller joining an enrichment still returns by its own deadline",
+          "[enricher][singleflight][deadline]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache);
+
+    auto source = std::make_shared<StallingSource>(
+        "apple", found("https://img/apple.jpg", "https://apple/queen"), 400ms);
+    enricher.registerSource(source);
+
+    std::jthread patient([&enricher] { (void) enricher.enrich(makeTrack(), std::nullopt); });
+    while (source->calls.load() == 0) {
+        std::this_thread::sleep_for(1ms);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const auto hurried = enricher.enrich(makeTrack(), std::nullopt, start + 50ms);
+
+    CHECK(std::chrono::steady_clock::now() - start < 250ms);
+    CHECK(hurried.image.url.empty());
+    patient.join();
+    CHECK(source->calls.load() == 1);
+}
+
+TEST_CASE("An enrichment returns by its deadline with what it has", "[enricher][deadline]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache);
+
+    enricher.registerSource(std::make_shared<SlowSource>(
+        "apple", found("https://img/apple.jpg", "https://apple/queen"), 400ms));
+    enricher.registerSource(std::make_shared<FakeSource>("lastfm", found("", "https://lastfm/queen")));
+
+    const auto track = makeTrack();
+    const auto start = std::chrono::steady_clock::now();
+    const auto enriched = enricher.enrich(track, std::nullopt, start + 100ms);
+
+    CHECK(std::chrono::steady_clock::now() - start < 350ms);
+    CHECK(enriched.image.url.empty());
+    REQUIRE(enriched.songUrls.size() == 1);
+    CHECK(enriched.songUrls[0].source == "lastfm");
+
+    // What the slow source finds is still written, ready for the next play.
+    REQUIRE(waitFor([&cache, &track] {
+        const auto cached = cache.findEntry(track);
+        return cached && cached->songUrls.size() == 2;
+    }));
+    CHECK(cache.findEntry(track)->image.source == "apple");
+}
+
+TEST_CASE("A late image does not replace one found in time", "[enricher][deadline]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache);
+
+    enricher.registerSource(std::make_shared<SlowSource>(
+        "apple", found("https://img/apple.jpg", "https://apple/queen"), 300ms));
+    enricher.registerSource(std::make_shared<FakeSource>(
+        "lastfm", found("https://img/lastfm.jpg", "https://lastfm/queen")));
+
+    const auto track = makeTrack();
+    const auto enriched = enricher.enrich(track, std::nullopt,
+                                          std::chrono::steady_clock::now() + 100ms);
+
+    CHECK(enriched.image.source == "lastfm");
+    REQUIRE(waitFor([&cache, &track] {
+        const auto cached = cache.findEntry(track);
+        return cached && cached->songUrls.size() == 2;
+    }));
+    CHECK(cache.findEntry(track)->image.source == "lastfm");
+}
+
+TEST_CASE("Sources are given the whole source deadline", "[enricher][deadline]") {
+    using namespace std::chrono_literals;
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache, EnrichSchedule{.sourceDeadline = 2s});
+
+    auto source = std::make_shared<FakeSource>("apple", found("https://img/apple.jpg", ""));
+    enricher.registerSource(source);
+
+    const auto start = std::chrono::steady_clock::now();
+    (void) enricher.enrich(makeTrack(), std::nullopt, start + 100ms);
+
+    // The caller's deadline only bounds the wait; the call itself may run on to answer late.
+    REQUIRE(source->deadline.has_value());
+    CHECK(*source->deadline >= start + 2s);
+}
+
+TEST_CASE("Without a deadline a call is bound by its request timeout alone", "[enricher][deadline]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache);
+
+    auto source = std::make_shared<FakeSource>("apple", found("https://img/apple.jpg", ""));
+    enricher.registerSource(source);
+    (void) enricher.enrich(makeTrack(), std::nullopt);
+
+    CHECK(source->calls == 1);
+    CHECK_FALSE(source->deadline.has_value());
+}
+
+TEST_CASE("A rehosted thumbnail is cached as a fallback", "[enricher][upgrade]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache);
+    enricher.registerSource(std::make_shared<FakeSource>("apple", missed()));
+    enricher.registerUploader(std::make_unique<FakeUploader>("imgur", "https://imgur/thumb.png"));
+
+    const auto enriched = enricher.enrich(makeTrack(), kThumbnail);
+
+    CHECK(enriched.image.quality == ImageQuality::Fallback);
+    const auto cached = cache.findEntry(makeTrack());
+    REQUIRE(cached.has_value());
+    CHECK(cached->image.quality == ImageQuality::Fallback);
+}
+
+TEST_CASE("A loose match is graded as such", "[enricher][upgrade]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache);
+    auto loose = found("https://img/loose.jpg", "");
+    loose.confidence = 70;
+    enricher.registerSource(std::make_shared<FakeSource>("apple", loose));
+
+    const auto enriched = enricher.enrich(makeTrack(), std::nullopt);
+
+    CHECK(enriched.image.quality == ImageQuality::LowConfidence);
+    CHECK(enriched.image.confidence == 70);
+}
+
+TEST_CASE("An upgrade replaces a fallback with a source's match", "[enricher][upgrade]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    const auto track = makeTrack();
+
+    EnrichedTrack fallback;
+    fallback.track = track;
+    fallback.image = ImageUrl{.url = "https://imgur/thumb.png", .type = Static, .source = "imgur",
+                              .quality = ImageQuality::Fallback, .confidence = 0};
+    cache.writeEntry(fallback);
+
+    Enricher enricher(cache);
+    enricher.registerSource(std::make_shared<FakeSource>(
+        "apple", found("https://img/queen.jpg", "https://apple/queen")));
+
+    REQUIRE(enricher.upgrade(track));
+
+    const auto cached = cache.findEntry(track);
+    REQUIRE(cached.has_value());
+    CHECK(cached->image.url == "https://img/queen.jpg");
+    CHECK(cached->image.quality == ImageQuality::Matched);
+    REQUIRE(cached->songUrls.size() == 1);
+    CHECK(cached->songUrls.front().url == "https://apple/queen");
+}
+
+TEST_CASE("An upgrade keeps the image when nothing better turns up", "[enricher][upgrade]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    const auto track = makeTrack();
+
+    EnrichedTrack loose;
+    loose.track = track;
+    loose.image = ImageUrl{.url = "https://img/loose.jpg", .type = Static, .source = "apple",
+                           .quality = ImageQuality::LowConfidence, .confidence = 80};
+    cache.writeEntry(loose);
+
+    Enricher enricher(cache);
+    auto looser = found("https://img/looser.jpg", "");
+    looser.confidence = 65;
+    enricher.registerSource(std::make_shared<FakeSource>("apple", looser));
+
+    CHECK_FALSE(enricher.upgrade(track));
+    CHECK(cache.findEntry(track)->image.url == "https://img/loose.jpg");
+}
+
+TEST_CASE("A full match is never upgraded", "[enricher][upgrade]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    const auto track = makeTrack();
+
+    EnrichedTrack matched;
+    matched.track = track;
+    matched.image = ImageUrl{.url = "https://img/queen.jpg", .type = Static, .source = "apple"};
+    cache.writeEntry(matched);
+
+    Enricher enricher(cache);
+    auto source = std::make_shared<FakeSource>("apple", found("https://img/other.jpg", ""));
+    enricher.registerSource(source);
+
+    CHECK_FALSE(enricher.upgrade(track));
+    CHECK(source->calls == 0);
+}
+
+TEST_CASE("Songs a search lists beside the track are kept for later", "[enricher][harvest]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Enricher enricher(cache);
+
+    SearchHarvest harvest{found("https://img/a.jpg", "https://apple/a")};
+    // The track itself, listed again on another shelf, is the enrichment's to write.
+    harvest.others.push_back(HarvestedSong{makeTrack().identity,
+                                           found("https://img/again.jpg", "https://apple/again")});
+    harvest.others.push_back(HarvestedSong{makeTrack("Love of My Life").identity,
+                                           found("https://img/b.jpg", "https://apple/b")});
+    const auto source = std::make_shared<HarvestingSource>("apple", harvest);
+    enricher.registerSource(source);
+
+    const auto enriched = enricher.enrich(makeTrack(), std::nullopt);
+    CHECK(enriched.image.url == "https://img/a.jpg");
+    CHECK(cache.findEntry(makeTrack())->image.url == "https://img/a.jpg");
+
+    const auto kept = cache.findEntry(makeTrack("Love of My Life"));
+    REQUIRE(kept.has_value());
+    CHECK(kept->image.url == "https://img/b.jpg");
+    CHECK(kept->image.quality == ImageQuality::Harvested);
+    CHECK(kept->image.source == "apple");
+
+    // The next song from the album is answered from the cache alone.
+    const auto next = enricher.enrich(makeTrack("Love of My Life"), std::nullopt);
+    CHECK(next.image.url == "https://img/b.jpg");
+    CHECK(source->calls == 1);
+}
+
+TEST_CASE("A harvested image gives way to a source's match", "[enricher][harvest][upgrade]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    const auto track = makeTrack();
+
+    EnrichedTrack harvested;
+    harvested.track = track;
+    harvested.image = ImageUrl{.url = "https://img/listed.jpg", .type = Static, .source = "apple",
+                               .quality = ImageQuality::Harvested, .confidence = 100};
+    const std::vector batch{harvested};
+    REQUIRE(cache.writeHarvest(batch) == 1);
+
+    Enricher enricher(cache);
+    auto loose = found("https://img/loose.jpg", "");
+    loose.confidence = 70;
+    enricher.registerSource(std::make_shared<FakeSource>("lastfm", loose));
+    enricher.registerSource(std::make_shared<FakeSource>("apple", found("https://img/asked.jpg",
+                                                                        "")));
+
+    // A loose match does not outrank a harvested image; a full one does.
+    REQUIRE(enricher.upgrade(track));
+    const auto cached = cache.findEntry(track);
+    REQUIRE(cached.has_value());
+    CHECK(cached->image.url == "https://img/asked.jpg");
+    CHECK(cached->image.quality == ImageQuality::Matched);
+}
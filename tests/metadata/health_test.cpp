@@ -0,0 +1,193 @@
+/**
+ * @file health_test.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <random>
+#include <string>
+#include "metadata/cache.hpp"
+#include "metadata/health.hpp"
+
+using namespace std::chrono_literals;
+
+namespace {
+/**
+ * A leveldb directory under temp, removed on destruction. Never the real song_db.
+ */
+class TempDb {
+public:
+    TempDb() {
+        static std::mt19937_64 rng{std::random_device{}()};
+        _path = std::filesystem::temp_directory_path() /
+                ("musicpp_health_test_" + std::to_string(rng()));
+    }
+
+    ~TempDb() {
+        std::error_code ec;
+        remove_all(_path, ec);
+    }
+
+    TempDb(const TempDb &) = delete;
+
+    TempDb &operator=(const TempDb &) = delete;
+
+    [[nodiscard]] const std::filesystem::path &path() const { return _path; }
+
+private:
+    std::filesystem::path _path;
+};
+
+const SourceHealth::Clock::time_point kStart = SourceHealth::Clock::now();
+
+/// Fails a fresh health enough times in a row to open its circuit at kStart.
+SourceHealth opened() {
+    SourceHealth health;
+    for (std::uint32_t i = 0; i < kFailuresToOpen; ++i)
+        health.record(Outcome::Failed, 100ms, kStart);
+    return health;
+}
+}
+
+TEST_CASE("A contender never asked is allowed and costs nothing", "[health]") {
+    const SourceHealth health;
+
+    CHECK(health.allows(kStart));
+    CHECK(health.expectedCost() == 0.0);
+}
+
+TEST_CASE("Failures short of the threshold leave the circuit closed", "[health]") {
+    SourceHealth health;
+    for (std::uint32_t i = 0; i + 1 < kFailuresToOpen; ++i)
+        CHECK_FALSE(health.record(Outcome::Failed, 100ms, kStart));
+
+    CHECK(health.allows(kStart));
+}
+
+TEST_CASE("Repeated failure opens the circuit until the backoff runs out", "[health]") {
+    const SourceHealth health = opened();
+
+    CHECK_FALSE(health.allows(kStart));
+    CHECK_FALSE(health.allows(kStart + kBaseBackoff - 1s));
+    CHECK(health.allows(kStart + kBaseBackoff));
+    CHECK(health.snapshot("apple", kStart).openFor == kBaseBackoff);
+}
+
+TEST_CASE("Each failure past the threshold doubles the backoff, up to the cap", "[health]") {
+    SourceHealth health = opened();
+
+    CHECK(health.record(Outcome::Failed, 100ms, kStart));
+    CHECK(health.snapshot("apple", kStart).openFor == 2 * kBaseBackoff);
+
+    for (int i = 0; i < 32; ++i)
+        health.record(Outcome::Failed, 100ms, kStart);
+    CHECK(health.snapshot("apple", kStart).openFor == kMaxBackoff);
+}
+
+TEST_CASE("A miss is not a failure and closes the circuit", "[health]") {
+    SourceHealth health = opened();
+
+    health.record(Outcome::Miss, 100ms, kStart + kBaseBackoff);
+
+    CHECK(health.allows(kStart + kBaseBackoff));
+    CHECK(health.snapshot("apple", kStart).consecutiveFailures == 0);
+}
+
+TEST_CASE("Cost weighs latency against how often there is an answer", "[health]") {
+    SourceHealth fast;
+    SourceHealth slow;
+    SourceHealth flaky;
+    for (int i = 0; i < 10; ++i) {
+        fast.record(Outcome::Hit, 200ms, kStart);
+        slow.record(Outcome::Hit, 900ms, kStart);
+        flaky.record(i % 2 == 0 ? Outcome::Hit : Outcome::Miss, 200ms, kStart);
+    }
+
+    CHECK(fast.expectedCost() < slow.expectedCost());
+    CHECK(fast.expectedCost() < flaky.expectedCost());
+}
+
+TEST_CASE("Health survives a round trip through its encoding", "[health]") {
+    SourceHealth health = opened();
+    health.record(Outcome::Hit, 250ms, kStart);
+    health.record(Outcome::Failed, 1s, kStart);
+
+    const auto decoded = SourceHealth::decode(health.encode());
+
+    REQUIRE(decoded.has_value());
+    const auto before = health.snapshot("apple", kStart);
+    const auto after = decoded->snapshot("apple", kStart);
+    CHECK(after.latency == before.latency);
+    CHECK(after.successRatio == before.successRatio);
+    CHECK(after.consecutiveFailures == before.consecutiveFailures);
+    CHECK(after.calls == before.calls);
+    CHECK(decoded->expectedCost() == health.expectedCost());
+}
+
+TEST_CASE("A row written as documented decodes to its fields", "[health]") {
+    std::string row(1, '\x01');
+    const auto field = [&row](const std::uint64_t value) {
+        for (int shift = 0; shift < 64; shift += 8)
+            row.push_back(static_cast<char>(value >> shift & 0xFF));
+    };
+    field(0x406F400000000000); // latency_ms: 250.0
+    field(0x3FE0000000000000); // success_ratio: 0.5
+    field(4); // consecutive_failures
+    field(10); // calls
+    field(1'760'000'060'000); // open_until_ms
+    const SourceHealth::Clock::time_point at{std::chrono::milliseconds(1'760'000'000'000)};
+
+    const auto decoded = SourceHealth::decode(row);
+
+    REQUIRE(decoded.has_value());
+    const auto snapshot = decoded->snapshot("apple", at);
+    CHECK(snapshot.latency == 250ms);
+    CHECK(snapshot.successRatio == 0.5);
+    CHECK(snapshot.consecutiveFailures == 4);
+    CHECK(snapshot.calls == 10);
+    CHECK(snapshot.openFor == 60s);
+    CHECK(decoded->encode() == row);
+}
+
+TEST_CASE("A malformed encoding is rejected", "[health]") {
+    const std::string encoded = opened().encode();
+
+    CHECK_FALSE(SourceHealth::decode("").has_value());
+    CHECK_FALSE(SourceHealth::decode(encoded.substr(0, encoded.size() - 1)).has_value());
+    CHECK_FALSE(SourceHealth::decode("\x09" + encoded.substr(1)).has_value());
+}
+
+TEST_CASE("An open circuit survives a restart", "[health][cache]") {
+    const TempDb db; {
+        MetadataCache cache(db.path());
+        HealthBoard board(cache);
+        for (std::uint32_t i = 0; i < kFailuresToOpen; ++i)
+            board.record("apple", Outcome::Failed, 100ms);
+        REQUIRE_FALSE(board.allows("apple"));
+    }
+
+    MetadataCache cache(db.path());
+    HealthBoard board(cache);
+
+    CHECK_FALSE(board.allows("apple"));
+    CHECK(board.allows("lastfm"));
+}
+
+TEST_CASE("The board lists every contender it has seen", "[health]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    HealthBoard board(cache);
+
+    board.record("lastfm", Outcome::Miss, 300ms);
+    board.record("apple", Outcome::Hit, 100ms);
+
+    const auto snapshot = board.snapshot();
+    REQUIRE(snapshot.size() == 2);
+    CHECK(snapshot[0].name == "apple");
+    CHECK(snapshot[0].calls == 1);
+    CHECK(snapshot[1].name == "lastfm");
+    CHECK(snapshot[1].successRatio == 0.0);
+}
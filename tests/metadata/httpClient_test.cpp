@@ -0,0 +1,74 @@
+/**
+ * @file httpClient_test.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+#include "metadata/http/httpClient.hpp"
+
+TEST_CASE("A handle handed back is lent out again for its host", "[http]") {
+    auto &client = HttpClient::instance();
+    CURL *first = client.acquire("reuse.test");
+    REQUIRE(first != nullptr);
+    client.release("reuse.test", first);
+    CHECK(client.idle("reuse.test") == 1);
+
+    CURL *second = client.acquire("reuse.test");
+    CHECK(second == first);
+    CHECK(client.idle("reuse.test") == 0);
+    client.release("reuse.test", second);
+}
+
+TEST_CASE("Each host has a pool of its own", "[http]") {
+    auto &client = HttpClient::instance();
+    CURL *one = client.acquire("one.test");
+    client.release("one.test", one);
+
+    CURL *other = client.acquire("other.test");
+    CHECK(other != one);
+    CHECK(client.idle("one.test") == 1);
+    client.release("other.test", other);
+}
+
+TEST_CASE("No more than kMaxIdlePerHost handles are kept idle", "[http]") {
+    auto &client = HttpClient::instance();
+    std::vector<CURL *> handles;
+    for (std::size_t i = 0; i < kMaxIdlePerHost + 3; ++i) {
+        handles.push_back(client.acquire("busy.test"));
+        REQUIRE(handles.back() != nullptr);
+    }
+    for (auto *handle : handles) {
+        client.release("busy.test", handle);
+    }
+    CHECK(client.idle("busy.test") == kMaxIdlePerHost);
+}
+
+TEST_CASE("A handle comes back without the last caller's options", "[http]") {
+    auto &client = HttpClient::instance();
+    CURL *handle = client.acquire("reset.test");
+    REQUIRE(handle != nullptr);
+    curl_easy_setopt(handle, CURLOPT_URL, "http://reset.test/");
+    client.release("reset.test", handle);
+
+    // With no URL of its own, it has nowhere to go.
+    handle = client.acquire("reset.test");
+    CHECK(curl_easy_perform(handle) == CURLE_URL_MALFORMAT);
+    client.release("reset.test", handle);
+}
+
+TEST_CASE("What each host's calls received is totalled", "[http]") {
+    auto &client = HttpClient::instance();
+    client.record("traffic.test", 100, false);
+    client.record("traffic.test", 50, true);
+    client.record("quiet.test", 7, false);
+
+    const auto traffic = client.traffic();
+    const auto found = std::ranges::find(traffic, "traffic.test", &HostTraffic::host);
+    REQUIRE(found != traffic.end());
+    CHECK(found->calls == 2);
+    CHECK(found->reused == 1);
+    CHECK(found->bytesReceived == 150);
+}
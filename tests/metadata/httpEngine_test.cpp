@@ -0,0 +1,142 @@
+/**
+ * @file httpEngine_test.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+#include "metadata/http/httpEngine.hpp"
+
+using namespace std::chrono_literals;
+
+namespace {
+/**
+ * A file on disk, read back through a file:// URL so the engine can be driven with no network.
+ */
+class TempFile {
+public:
+    explicit TempFile(const std::string &contents) {
+        static std::mt19937_64 rng{std::random_device{}()};
+        _path = std::filesystem::temp_directory_path() /
+                ("musicpp_engine_test_" + std::to_string(rng()));
+        std::ofstream(_path, std::ios::binary) << contents;
+    }
+
+    ~TempFile() {
+        std::error_code ec;
+        remove(_path, ec);
+    }
+
+    TempFile(const TempFile &) = delete;
+
+    TempFile &operator=(const TempFile &) = delete;
+
+    [[nodiscard]] std::string url() const {
+        auto path = _path.generic_string();
+        if (!path.starts_with('/'))
+            path.insert(0, "/"); // e.g. C:/... on Windows
+        return "file://" + path;
+    }
+
+private:
+    std::filesystem::path _path;
+};
+} // namespace
+
+TEST_CASE("Transfers handed to the engine run side by side and all come back", "[http]") {
+    std::vector<std::unique_ptr<TempFile> > files;
+    std::vector<std::future<CurlResult> > results;
+    for (int i = 0; i < 16; ++i) {
+        files.push_back(std::make_unique<TempFile>("body " + std::to_string(i)));
+        results.push_back(CurlWrapper::performAsync(
+            std::make_unique<CurlWrapper>(files.back()->url())));
+    }
+
+    for (int i = 0; i < 16; ++i) {
+        REQUIRE(results[i].wait_for(5s) == std::future_status::ready);
+        const auto result = results[i].get();
+        CHECK(result.transferred());
+        CHECK(result.output == "body " + std::to_string(i));
+    }
+    CHECK(HttpEngine::instance().inFlight() == 0);
+}
+
+TEST_CASE("A caller told of each result can wait on several transfers at once", "[http]") {
+    std::vector<std::unique_ptr<TempFile> > files;
+    std::mutex mutex;
+    std::condition_variable answered;
+    std::vector<std::string> bodies;
+    for (int i = 0; i < 8; ++i) {
+        files.push_back(std::make_unique<TempFile>("body " + std::to_string(i)));
+        CurlWrapper::performAsync(std::make_unique<CurlWrapper>(files.back()->url()),
+                                  [&](const CurlResult &result) {
+                                      std::lock_guard lock(mutex);
+                                      bodies.push_back(result.output);
+                                      answered.notify_all();
+                                  });
+    }
+
+    std::unique_lock lock(mutex);
+    REQUIRE(answered.wait_for(lock, 5s, [&] { return bodies.size() == 8; }));
+    std::ranges::sort(bodies);
+    for (int i = 0; i < 8; ++i) {
+        CHECK(bodies[i] == "body " + std::to_string(i));
+    }
+}
+
+TEST_CASE("A transfer already stopped is cancelled without going out", "[http]") {
+    const TempFile file("never read");
+    std::stop_source stop;
+    stop.request_stop();
+    auto request = std::make_unique<CurlWrapper>(file.url());
+    request->setContext(CallContext{.stop = stop.get_token()});
+
+    const auto result = CurlWrapper::performAsync(std::move(request)).get();
+    CHECK(result.cancelled());
+    CHECK(result.output.empty());
+}
+
+TEST_CASE("A transfer past its deadline times out without going out", "[http]") {
+    const TempFile file("never read");
+    auto request = std::make_unique<CurlWrapper>(file.url());
+    request->setContext(CallContext{.deadline = std::chrono::steady_clock::now() - 1ms});
+
+    const auto result = CurlWrapper::performAsync(std::move(request)).get();
+    CHECK(result.curlcode == CURLE_OPERATION_TIMEDOUT);
+    CHECK(result.output.empty());
+}
+
+TEST_CASE("A failed transfer comes back with libcurl's reason", "[http]") {
+    const auto result = CurlWrapper::performAsync(
+        std::make_unique<CurlWrapper>("file:///no/such/musicpp/file")).get();
+    CHECK_FALSE(result.transferred());
+    CHECK_FALSE(result.curlErrorString.empty());
+}
+
+TEST_CASE("A response over kMaxResponseBytes fails the call instead of growing", "[http]") {
+    const TempFile file(std::string(kMaxResponseBytes + 1, 'x'));
+    CurlWrapper request(file.url());
+    const auto result = request.performCall();
+    CHECK_FALSE(result.transferred());
+    CHECK(result.output.size() <= kMaxResponseBytes);
+    CHECK(result.curlErrorString.find("larger than") != std::string::npos);
+}
+
+TEST_CASE("A call counts the bytes it received", "[http]") {
+    const TempFile file("counted");
+    CurlWrapper request(file.url());
+    const auto result = request.performCall();
+    REQUIRE(result.transferred());
+    CHECK(result.bytesReceived >= result.output.size());
+    CHECK(result.output == "counted");
+}
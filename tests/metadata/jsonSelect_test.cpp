@@ -0,0 +1,125 @@
+/**
+ * @file jsonSelect_test.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+#include "metadata/http/jsonSelect.hpp"
+
+namespace {
+/**
+ * A match as text: the pointer's index, the element, and the value, strings unquoted.
+ */
+struct Found {
+    std::size_t pointer;
+    std::size_t element;
+    std::string value;
+
+    bool operator==(const Found &) const = default;
+};
+
+std::vector<Found> selectAll(const std::string_view json, const json_select::Selector &selector,
+                             bool *parsed = nullptr) {
+    std::vector<Found> found;
+    const bool whole = json_select::select(json, selector, [&](const json_select::Match &match) {
+        using Kind = json_select::Value::Kind;
+        std::string text;
+        switch (match.value.kind) {
+            case Kind::Null: text = "null";
+                break;
+            case Kind::Boolean: text = match.value.boolean ? "true" : "false";
+                break;
+            case Kind::Integer: text = std::to_string(match.value.integer);
+                break;
+            case Kind::Float: text = std::to_string(match.value.number);
+                break;
+            case Kind::String: text = match.value.string;
+                break;
+            case Kind::Object: text = "{}";
+                break;
+            case Kind::Array: text = "[]";
+                break;
+        }
+        found.push_back({match.pointer, match.element, std::move(text)});
+    });
+    if (parsed)
+        *parsed = whole;
+    return found;
+}
+} // namespace
+
+TEST_CASE("Only the selected values are handed over", "[json_select]") {
+    const json_select::Selector selector{"/data/link", "/success", "/status"};
+    const auto found = selectAll(
+        R"({"data": {"id": "abc", "link": "https://i.imgur.com/abc.png", "tags": [1, 2]},
+            "success": true, "status": 200, "extra": {"link": "not this one"}})", selector);
+    CHECK(found == std::vector<Found>{
+        {0, 0, "https://i.imgur.com/abc.png"},
+        {1, 0, "true"},
+        {2, 0, "200"},
+    });
+}
+
+TEST_CASE("A wildcard selects the same field of every element", "[json_select]") {
+    const json_select::Selector selector{"/tracks/*/name", "/tracks/*/artist"};
+    const auto found = selectAll(
+        R"({"tracks": [{"name": "A", "artist": "X", "image": [{"#text": "u"}]},
+                       {"artist": "Y", "name": "B"},
+                       {"listeners": "3"}]})", selector);
+    CHECK(found == std::vector<Found>{
+        {0, 0, "A"},
+        {1, 0, "X"},
+        {1, 1, "Y"},
+        {0, 1, "B"},
+    });
+}
+
+TEST_CASE("An index selects one element", "[json_select]") {
+    const json_select::Selector selector{"/links/1/title"};
+    const auto found = selectAll(R"({"links": [{"title": "a"}, {"title": "b"}, {"title": "c"}]})",
+                                 selector);
+    CHECK(found == std::vector<Found>{{0, 1, "b"}});
+}
+
+TEST_CASE("A pointer ending at an object or array reports it is there", "[json_select]") {
+    const json_select::Selector selector{"/results/trackmatches/track", "/missing"};
+    const auto found = selectAll(R"({"results": {"trackmatches": {"track": []}}})", selector);
+    CHECK(found == std::vector<Found>{{0, 0, "[]"}});
+}
+
+TEST_CASE("Escaped pointer tokens match the keys they spell", "[json_select]") {
+    const json_select::Selector selector{"/a~1b", "/c~0d", "/opensearch:totalResults"};
+    const auto found = selectAll(R"({"a/b": 1, "c~d": 2, "opensearch:totalResults": "40"})",
+                                 selector);
+    CHECK(found == std::vector<Found>{{0, 0, "1"}, {1, 0, "2"}, {2, 0, "40"}});
+}
+
+TEST_CASE("A malformed document reports what came before the fault", "[json_select]") {
+    const json_select::Selector selector{"/error", "/message"};
+    bool parsed = true;
+    const auto found = selectAll(R"({"error": 9, "message": "Invalid ses)", selector, &parsed);
+    CHECK_FALSE(parsed);
+    CHECK(found == std::vector<Found>{{0, 0, "9"}});
+
+    CHECK(selectAll("", selector, &parsed).empty());
+    CHECK_FALSE(parsed);
+}
+
+TEST_CASE("An integer is read from a number or a string spelling one", "[json_select]") {
+    const json_select::Selector selector{"/code"};
+    for (const auto *json : {R"({"code": 29})", R"({"code": "29"})"}) {
+        std::optional<std::int64_t> code;
+        json_select::select(json, selector, [&](const json_select::Match &match) {
+            code = match.value.asInteger();
+        });
+        CHECK(code == 29);
+    }
+    std::optional<std::int64_t> code = 0;
+    json_select::select(R"({"code": "29a"})", selector, [&](const json_select::Match &match) {
+        code = match.value.asInteger();
+    });
+    CHECK_FALSE(code.has_value());
+}
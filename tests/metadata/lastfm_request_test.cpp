@@ -0,0 +1,99 @@
+/**
+ * @file lastfm_request_test.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include "metadata/sources/lastfm_request.hpp"
+#include "security/md5.hpp"
+
+namespace {
+std::string md5(const std::string_view data) {
+    const auto digest = Md5::hex(data);
+    return {digest.data(), digest.size()};
+}
+} // namespace
+
+TEST_CASE("A request is encoded in parameter name order", "[lastfm]") {
+    LastFmRequest request("track.search", "KEY");
+    request.set("track", "Bohemian Rhapsody").set("artist", "Queen").set("limit", "5");
+
+    CHECK(request.size() == 5);
+    CHECK(request.body() ==
+          "api_key=KEY&artist=Queen&limit=5&method=track.search&track=Bohemian%20Rhapsody"
+          "&format=json");
+    CHECK(request.url() == std::string(kLastFmEndpoint) + "?" + request.body());
+}
+
+TEST_CASE("A signed request carries the signature Last.fm documents", "[lastfm]") {
+    LastFmRequest request("auth.getSession", "KEY");
+    request.set("token", "TOKEN").sign("SECRET");
+
+    const auto expected = md5("api_keyKEYmethodauth.getSessiontokenTOKENSECRET");
+    CHECK(request.body() ==
+          "api_key=KEY&method=auth.getSession&token=TOKEN&api_sig=" + expected + "&format=json");
+}
+
+TEST_CASE("A request signs values as given and sends them escaped", "[lastfm]") {
+    LastFmRequest request("track.scrobble", "KEY");
+    request.set("artist[0]", "AC/DC").set("track[0]", "T.N.T. & more").sign("SECRET");
+
+    const auto expected =
+        md5("api_keyKEYartist[0]AC/DCmethodtrack.scrobbletrack[0]T.N.T. & moreSECRET");
+    CHECK(request.body() ==
+          "api_key=KEY&artist%5B0%5D=AC%2FDC&method=track.scrobble"
+          "&track%5B0%5D=T.N.T.%20%26%20more&api_sig=" + expected + "&format=json");
+}
+
+TEST_CASE("Setting a parameter again replaces it", "[lastfm]") {
+    LastFmRequest request("track.search", "KEY");
+    request.set("limit", "5").set("limit", "50");
+    CHECK(request.size() == 3);
+    CHECK(request.body() == "api_key=KEY&limit=50&method=track.search&format=json");
+}
+
+TEST_CASE("Non-ASCII text is sent as escaped UTF-8", "[lastfm]") {
+    LastFmRequest request("track.search", "KEY");
+    request.set("artist", "Sigur Rós");
+    CHECK(request.body() == "api_key=KEY&artist=Sigur%20R%C3%B3s&method=track.search&format=json");
+}
+
+TEST_CASE("A JSON response's status is read", "[lastfm]") {
+    const auto ok = parseLastFmStatus(R"({"nowplaying": {"track": {"#text": "X"}}})");
+    CHECK(ok.ok);
+    CHECK(ok.error == LastFmError::None);
+
+    const auto refused = parseLastFmStatus(
+        R"({"message": "Invalid session key - Please re-authenticate", "error": 9})");
+    CHECK_FALSE(refused.ok);
+    CHECK(refused.error == LastFmError::InvalidSessionKey);
+    CHECK(refused.message == "Invalid session key - Please re-authenticate");
+    CHECK_FALSE(refused.retryable());
+
+    const auto busy = parseLastFmStatus(R"({"error": "29", "message": "Rate limit exceeded"})");
+    CHECK(busy.error == LastFmError::RateLimitExceeded);
+    CHECK(busy.retryable());
+}
+
+TEST_CASE("An XML response's status is read", "[lastfm]") {
+    CHECK(parseLastFmStatus("<?xml version=\"1.0\"?>\n<lfm status=\"ok\">\n</lfm>").ok);
+
+    const auto refused = parseLastFmStatus(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<lfm status=\"failed\">\n"
+        "<error code=\"11\">Service Offline - This service is temporarily offline</error>\n</lfm>");
+    CHECK_FALSE(refused.ok);
+    CHECK(refused.error == LastFmError::ServiceOffline);
+    CHECK(refused.message == "Service Offline - This service is temporarily offline");
+    CHECK(refused.retryable());
+}
+
+TEST_CASE("A body that is not a Last.fm response is not ok", "[lastfm]") {
+    for (const auto *body : {"", "{truncated", "<html><body>502 Bad Gateway</body></html>", "[]"}) {
+        const auto status = parseLastFmStatus(body);
+        CHECK_FALSE(status.ok);
+        CHECK(status.error == LastFmError::None);
+        CHECK_FALSE(status.retryable());
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ * @file lastfm_test.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+#include "metadata/sources/lastfm.hpp"
+
+namespace {
+using enum ScrobbleStatus;
+
+/// One entry of a track.scrobble response, as Last.fm lays it out, ignored with the given code.
+std::string scrobbleEntry(const std::string &track, const std::string &code) {
+    return R"({"artist": {"corrected": "0", "#text": "Queen"},)"
+           R"( "album": {"corrected": "0", "#text": "A Night at the Opera"},)"
+           R"( "track": {"corrected": "0", "#text": ")" + track + R"("},)"
+           R"( "albumArtist": {"corrected": "0", "#text": ""}, "timestamp": "1760000000",)"
+           R"( "ignoredMessage": {"code": )" + code + R"(, "#text": ""}})";
+}
+
+/// A whole track.scrobble response around its scrobbles, an array or a single object.
+std::string scrobbleResponse(const std::string &scrobbles) {
+    return R"({"scrobbles": {"scrobble": )" + scrobbles +
+           R"(, "@attr": {"ignored": 0, "accepted": 1}}})";
+}
+} // namespace
+
+TEST_CASE("A single scrobble comes back as an object, not an array", "[lastfm]") {
+    const auto body = scrobbleResponse(scrobbleEntry("Bohemian Rhapsody", R"("0")"));
+    CHECK(LastFm::parseScrobbles(body, 1) == std::vector{Accepted});
+}
+
+TEST_CASE("Each play is read by its ignoredMessage code", "[lastfm]") {
+    const auto body = scrobbleResponse("[" + scrobbleEntry("Bohemian Rhapsody", R"("0")") + ", " +
+                                       scrobbleEntry("Love of My Life", R"("5")") + ", " +
+                                       scrobbleEntry("'39", R"("1")") + ", " +
+                                       scrobbleEntry("Death on Two Legs", R"("3")") + "]");
+    // 0 was accepted; 5 hit the daily limit and is still owed; anything else was turned away.
+    CHECK(LastFm::parseScrobbles(body, 4) == std::vector{Accepted, Failed, Ignored, Ignored});
+}
+
+TEST_CASE("A numeric ignoredMessage code is read as its string would be", "[lastfm]") {
+    const auto body = scrobbleResponse("[" + scrobbleEntry("Bohemian Rhapsody", "0") + ", " +
+                                       scrobbleEntry("Love of My Life", "5") + ", " +
+                                       scrobbleEntry("'39", "1") + "]");
+    CHECK(LastFm::parseScrobbles(body, 3) == std::vector{Accepted, Failed, Ignored});
+}
+
+TEST_CASE("A play with no ignoredMessage was accepted", "[lastfm]") {
+    const auto body = scrobbleResponse(
+        R"([{"artist": {"#text": "Queen"}, "track": {"#text": "Bohemian Rhapsody"}}])");
+    CHECK(LastFm::parseScrobbles(body, 1) == std::vector{Accepted});
+}
+
+TEST_CASE("Plays the response has no entry for are still owed", "[lastfm]") {
+    const auto body = scrobbleResponse("[" + scrobbleEntry("Bohemian Rhapsody", R"("0")") + "]");
+    CHECK(LastFm::parseScrobbles(body, 3) == std::vector{Accepted, Failed, Failed});
+}
+
+TEST_CASE("A refused or malformed scrobble fails every play", "[lastfm]") {
+    const std::vector expected{Failed, Failed};
+    CHECK(LastFm::parseScrobbles(
+              R"({"message": "Invalid session key - Please re-authenticate", "error": 9})", 2) ==
+          expected);
+    CHECK(LastFm::parseScrobbles(R"({"error": 29, "message": "Rate limit exceeded"})", 2) ==
+          expected);
+    CHECK(LastFm::parseScrobbles(R"({"scrobbles": {"scrobble": [{"artist": )", 2) == expected);
+    CHECK(LastFm::parseScrobbles(R"({"scrobbles": {}})", 2) == expected);
+    CHECK(LastFm::parseScrobbles("<html><body>502 Bad Gateway</body></html>", 2) == expected);
+}
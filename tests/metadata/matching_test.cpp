@@ -93,3 +93,19 @@ TEST_CASE("Two empty strings match", "[matching]") {
     // Tracks routinely arrive with an empty album; two of them are as similar as strings get.
     CHECK(fuzzyMatch("", ""));
 }
+
+TEST_CASE("A match scores by how closely it fits", "[matching]") {
+    CHECK(matchScore("Bohemian Rhapsody", "bohemian rhapsody") == 100.0);
+    // One dropped letter is a close match; a changed word and an added one make a loose one.
+    CHECK(matchScore("Bohemian Rhapsody", "Bohemian Rapsody") >= kConfidentMatch);
+    const double loose = matchScore("Somebody to Love", "Somebody to Lose You");
+    CHECK(loose >= kMatchGenerosity);
+    CHECK(loose < kConfidentMatch);
+}
+
+TEST_CASE("Containment scores as a confident match only when opted in", "[matching]") {
+    CHECK(matchScore("Under Pressure", "Under Pressure - Remastered", true) == kSubstringScore);
+    CHECK(matchScore("Under Pressure", "Under Pressure - Remastered") < kSubstringScore);
+    // A ratio already above the containment score is kept.
+    CHECK(matchScore("Under Pressure", "Under Pressure!", true) > kSubstringScore);
+}
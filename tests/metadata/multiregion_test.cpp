@@ -0,0 +1,245 @@
+/**
+ * @file multiregion_test.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "metadata/cache.hpp"
+#include "metadata/sources/multiregion.hpp"
+
+namespace {
+Track makeTrack(const std::string &artist = "Queen") {
+    Track track;
+    track.identity.title = "Bohemian Rhapsody";
+    track.identity.artist = artist;
+    track.identity.album = "A Night at the Opera";
+    return track;
+}
+
+/**
+ * A leveldb directory under temp, removed on destruction. Never the real song_db.
+ */
+class TempDb {
+public:
+    TempDb() {
+        static std::mt19937_64 rng{std::random_device{}()};
+        _path = std::filesystem::temp_directory_path() /
+                ("musicpp_multiregion_test_" + std::to_string(rng()));
+    }
+
+    ~TempDb() {
+        std::error_code ec;
+        remove_all(_path, ec);
+    }
+
+    TempDb(const TempDb &) = delete;
+
+    TempDb &operator=(const TempDb &) = delete;
+
+    [[nodiscard]] const std::filesystem::path &path() const { return _path; }
+
+private:
+    std::filesystem::path _path;
+};
+
+/**
+ * One storefront's scripted answer, given after a while unless the search is cancelled first.
+ * Started searches answer from a thread of their own, as the engine's I/O thread would.
+ */
+class StorefrontSource final : public MetadataWebSource {
+public:
+    explicit StorefrontSource(SearchResult result,
+                              const std::chrono::milliseconds latency = std::chrono::milliseconds{})
+        : _result(std::move(result)), _latency(latency) {
+    }
+
+    SearchResult searchTrack(const Track &, const CallContext &context) override {
+        ++calls;
+        const auto until = std::chrono::steady_clock::now() + _latency;
+        while (std::chrono::steady_clock::now() < until) {
+            if (context.stop.stop_requested()) {
+                ++cancelled;
+                return SearchResult{.failed = true};
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{2});
+        }
+        return _result;
+    }
+
+    void harvestTrackAsync(const Track &track, const CallContext &context,
+                           std::function<void(SearchHarvest)> done) override {
+        std::lock_guard lock(_mutex);
+        _searches.emplace_back([this, track, context, done = std::move(done)] {
+            done(SearchHarvest{searchTrack(track, context)});
+        });
+    }
+
+    /// Waits for every search started to have answered.
+    void settle() {
+        std::lock_guard lock(_mutex);
+        _searches.clear();
+    }
+
+    std::string identify() override { return "apple"; }
+
+    std::atomic<int> calls{0};
+    std::atomic<int> cancelled{0};
+
+private:
+    SearchResult _result;
+    std::chrono::milliseconds _latency;
+    std::mutex _mutex;
+    std::vector<std::jthread> _searches;
+};
+
+SearchResult hit(const std::string &region) {
+    return SearchResult{.image_url = "https://img/" + region + ".jpg",
+                        .web_url = "https://music.apple.com/" + region + "/song/1"};
+}
+
+SearchResult miss() { return SearchResult{}; }
+
+SearchResult failure() { return SearchResult{.failed = true}; }
+
+/**
+ * A set of scripted storefronts, and a plan asking Canada, then the US and Britain.
+ */
+struct Storefronts {
+    std::map<ScraperRegions, std::shared_ptr<StorefrontSource> > sources;
+
+    void set(const ScraperRegions region, SearchResult result,
+             const std::chrono::milliseconds latency = std::chrono::milliseconds{0}) {
+        sources[region] = std::make_shared<StorefrontSource>(std::move(result), latency);
+    }
+
+    [[nodiscard]] MultiRegionScraper scraper(MetadataCache &cache) const {
+        const RegionPlan plan{.primary = ScraperRegions::CA,
+                              .fallbacks = {ScraperRegions::US, ScraperRegions::GB},
+                              .hedgeDelay = std::chrono::milliseconds{50}};
+        return MultiRegionScraper(cache, plan, [this](const ScraperRegions region) {
+            return std::static_pointer_cast<MetadataWebSource>(sources.at(region));
+        });
+    }
+
+    [[nodiscard]] int calls(const ScraperRegions region) const {
+        return sources.at(region)->calls.load();
+    }
+};
+} // namespace
+
+TEST_CASE("A primary storefront that has the track is the only one asked", "[multiregion]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Storefronts storefronts;
+    storefronts.set(ScraperRegions::CA, hit("ca"));
+    storefronts.set(ScraperRegions::US, hit("us"));
+    storefronts.set(ScraperRegions::GB, hit("gb"));
+    auto scraper = storefronts.scraper(cache);
+
+    CHECK(scraper.searchTrack(makeTrack(), {}) == hit("ca"));
+    CHECK(storefronts.calls(ScraperRegions::US) == 0);
+    CHECK(storefronts.calls(ScraperRegions::GB) == 0);
+    CHECK_FALSE(scraper.affinity("Queen").has_value());
+}
+
+TEST_CASE("A miss is hedged into the fallbacks, and the finder learned", "[multiregion]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Storefronts storefronts;
+    storefronts.set(ScraperRegions::CA, miss());
+    storefronts.set(ScraperRegions::US, miss());
+    storefronts.set(ScraperRegions::GB, hit("gb"));
+    auto scraper = storefronts.scraper(cache);
+
+    CHECK(scraper.searchTrack(makeTrack(), {}) == hit("gb"));
+    CHECK(scraper.affinity("Queen") == ScraperRegions::GB);
+    CHECK(scraper.affinity("queen") == ScraperRegions::GB);
+    CHECK_FALSE(scraper.affinity("ABBA").has_value());
+
+    // The artist's next track goes straight to Britain.
+    CHECK(scraper.searchTrack(makeTrack(), {}) == hit("gb"));
+    CHECK(storefronts.calls(ScraperRegions::CA) == 1);
+    CHECK(storefronts.calls(ScraperRegions::GB) == 2);
+}
+
+TEST_CASE("What is learned survives reopening the cache", "[multiregion]") {
+    const TempDb db;
+    Storefronts storefronts;
+    storefronts.set(ScraperRegions::CA, miss());
+    storefronts.set(ScraperRegions::US, hit("us"));
+    storefronts.set(ScraperRegions::GB, miss()); {
+        MetadataCache cache(db.path());
+        auto scraper = storefronts.scraper(cache);
+        CHECK(scraper.searchTrack(makeTrack(), {}) == hit("us"));
+    }
+
+    MetadataCache cache(db.path());
+    const auto scraper = storefronts.scraper(cache);
+    CHECK(scraper.affinity("Queen") == ScraperRegions::US);
+}
+
+TEST_CASE("A slow primary is hedged, and the storefronts left are cancelled", "[multiregion]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Storefronts storefronts;
+    storefronts.set(ScraperRegions::CA, hit("ca"), std::chrono::seconds{5});
+    storefronts.set(ScraperRegions::US, hit("us"));
+    storefronts.set(ScraperRegions::GB, miss());
+    auto scraper = storefronts.scraper(cache);
+
+    const auto start = std::chrono::steady_clock::now();
+    CHECK(scraper.searchTrack(makeTrack(), {}) == hit("us"));
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds{2});
+    storefronts.sources.at(ScraperRegions::CA)->settle();
+    CHECK(storefronts.sources.at(ScraperRegions::CA)->cancelled == 1);
+}
+
+TEST_CASE("A track no storefront has is a miss, not a failure", "[multiregion]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Storefronts storefronts;
+    storefronts.set(ScraperRegions::CA, failure());
+    storefronts.set(ScraperRegions::US, miss());
+    storefronts.set(ScraperRegions::GB, failure());
+    auto scraper = storefronts.scraper(cache);
+
+    CHECK(scraper.searchTrack(makeTrack(), {}) == miss());
+    CHECK_FALSE(scraper.affinity("Queen").has_value());
+
+    storefronts.set(ScraperRegions::US, failure());
+    auto failing = storefronts.scraper(cache);
+    CHECK(failing.searchTrack(makeTrack(), {}).failed);
+}
+
+TEST_CASE("A caller's stop ends the search at once", "[multiregion]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    Storefronts storefronts;
+    storefronts.set(ScraperRegions::CA, hit("ca"), std::chrono::seconds{5});
+    storefronts.set(ScraperRegions::US, hit("us"), std::chrono::seconds{5});
+    storefronts.set(ScraperRegions::GB, hit("gb"), std::chrono::seconds{5});
+    auto scraper = storefronts.scraper(cache);
+
+    std::stop_source stop;
+    std::jthread stopper([&stop] {
+        std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        stop.request_stop();
+    });
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = scraper.searchTrack(makeTrack(), CallContext{.stop = stop.get_token()});
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds{2});
+    CHECK(result.image_url.empty());
+    CHECK_FALSE(scraper.affinity("Queen").has_value());
+}
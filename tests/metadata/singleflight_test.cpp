@@ -0,0 +1,100 @@
+/**
+ * @file singleflight_test.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "metadata/singleflight.hpp"
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Concurrent callers for one key share a single call", "[singleflight]") {
+    SingleFlight<std::string, int> flight;
+    std::atomic runs{0};
+    std::atomic sum{0}; {
+        std::vector<std::jthread> callers;
+        for (int i = 0; i < 8; ++i) {
+            callers.emplace_back([&flight, &runs, &sum] {
+                sum += flight.run("queen", [&runs] {
+                    ++runs;
+                    std::this_thread::sleep_for(100ms);
+                    return 7;
+                });
+            });
+        }
+    }
+
+    CHECK(runs.load() == 1);
+    CHECK(sum.load() == 8 * 7);
+    CHECK(flight.inFlight() == 0);
+}
+
+TEST_CASE("Calls for different keys do not wait on each other", "[singleflight]") {
+    SingleFlight<std::string, int> flight;
+    std::atomic runs{0}; {
+        std::jthread first([&flight, &runs] {
+            (void) flight.run("queen", [&runs] {
+                ++runs;
+                std::this_thread::sleep_for(50ms);
+                return 1;
+            });
+        });
+        std::jthread second([&flight, &runs] {
+            (void) flight.run("abba", [&runs] {
+                ++runs;
+                std::this_thread::sleep_for(50ms);
+                return 2;
+            });
+        });
+    }
+
+    CHECK(runs.load() == 2);
+}
+
+TEST_CASE("A finished call is not remembered", "[singleflight]") {
+    SingleFlight<std::string, int> flight;
+    int runs = 0;
+
+    (void) flight.run("queen", [&runs] { return ++runs; });
+    const int second = flight.run("queen", [&runs] { return ++runs; });
+
+    CHECK(second == 2);
+}
+
+TEST_CASE("A throwing call reaches every caller and is then forgotten", "[singleflight]") {
+    SingleFlight<std::string, int> flight;
+
+    CHECK_THROWS_AS(flight.run("queen", []() -> int { throw std::runtime_error("down"); }),
+                    std::runtime_error);
+    CHECK(flight.inFlight() == 0);
+    CHECK(flight.run("queen", [] { return 3; }) == 3);
+}
+
+TEST_CASE("A caller joining a call waits for it only until its own deadline", "[singleflight]") {
+    SingleFlight<std::string, int> flight;
+    std::atomic started{false};
+    std::jthread leader([&flight, &started] {
+        (void) flight.run("queen", [&started] {
+            started = true;
+            std::this_thread::sleep_for(300ms);
+            return 7;
+        });
+    });
+    while (!started) {
+        std::this_thread::yield();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto joined = flight.run("queen", [] { return 0; }, start + 50ms);
+
+    CHECK_FALSE(joined.has_value());
+    CHECK(std::chrono::steady_clock::now() - start < 250ms);
+    CHECK(flight.run("queen", [] { return 0; }, std::nullopt) == 7);
+}
@@ -0,0 +1,188 @@
+/**
+ * @file upgrader_test.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "metadata/cache.hpp"
+#include "metadata/enricher.hpp"
+#include "metadata/upgrader.hpp"
+
+namespace {
+Track makeTrack(const std::string &title) {
+    Track track;
+    track.identity.title = title;
+    track.identity.artist = "Queen";
+    track.identity.album = "A Night at the Opera";
+    return track;
+}
+
+/**
+ * A leveldb directory under temp, removed on destruction. Never the real song_db.
+ */
+class TempDb {
+public:
+    TempDb() {
+        static std::mt19937_64 rng{std::random_device{}()};
+        _path = std::filesystem::temp_directory_path() /
+                ("musicpp_upgrader_test_" + std::to_string(rng()));
+    }
+
+    ~TempDb() {
+        std::error_code ec;
+        remove_all(_path, ec);
+    }
+
+    TempDb(const TempDb &) = delete;
+
+    TempDb &operator=(const TempDb &) = delete;
+
+    [[nodiscard]] const std::filesystem::path &path() const { return _path; }
+
+private:
+    std::filesystem::path _path;
+};
+
+/**
+ * A source matching every track closely, counting what it was asked.
+ */
+class MatchingSource final : public MetadataWebSource {
+public:
+    SearchResult searchTrack(const Track &track, const CallContext &) override {
+        ++calls;
+        return SearchResult{.image_url = "https://img/" + track.identity.title + ".jpg"};
+    }
+
+    std::string identify() override { return "apple"; }
+
+    std::atomic<int> calls{0};
+};
+
+/**
+ * A source handing back a scripted result, recording the titles it was asked for.
+ */
+class FakeSource final : public MetadataWebSource {
+public:
+    explicit FakeSource(SearchResult result) : _result(std::move(result)) {
+    }
+
+    SearchResult searchTrack(const Track &track, const CallContext &) override {
+        std::lock_guard lock(_mutex);
+        _asked.push_back(track.identity.title);
+        return _result;
+    }
+
+    std::string identify() override { return "apple"; }
+
+    [[nodiscard]] std::vector<std::string> titles() {
+        std::lock_guard lock(_mutex);
+        return _asked;
+    }
+
+private:
+    std::mutex _mutex;
+    std::vector<std::string> _asked{};
+    SearchResult _result;
+};
+
+void writeFallback(const MetadataCache &cache, const std::string &title) {
+    EnrichedTrack enriched;
+    enriched.track = makeTrack(title);
+    enriched.image = ImageUrl{.url = "https://imgur/" + title + ".png", .type = Static,
+                              .source = "imgur", .quality = ImageQuality::Fallback,
+                              .confidence = 0};
+    cache.writeEntry(enriched);
+}
+
+/**
+ * Spins until a condition holds, so a test never hangs on a walk that stalls.
+ */
+template<typename Predicate>
+bool waitFor(Predicate done, const std::chrono::milliseconds timeout = std::chrono::seconds(2)) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (done())
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return done();
+}
+
+constexpr UpgradeSchedule kQuick{.interval = std::chrono::milliseconds(5),
+                                 .rest = std::chrono::hours(1)};
+} // namespace
+
+TEST_CASE("The upgrader replaces every fallback in the cache", "[upgrader]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    writeFallback(cache, "A");
+    writeFallback(cache, "B");
+
+    Enricher enricher(cache);
+    auto source = std::make_shared<MatchingSource>();
+    enricher.registerSource(source);
+
+    const CacheUpgrader upgrader(cache, enricher, kQuick);
+
+    REQUIRE(waitFor([&upgrader] { return upgrader.upgraded() == 2; }));
+    CHECK(cache.findEntry(makeTrack("A"))->image.url == "https://img/A.jpg");
+    CHECK(cache.findEntry(makeTrack("B"))->image.quality == ImageQuality::Matched);
+}
+
+TEST_CASE("The upgrader rests once it reaches the end of the cache", "[upgrader]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    writeFallback(cache, "A");
+
+    Enricher enricher(cache);
+    auto source = std::make_shared<MatchingSource>();
+    enricher.registerSource(source);
+
+    const CacheUpgrader upgrader(cache, enricher, kQuick);
+    REQUIRE(waitFor([&upgrader] { return upgrader.upgraded() == 1; }));
+    // Several intervals, for the walk to look past A and find the end.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // A fallback written after the pass waits for the next one.
+    writeFallback(cache, "B");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(source->calls == 1);
+    CHECK(cache.findEntry(makeTrack("B"))->image.quality == ImageQuality::Fallback);
+}
+
+TEST_CASE("The upgrader carries on where it left off after a restart", "[upgrader]") {
+    const TempDb db;
+    MetadataCache cache(db.path());
+    writeFallback(cache, "A");
+    writeFallback(cache, "B");
+
+    {
+        // Finds nothing better for A, and is stopped well before it would try B.
+        Enricher enricher(cache);
+        auto source = std::make_shared<FakeSource>(SearchResult{});
+        enricher.registerSource(source);
+        const CacheUpgrader upgrader(cache, enricher,
+                                     UpgradeSchedule{.interval = std::chrono::milliseconds(200)});
+        REQUIRE(waitFor([&source] { return !source->titles().empty(); }));
+    }
+
+    Enricher enricher(cache);
+    auto source = std::make_shared<FakeSource>(SearchResult{.image_url = "https://img/b.jpg"});
+    enricher.registerSource(source);
+    const CacheUpgrader upgrader(cache, enricher, kQuick);
+
+    REQUIRE(waitFor([&upgrader] { return upgrader.upgraded() == 1; }));
+    const auto asked = source->titles();
+    REQUIRE(asked.size() == 1);
+    CHECK(asked.front() == "B");
+}
@@ -5,6 +5,7 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <catch2/catch_test_macros.hpp>
 #include <chrono>
 #include <filesystem>
@@ -12,6 +13,7 @@
 #include <optional>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 #include "discord/presence.hpp"
 #include "metadata/cache.hpp"
@@ -46,6 +48,20 @@ Track makeTrack(const std::string &title, const std::chrono::seconds position =
     return track;
 }
 
+/**
+ * Spins until a condition holds, so a test never hangs on an enrichment that stalls.
+ */
+template<typename Predicate>
+bool waitFor(Predicate done, const std::chrono::milliseconds timeout = 2s) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (done())
+            return true;
+        std::this_thread::sleep_for(1ms);
+    }
+    return done();
+}
+
 /// What the poller reports when no player is running at all.
 Track noPlayer() { return Track{}; }
 
@@ -121,8 +137,9 @@ public:
  */
 class CountingSource final : public MetadataWebSource {
 public:
-    SearchResult searchTrack(const Track &track) override {
+    SearchResult searchTrack(const Track &track, const CallContext &) override {
         ++calls;
+        std::this_thread::sleep_for(latency.load());
         return SearchResult{
             .image_url = "https://img/" + track.identity.title + ".jpg",
             .web_url = "https://apple/" + track.identity.title,
@@ -132,13 +149,20 @@ public:
 
     std::string identify() override { return "apple"; }
 
-    int calls = 0;
+    /// Called on the enrichment thread, so read from the test thread only once it has landed.
+    std::atomic<int> calls = 0;
+    std::atomic<std::chrono::milliseconds> latency{0ms};
 };
 
 /**
  * The whole poll → enrich → publish stack, with the edges faked out.
  */
 class Rig {
+    // Declared ahead of the orchestrator so they outlive an enrichment still running as it winds
+    // down.
+    TempDb _db;
+    MetadataCache _cache;
+
 public:
     Rig() : _cache(_db.path()) {
         auto poller = std::make_unique<FakePoller>();
@@ -154,6 +178,7 @@ public:
         orchestrator.registerPoller(std::move(poller));
         orchestrator.registerRichPresence(std::move(presence));
         orchestrator.registerEnricher(std::move(enricher));
+        orchestrator.registerWakeup([this] { ++landed; });
     }
 
     /// Runs one poll cycle, as main() does every 5 seconds.
@@ -162,24 +187,40 @@ public:
             orchestrator.run();
     }
 
-    Orchestrator orchestrator{};
+    /**
+     * Waits for the given number of enrichments to have landed in total, as main() would be woken
+     * for each.
+     * @return Whether they landed before the timeout.
+     */
+    [[nodiscard]] bool awaitEnrichments(const int count = 1) const {
+        return waitFor([this, count] { return landed.load() >= count; });
+    }
+
     FakePoller *poller = nullptr;
     FakePresence *presence = nullptr;
     std::shared_ptr<CountingSource> source{};
+    std::atomic<int> landed = 0;
 
-private:
-    TempDb _db;
-    MetadataCache _cache;
+    Orchestrator orchestrator{};
 };
 } // namespace
 
-TEST_CASE("A playing track is enriched and published", "[orchestrator]") {
+TEST_CASE("A playing track is published at once and upgraded once enriched", "[orchestrator]") {
     Rig rig;
+    rig.source->latency = 100ms;
     rig.poller->script = {makeTrack("Bohemian Rhapsody")};
 
     rig.cycle();
 
+    // The first publish does not wait on the source.
     REQUIRE(rig.presence->published.size() == 1);
+    CHECK(rig.presence->last().track.identity.title == "Bohemian Rhapsody");
+    CHECK(rig.presence->last().image.url.empty());
+
+    REQUIRE(rig.awaitEnrichments());
+    rig.cycle();
+
+    REQUIRE(rig.presence->published.size() == 2);
     const auto &published = rig.presence->last();
     CHECK(published.track.identity.title == "Bohemian Rhapsody");
     CHECK(published.image.url == "https://img/Bohemian Rhapsody.jpg");
@@ -187,6 +228,28 @@ TEST_CASE("A playing track is enriched and published", "[orchestrator]") {
     CHECK(rig.presence->cleared == 0);
 }
 
+TEST_CASE("An enrichment for a track since changed is discarded", "[orchestrator]") {
+    Rig rig;
+    rig.source->latency = 50ms;
+    rig.poller->script = {makeTrack("Bohemian Rhapsody"), makeTrack("Love of My Life")};
+
+    rig.cycle();
+    REQUIRE(rig.awaitEnrichments());
+    // The first track's enrichment has landed, but the track changes before it is applied.
+    rig.cycle();
+
+    CHECK(rig.presence->last().track.identity.title == "Love of My Life");
+    CHECK(rig.presence->last().image.url.empty());
+
+    REQUIRE(rig.awaitEnrichments(2));
+    rig.cycle();
+
+    CHECK(rig.presence->last().image.url == "https://img/Love of My Life.jpg");
+    for (const auto &published : rig.presence->published) {
+        CHECK(published.image.url != "https://img/Bohemian Rhapsody.jpg");
+    }
+}
+
 TEST_CASE("No player running publishes nothing", "[orchestrator]") {
     // Nothing was ever presented, so there is nothing to tear down either: the cycle is a no-op
     // rather than a needless clear on every poll while the player is closed.
@@ -219,6 +282,7 @@ TEST_CASE("The same track is not enriched twice", "[orchestrator]") {
     };
 
     rig.cycle(3);
+    REQUIRE(rig.awaitEnrichments());
 
     CHECK(rig.source->calls == 1);
     CHECK(rig.presence->published.size() == 3);
@@ -228,10 +292,14 @@ TEST_CASE("A different track is enriched afresh", "[orchestrator]") {
     Rig rig;
     rig.poller->script = {makeTrack("Bohemian Rhapsody"), makeTrack("Love of My Life")};
 
-    rig.cycle(2);
+    rig.cycle();
+    REQUIRE(rig.awaitEnrichments());
+    rig.cycle();
+    REQUIRE(rig.awaitEnrichments(2));
+    rig.cycle();
 
     CHECK(rig.source->calls == 2);
-    REQUIRE(rig.presence->published.size() == 2);
+    REQUIRE(rig.presence->published.size() == 3);
     CHECK(rig.presence->last().track.identity.title == "Love of My Life");
     CHECK(rig.presence->last().image.url == "https://img/Love of My Life.jpg");
 }
@@ -245,7 +313,9 @@ TEST_CASE("A track started over counts as a new play", "[orchestrator][restart]"
         makeTrack("Bohemian Rhapsody", 0s)
     };
 
-    rig.cycle(2);
+    rig.cycle();
+    REQUIRE(rig.awaitEnrichments());
+    rig.cycle();
 
     REQUIRE(rig.presence->published.size() == 2);
     const auto replayed = rig.presence->last().track.timing.current();
@@ -253,6 +323,7 @@ TEST_CASE("A track started over counts as a new play", "[orchestrator][restart]"
 
     // It is the same song, so the image it was already enriched with still stands.
     CHECK(rig.source->calls == 1);
+    CHECK(rig.presence->last().image.url == "https://img/Bohemian Rhapsody.jpg");
 }
 
 TEST_CASE("Ordinary progress is not mistaken for a restart", "[orchestrator][restart]") {
@@ -264,6 +335,7 @@ TEST_CASE("Ordinary progress is not mistaken for a restart", "[orchestrator][res
     };
 
     rig.cycle(3);
+    REQUIRE(rig.awaitEnrichments());
 
     CHECK(rig.source->calls == 1);
     REQUIRE(rig.presence->published.size() == 3);
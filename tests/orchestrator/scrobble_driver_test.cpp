@@ -8,8 +8,11 @@
 #include <atomic>
 #include <catch2/catch_test_macros.hpp>
 #include <chrono>
+#include <filesystem>
 #include <memory>
 #include <mutex>
+#include <random>
+#include <span>
 #include <string>
 #include <thread>
 #include <vector>
@@ -65,6 +68,20 @@ public:
         return acceptScrobble.load();
     }
 
+    std::vector<ScrobbleStatus> scrobbleBatch(const std::span<const Track> tracks) const override {
+        {
+            std::lock_guard lock(_mutex);
+            _batches.push_back(tracks.size());
+        }
+        auto statuses = Scrobbler::scrobbleBatch(tracks);
+        for (std::size_t i = 0; i < tracks.size(); ++i) {
+            if (statuses[i] == ScrobbleStatus::Accepted && tracks[i].identity.title == ignoreTitle) {
+                statuses[i] = ScrobbleStatus::Ignored;
+            }
+        }
+        return statuses;
+    }
+
     bool setPlaying(const Track &track) const override {
         std::lock_guard lock(_mutex);
         _playing.push_back(track.identity);
@@ -94,17 +111,26 @@ public:
         return _scrobbled;
     }
 
+    /// Size of each batch handed to scrobbleBatch(), in order.
+    [[nodiscard]] std::vector<std::size_t> batches() const {
+        std::lock_guard lock(_mutex);
+        return _batches;
+    }
+
     std::atomic<bool> isAuthed{true};
     std::atomic<bool> acceptNowPlaying{true};
     std::atomic<bool> acceptScrobble{true};
     std::atomic<std::chrono::milliseconds> latency{0ms};
     std::atomic<int> authCalls{0};
+    /// A title the scrobbler takes in a batch but ignores, as Last.fm does a filtered artist.
+    std::string ignoreTitle{};
 
 private:
     std::string _name;
     mutable std::mutex _mutex{};
     mutable std::vector<TrackIdentity> _playing{};
     mutable std::vector<TrackIdentity> _scrobbled{};
+    mutable std::vector<std::size_t> _batches{};
 };
 
 /// A schedule that plays out in milliseconds rather than half a minute.
@@ -146,6 +172,32 @@ void pumpFor(ScrobbleDriver &driver, const Track &track,
         std::this_thread::sleep_for(2ms);
     }
 }
+
+/**
+ * A journal path under temp, removed on destruction. Never the real journal.
+ */
+class TempJournal {
+public:
+    TempJournal() {
+        static std::mt19937_64 rng{std::random_device{}()};
+        _path = std::filesystem::temp_directory_path() /
+                ("musicpp_driver_journal_" + std::to_string(rng())) / "scrobbles.journal";
+    }
+
+    ~TempJournal() {
+        std::error_code ec;
+        remove_all(_path.parent_path(), ec);
+    }
+
+    TempJournal(const TempJournal &) = delete;
+
+    TempJournal &operator=(const TempJournal &) = delete;
+
+    [[nodiscard]] const std::filesystem::path &path() const { return _path; }
+
+private:
+    std::filesystem::path _path;
+};
 } // namespace
 
 TEST_CASE("A new play sends a now-playing update", "[scrobbler]") {
@@ -456,4 +508,143 @@ TEST_CASE("A refresh due while paused is held until the track resumes", "[scrobb
     // On resume it is finally re-sent.
     track.status = Playing;
     CHECK(pumpUntil(driver, track, [&] { return scrobbler->nowPlayings() >= 2; }));
-}
\ No newline at end of file
+}
+
+TEST_CASE("A play not scrobbled while current is replayed from the journal", "[scrobbler][journal]") {
+    const TempJournal file;
+    auto scrobbler = std::make_shared<FakeScrobbler>("lastfm");
+    scrobbler->acceptScrobble = false; // Offline.
+    {
+        ScrobbleDriver driver(fastSchedule());
+        driver.registerScrobbler(scrobbler);
+        driver.registerJournal(std::make_unique<ScrobbleJournal>(file.path()));
+
+        const auto offline = makeTrack("Bohemian Rhapsody", 3min);
+        driver.reset();
+        REQUIRE(pumpUntil(driver, offline, [&] { return scrobbler->scrobbles() >= 2; }));
+
+        // The user moves on while still offline, then the connection comes back.
+        driver.reset();
+        scrobbler->acceptScrobble = true;
+        const auto next = makeTrack("Somebody to Love");
+        REQUIRE(pumpUntil(driver, next, [&] {
+            const auto scrobbled = scrobbler->scrobbled();
+            return scrobbled.back() == offline.identity && scrobbler->scrobbles() > 2;
+        }));
+
+        // Accepted once, so never sent again.
+        const auto accepted = scrobbler->scrobbles();
+        pumpFor(driver, next, 150ms);
+        CHECK(scrobbler->scrobbles() == accepted);
+    }
+    CHECK(ScrobbleJournal(file.path()).size() == 0);
+}
+
+TEST_CASE("Plays left in the journal by an earlier run are replayed once each",
+          "[scrobbler][journal]") {
+    const TempJournal file;
+    constexpr int kOwed = 2 * static_cast<int>(kJournalBatch) + 7;
+    {
+        ScrobbleJournal journal(file.path());
+        for (int i = 0; i < kOwed; ++i) {
+            journal.record("lastfm", makeTrack("Owed " + std::to_string(i),
+                                               std::chrono::hours{kOwed - i}));
+        }
+    }
+
+    auto scrobbler = std::make_shared<FakeScrobbler>("lastfm");
+    {
+        ScrobbleDriver driver(fastSchedule());
+        driver.registerScrobbler(scrobbler);
+        driver.registerJournal(std::make_unique<ScrobbleJournal>(file.path()));
+
+        // A track too short to be scrobbled itself, so every scrobble is a replayed one.
+        const auto current = makeTrack("Interlude", 10s, 20s);
+        driver.reset();
+        REQUIRE(pumpUntil(driver, current, [&] { return scrobbler->scrobbles() >= kOwed; }));
+        pumpFor(driver, current, 150ms);
+    }
+
+    const auto scrobbled = scrobbler->scrobbled();
+    REQUIRE(scrobbled.size() == kOwed);
+    // Oldest first.
+    for (int i = 0; i < kOwed; ++i) {
+        CHECK(scrobbled[i].title == "Owed " + std::to_string(i));
+    }
+    // One call per full batch, then one for the rest.
+    const auto batches = scrobbler->batches();
+    CHECK(batches == std::vector<std::size_t>{kJournalBatch, kJournalBatch, 7});
+    CHECK(ScrobbleJournal(file.path()).size() == 0);
+}
+
+TEST_CASE("A play scrobbled while current is not replayed", "[scrobbler][journal]") {
+    const TempJournal file;
+    auto scrobbler = std::make_shared<FakeScrobbler>("lastfm");
+    {
+        ScrobbleDriver driver(fastSchedule());
+        driver.registerScrobbler(scrobbler);
+        driver.registerJournal(std::make_unique<ScrobbleJournal>(file.path()));
+
+        const auto track = makeTrack("Bohemian Rhapsody", 2min);
+        driver.reset();
+        REQUIRE(pumpUntil(driver, track, [&] { return scrobbler->scrobbles() >= 1; }));
+
+        // The same play picked up again, and then the next one.
+        driver.reset();
+        pumpFor(driver, track, 100ms);
+        driver.reset();
+        pumpFor(driver, makeTrack("Somebody to Love"), 100ms);
+    }
+
+    CHECK(scrobbler->scrobbles() == 1);
+    CHECK(ScrobbleJournal(file.path()).size() == 0);
+}
+
+TEST_CASE("A rejected replay keeps its plays for the next try", "[scrobbler][journal]") {
+    const TempJournal file;
+    {
+        ScrobbleJournal journal(file.path());
+        journal.record("lastfm", makeTrack("Owed", 1h));
+    }
+
+    auto scrobbler = std::make_shared<FakeScrobbler>("lastfm");
+    scrobbler->acceptScrobble = false;
+    ScrobbleDriver driver(fastSchedule());
+    driver.registerScrobbler(scrobbler);
+    driver.registerJournal(std::make_unique<ScrobbleJournal>(file.path()));
+
+    const auto current = makeTrack("Interlude", 10s, 20s);
+    driver.reset();
+    REQUIRE(pumpUntil(driver, current, [&] { return scrobbler->scrobbles() >= 3; }));
+
+    scrobbler->acceptScrobble = true;
+    const auto before = scrobbler->scrobbles();
+    REQUIRE(pumpUntil(driver, current, [&] { return scrobbler->scrobbles() > before; }));
+    pumpFor(driver, current, 150ms);
+    CHECK(scrobbler->scrobbles() == before + 1);
+}
+
+TEST_CASE("A play the scrobbler ignores is let go, not replayed", "[scrobbler][journal]") {
+    const TempJournal file;
+    {
+        ScrobbleJournal journal(file.path());
+        journal.record("lastfm", makeTrack("Ignored", 2h));
+        journal.record("lastfm", makeTrack("Owed", 1h));
+    }
+
+    auto scrobbler = std::make_shared<FakeScrobbler>("lastfm");
+    scrobbler->ignoreTitle = "Ignored";
+    {
+        ScrobbleDriver driver(fastSchedule());
+        driver.registerScrobbler(scrobbler);
+        driver.registerJournal(std::make_unique<ScrobbleJournal>(file.path()));
+
+        const auto current = makeTrack("Interlude", 10s, 20s);
+        driver.reset();
+        REQUIRE(pumpUntil(driver, current, [&] { return scrobbler->scrobbles() >= 2; }));
+        pumpFor(driver, current, 150ms);
+    }
+
+    CHECK(scrobbler->batches().size() == 1);
+    CHECK(ScrobbleJournal(file.path()).size() == 0);
+}
@@ -0,0 +1,249 @@
+/**
+ * @file scrobble_journal_test.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+#include "orchestrator/scrobble_journal.hpp"
+
+using namespace std::chrono_literals;
+
+namespace {
+/**
+ * A track that began the given time ago and runs for four minutes.
+ */
+Track makeTrack(const std::string &title = "Bohemian Rhapsody",
+                const std::chrono::seconds ago = 2min) {
+    Track track;
+    track.identity.title = title;
+    track.identity.artist = "Queen";
+    track.identity.album = "A Night at the Opera";
+    const auto start = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        (std::chrono::steady_clock::now() - ago).time_since_epoch()).count();
+    track.timing.set(start, start + std::chrono::nanoseconds(4min).count());
+    return track;
+}
+
+/**
+ * A journal path under temp, removed on destruction. Never the real journal.
+ */
+class TempJournal {
+public:
+    TempJournal() {
+        static std::mt19937_64 rng{std::random_device{}()};
+        _path = std::filesystem::temp_directory_path() /
+                ("musicpp_journal_test_" + std::to_string(rng())) / "scrobbles.journal";
+    }
+
+    ~TempJournal() {
+        std::error_code ec;
+        remove_all(_path.parent_path(), ec);
+    }
+
+    TempJournal(const TempJournal &) = delete;
+
+    TempJournal &operator=(const TempJournal &) = delete;
+
+    [[nodiscard]] const std::filesystem::path &path() const { return _path; }
+
+    [[nodiscard]] std::uintmax_t size() const { return file_size(_path); }
+
+private:
+    std::filesystem::path _path;
+};
+} // namespace
+
+TEST_CASE("A recorded play survives reopening the journal", "[journal]") {
+    const TempJournal file;
+    const auto track = makeTrack();
+    {
+        ScrobbleJournal journal(file.path());
+        REQUIRE(journal.record("lastfm", track).has_value());
+        journal.sync();
+    }
+
+    const ScrobbleJournal journal(file.path());
+    const auto pending = journal.pending("lastfm", kJournalBatch);
+    REQUIRE(pending.size() == 1);
+    CHECK(pending.front().identity == track.identity);
+    CHECK(pending.front().timestamp == track.timing.start());
+    CHECK(pending.front().length == 4min);
+
+    // Handed back as a track that began as long ago as the play did.
+    const auto replayed = pending.front().track();
+    CHECK(replayed.identity == track.identity);
+    CHECK(std::abs(replayed.timing.start() - track.timing.start()) <= 1);
+    CHECK(replayed.timing.total() == 4min);
+}
+
+TEST_CASE("Nothing reaches the file until the journal is synced", "[journal]") {
+    const TempJournal file;
+    ScrobbleJournal journal(file.path());
+    const auto empty = file.size();
+
+    journal.record("lastfm", makeTrack("Bohemian Rhapsody"));
+    journal.record("lastfm", makeTrack("Somebody to Love", 10min));
+    CHECK(file.size() == empty);
+
+    journal.sync();
+    CHECK(file.size() > empty);
+}
+
+TEST_CASE("An acknowledged play is gone for good", "[journal]") {
+    const TempJournal file;
+    {
+        ScrobbleJournal journal(file.path());
+        const auto first = journal.record("lastfm", makeTrack("Bohemian Rhapsody"));
+        journal.record("lastfm", makeTrack("Somebody to Love", 10min));
+        REQUIRE(first.has_value());
+        journal.acknowledge(std::vector{*first});
+        CHECK(journal.size() == 1);
+    }
+
+    const ScrobbleJournal journal(file.path());
+    const auto pending = journal.pending("lastfm", kJournalBatch);
+    REQUIRE(pending.size() == 1);
+    CHECK(pending.front().identity.title == "Somebody to Love");
+}
+
+TEST_CASE("A play is recorded once per scrobbler", "[journal]") {
+    const TempJournal file;
+    ScrobbleJournal journal(file.path());
+    const auto track = makeTrack();
+
+    const auto id = journal.record("lastfm", track);
+    REQUIRE(id.has_value());
+    // The same play again hands back the entry already made.
+    CHECK(journal.record("lastfm", track) == id);
+    // Another scrobbler is owed it in its own right.
+    CHECK(journal.record("libre", track).has_value());
+    CHECK(journal.size() == 2);
+
+    // Once scrobbled, the same play is not owed again.
+    journal.acknowledge(std::vector{*id});
+    CHECK_FALSE(journal.record("lastfm", track).has_value());
+    CHECK(journal.size() == 1);
+}
+
+TEST_CASE("Plays are handed out per scrobbler, oldest first", "[journal]") {
+    const TempJournal file;
+    ScrobbleJournal journal(file.path());
+    journal.record("lastfm", makeTrack("First", 30min));
+    journal.record("libre", makeTrack("Elsewhere", 25min));
+    journal.record("lastfm", makeTrack("Second", 20min));
+    journal.record("lastfm", makeTrack("Third", 10min));
+
+    const auto pending = journal.pending("lastfm", 2);
+    REQUIRE(pending.size() == 2);
+    CHECK(pending[0].identity.title == "First");
+    CHECK(pending[1].identity.title == "Second");
+    CHECK(journal.pending("libre", kJournalBatch).size() == 1);
+    CHECK(journal.pending("nobody", kJournalBatch).empty());
+}
+
+TEST_CASE("A torn record at the end of the journal is dropped", "[journal]") {
+    const TempJournal file;
+    {
+        ScrobbleJournal journal(file.path());
+        journal.record("lastfm", makeTrack("Bohemian Rhapsody", 10min));
+        journal.sync();
+        journal.record("lastfm", makeTrack("Somebody to Love"));
+    }
+    // A crash partway through writing the second play.
+    resize_file(file.path(), file.size() - 5);
+    {
+        const ScrobbleJournal journal(file.path());
+        const auto pending = journal.pending("lastfm", kJournalBatch);
+        REQUIRE(pending.size() == 1);
+        CHECK(pending.front().identity.title == "Bohemian Rhapsody");
+    }
+
+    // What is written after the recovery reads back whole.
+    {
+        ScrobbleJournal journal(file.path());
+        journal.record("lastfm", makeTrack("Killer Queen"));
+    }
+    const ScrobbleJournal journal(file.path());
+    CHECK(journal.size() == 2);
+}
+
+TEST_CASE("A corrupted record ends what is read of the journal", "[journal]") {
+    const TempJournal file;
+    {
+        ScrobbleJournal journal(file.path());
+        journal.record("lastfm", makeTrack("Bohemian Rhapsody", 10min));
+        journal.sync();
+        journal.record("lastfm", makeTrack("Somebody to Love"));
+    }
+    {
+        std::fstream out(file.path(), std::ios::in | std::ios::out | std::ios::binary);
+        out.seekp(-3, std::ios::end);
+        out.put('\x7f');
+    }
+
+    const ScrobbleJournal journal(file.path());
+    CHECK(journal.size() == 1);
+}
+
+TEST_CASE("A file that is not a journal is moved aside, not written over", "[journal]") {
+    const TempJournal file;
+    create_directories(file.path().parent_path());
+    std::ofstream(file.path(), std::ios::binary) << "title,artist\nBohemian Rhapsody,Queen\n";
+    {
+        ScrobbleJournal journal(file.path());
+        CHECK(journal.size() == 0);
+        journal.record("lastfm", makeTrack());
+    }
+    CHECK(ScrobbleJournal(file.path()).size() == 1);
+
+    std::vector<std::filesystem::path> aside;
+    for (const auto &entry : std::filesystem::directory_iterator(file.path().parent_path())) {
+        if (entry.path() != file.path())
+            aside.push_back(entry.path());
+    }
+    REQUIRE(aside.size() == 1);
+    std::ifstream in(aside.front(), std::ios::binary);
+    const std::string kept{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    CHECK(kept == "title,artist\nBohemian Rhapsody,Queen\n");
+}
+
+TEST_CASE("A journal mostly acknowledged is compacted", "[journal]") {
+    const TempJournal file;
+    {
+        ScrobbleJournal journal(file.path());
+        std::vector<std::uint64_t> ids;
+        for (int i = 0; i < 100; ++i) {
+            ids.push_back(*journal.record("lastfm", makeTrack("Track", std::chrono::hours{i + 1})));
+        }
+        journal.sync();
+        const auto full = file.size();
+
+        journal.record("lastfm", makeTrack("Kept"));
+        journal.acknowledge(ids);
+        journal.sync();
+        CHECK(file.size() < full / 10);
+    }
+
+    const ScrobbleJournal journal(file.path());
+    const auto pending = journal.pending("lastfm", kJournalBatch);
+    REQUIRE(pending.size() == 1);
+    CHECK(pending.front().identity.title == "Kept");
+}
+
+TEST_CASE("A journal with no path is kept in memory", "[journal]") {
+    ScrobbleJournal journal({});
+    const auto id = journal.record("lastfm", makeTrack());
+    REQUIRE(id.has_value());
+    journal.sync();
+    CHECK(journal.size() == 1);
+    journal.acknowledge(std::vector{*id});
+    CHECK(journal.size() == 0);
+}
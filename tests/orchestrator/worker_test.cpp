@@ -101,3 +101,53 @@ TEST_CASE("Jobs submitted from many threads all run", "[worker]") {
 
     CHECK(ran.load() == 32);
 }
+
+TEST_CASE("A pool runs jobs side by side", "[worker][pool]") {
+    std::atomic inFlight{0};
+    std::atomic peak{0}; {
+        WorkerPool pool(3);
+        for (int i = 0; i < 3; ++i) {
+            pool.submit([&inFlight, &peak] {
+                const int now = ++inFlight;
+                int seen = peak.load();
+                while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+                }
+                std::this_thread::sleep_for(50ms);
+                --inFlight;
+            });
+        }
+    }
+
+    CHECK(peak.load() == 3);
+}
+
+TEST_CASE("A pool never runs more jobs than it has threads", "[worker][pool]") {
+    std::atomic inFlight{0};
+    std::atomic peak{0};
+    std::atomic ran{0}; {
+        WorkerPool pool(2);
+        for (int i = 0; i < 8; ++i) {
+            pool.submit([&inFlight, &peak, &ran] {
+                const int now = ++inFlight;
+                int seen = peak.load();
+                while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+                }
+                std::this_thread::sleep_for(5ms);
+                --inFlight;
+                ++ran;
+            });
+        }
+    } // The destructor drains the queue before returning.
+
+    CHECK(peak.load() <= 2);
+    CHECK(ran.load() == 8);
+}
+
+TEST_CASE("A pool asked for no threads still gets one", "[worker][pool]") {
+    std::atomic ran{false};
+
+    WorkerPool pool(0);
+    pool.submit([&ran] { ran = true; });
+
+    CHECK(waitFor([&ran] { return ran.load(); }));
+}
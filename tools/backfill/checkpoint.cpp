@@ -0,0 +1,78 @@
+/**
+ * @file checkpoint.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "backfill/checkpoint.hpp"
+#include "log/log.hpp"
+
+#include <fstream>
+#include <system_error>
+
+Checkpoint::Checkpoint(std::filesystem::path path)
+    : _path(std::move(path)), _lastWritten(std::chrono::steady_clock::now()) {
+    if (_path.empty()) {
+        return;
+    }
+    std::ifstream in(_path);
+    if (in >> _resumeFrom) {
+        _watermark = _resumeFrom;
+        logging::get("backfill")->info("Resuming from track {}", _resumeFrom);
+    } else {
+        _resumeFrom = 0;
+    }
+}
+
+Checkpoint::~Checkpoint() {
+    flush();
+}
+
+std::size_t Checkpoint::resumeFrom() const {
+    return _resumeFrom;
+}
+
+void Checkpoint::markDone(const std::size_t index) {
+    std::lock_guard lock(_mutex);
+    if (index < _watermark) {
+        return;
+    }
+    _ahead.insert(index);
+    while (!_ahead.empty() && *_ahead.begin() == _watermark) {
+        _ahead.erase(_ahead.begin());
+        ++_watermark;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - _lastWritten >= kCheckpointInterval) {
+        _lastWritten = now;
+        write();
+    }
+}
+
+void Checkpoint::flush() {
+    std::lock_guard lock(_mutex);
+    write();
+}
+
+void Checkpoint::write() const {
+    if (_path.empty()) {
+        return;
+    }
+    auto temp = _path;
+    temp += ".tmp";
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        out << _watermark << '\n';
+        if (!out) {
+            logging::get("backfill")->warn("Could not write checkpoint {}", temp.string());
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, _path, ec);
+    if (ec) {
+        logging::get("backfill")->warn("Could not replace checkpoint {}: {}", _path.string(),
+                                       ec.message());
+    }
+}
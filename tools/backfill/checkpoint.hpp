@@ -0,0 +1,62 @@
+/**
+ * @file checkpoint.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <set>
+
+/// How often the checkpoint is written while a backfill runs.
+constexpr std::chrono::seconds kCheckpointInterval{10};
+
+/**
+ * Remembers how far through its track list a backfill got, so an interrupted run picks up where
+ * it left off. Tracks finish out of order across the workers; the checkpoint holds the index
+ * below which every track is done.
+ */
+class Checkpoint {
+public:
+    /**
+     * Reads the checkpoint at path, if there is one.
+     * @param path File the checkpoint is kept in. Empty keeps it in memory only.
+     */
+    explicit Checkpoint(std::filesystem::path path);
+
+    /// Writes the checkpoint one last time.
+    ~Checkpoint();
+
+    Checkpoint(const Checkpoint &) = delete;
+
+    Checkpoint &operator=(const Checkpoint &) = delete;
+
+    /// Index of the first track not known to be done when the checkpoint was read.
+    [[nodiscard]] std::size_t resumeFrom() const;
+
+    /**
+     * Marks a track done, writing the checkpoint if kCheckpointInterval has passed.
+     * @param index The track's index in the list.
+     */
+    void markDone(std::size_t index);
+
+    /// Writes the checkpoint now.
+    void flush();
+
+private:
+    /// Writes the watermark through a temporary file, so a crash leaves the old one whole.
+    void write() const;
+
+    std::filesystem::path _path;
+    std::size_t _resumeFrom = 0;
+    mutable std::mutex _mutex;
+    /// Every track below this is done.
+    std::size_t _watermark = 0;
+    /// Tracks done above the watermark, waiting on one before them.
+    std::set<std::size_t> _ahead{};
+    std::chrono::steady_clock::time_point _lastWritten{};
+};
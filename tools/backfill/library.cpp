@@ -0,0 +1,223 @@
+/**
+ * @file library.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+#include "backfill/library.hpp"
+#include "log/log.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+#include <nlohmann/json.hpp>
+
+using Json = nlohmann::json;
+
+namespace {
+std::string lower(std::string str) {
+    std::ranges::transform(str, str.begin(), [](const unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return str;
+}
+
+/**
+ * Reads one CSV record, which may span lines inside a quoted field.
+ * @return The record's fields, or nullopt at the end of the stream.
+ */
+std::optional<std::vector<std::string> > readRecord(std::istream &in) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    bool any = false;
+    char c;
+    while (in.get(c)) {
+        any = true;
+        if (quoted) {
+            if (c != '"') {
+                fields.back() += c;
+            } else if (in.peek() == '"') {
+                fields.back() += static_cast<char>(in.get());
+            } else {
+                quoted = false;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else if (c == '\n') {
+            break;
+        } else if (c != '\r') {
+            fields.back() += c;
+        }
+    }
+    if (!any) {
+        return std::nullopt;
+    }
+    return fields;
+}
+
+/// Text of an element, or empty if it has none.
+std::string textOf(const xmlNode *node) {
+    const std::unique_ptr<xmlChar, decltype(xmlFree)> text{xmlNodeGetContent(node), xmlFree};
+    return text ? std::string(reinterpret_cast<const char *>(text.get())) : "";
+}
+
+bool named(const xmlNode *node, const char *name) {
+    return node && node->type == XML_ELEMENT_NODE &&
+           xmlStrcmp(node->name, reinterpret_cast<const xmlChar *>(name)) == 0;
+}
+
+/// The next element after node, skipping text and comments.
+const xmlNode *nextElement(const xmlNode *node) {
+    for (node = node->next; node; node = node->next) {
+        if (node->type == XML_ELEMENT_NODE) {
+            return node;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Finds the value paired with a key in a plist dict.
+ * @return The value element, or nullptr if the key is absent.
+ */
+const xmlNode *dictValue(const xmlNode *dict, const std::string &key) {
+    for (const xmlNode *node = dict->children; node; node = node->next) {
+        if (named(node, "key") && textOf(node) == key) {
+            return nextElement(node);
+        }
+    }
+    return nullptr;
+}
+}
+
+std::vector<TrackIdentity> readCsv(std::istream &in) {
+    std::vector<TrackIdentity> tracks;
+    const auto header = readRecord(in);
+    if (!header) {
+        return tracks;
+    }
+
+    std::optional<std::size_t> title, artist, album;
+    for (std::size_t i = 0; i < header->size(); ++i) {
+        if (const auto name = lower((*header)[i]); name == "title" || name == "name") {
+            title = i;
+        } else if (name == "artist") {
+            artist = i;
+        } else if (name == "album") {
+            album = i;
+        }
+    }
+    if (!title || !artist) {
+        logging::get("backfill")->error("The CSV header names no title and artist columns");
+        return tracks;
+    }
+
+    while (const auto record = readRecord(in)) {
+        const auto field = [&record](const std::optional<std::size_t> column) {
+            return column && *column < record->size() ? (*record)[*column] : std::string{};
+        };
+        TrackIdentity identity;
+        identity.title = field(title);
+        identity.artist = field(artist);
+        identity.album = field(album);
+        if (!identity.title.empty() && !identity.artist.empty()) {
+            tracks.push_back(std::move(identity));
+        }
+    }
+    return tracks;
+}
+
+std::vector<TrackIdentity> readJsonLines(std::istream &in) {
+    std::vector<TrackIdentity> tracks;
+    std::string line;
+    std::size_t number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        const Json j = Json::parse(line, nullptr, false);
+        if (!j.is_object()) {
+            logging::get("backfill")->warn("Skipping line {}: not a JSON object", number);
+            continue;
+        }
+        TrackIdentity identity;
+        identity.title = j.value("title", j.value("name", ""));
+        identity.artist = j.value("artist", "");
+        identity.album = j.value("album", "");
+        if (!identity.title.empty() && !identity.artist.empty()) {
+            tracks.push_back(std::move(identity));
+        }
+    }
+    return tracks;
+}
+
+std::vector<TrackIdentity> readLibraryXml(const std::filesystem::path &path) {
+    std::vector<TrackIdentity> tracks;
+    const std::unique_ptr<xmlDoc, decltype(&xmlFreeDoc)> doc{
+        xmlReadFile(path.string().c_str(), nullptr, XML_PARSE_NONET | XML_PARSE_NOBLANKS),
+        &xmlFreeDoc
+    };
+    if (!doc) {
+        logging::get("backfill")->error("Could not parse {}", path.string());
+        return tracks;
+    }
+
+    // <plist><dict> ... <key>Tracks</key><dict> <key>id</key><dict>...</dict> ... </dict></dict>
+    const xmlNode *plist = xmlDocGetRootElement(doc.get());
+    const xmlNode *root = plist ? plist->children : nullptr;
+    while (root && !named(root, "dict")) {
+        root = root->next;
+    }
+    const xmlNode *all = root ? dictValue(root, "Tracks") : nullptr;
+    if (!named(all, "dict")) {
+        logging::get("backfill")->error("{} holds no Tracks dictionary", path.string());
+        return tracks;
+    }
+
+    for (const xmlNode *entry = all->children; entry; entry = entry->next) {
+        if (!named(entry, "dict")) {
+            continue; // the track id keys between the entries
+        }
+        const auto string = [entry](const char *key) {
+            const xmlNode *value = dictValue(entry, key);
+            return named(value, "string") ? textOf(value) : std::string{};
+        };
+        TrackIdentity identity;
+        identity.title = string("Name");
+        identity.artist = string("Artist");
+        identity.album = string("Album");
+        if (!identity.title.empty() && !identity.artist.empty()) {
+            tracks.push_back(std::move(identity));
+        }
+    }
+    return tracks;
+}
+
+std::vector<TrackIdentity> readLibrary(const std::filesystem::path &path) {
+    const auto extension = lower(path.extension().string());
+    if (extension == ".xml") {
+        return readLibraryXml(path);
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        logging::get("backfill")->error("Could not open {}", path.string());
+        return {};
+    }
+    if (extension == ".csv") {
+        return readCsv(in);
+    }
+    if (extension == ".jsonl" || extension == ".ndjson" || extension == ".json") {
+        return readJsonLines(in);
+    }
+    logging::get("backfill")->error("Unknown track list format '{}'", extension);
+    return {};
+}
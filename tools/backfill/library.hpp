@@ -0,0 +1,49 @@
+/**
+ * @file library.hpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+/**
+ * Reads the track lists the backfill tool works through.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <istream>
+#include <vector>
+
+#include "types/track.hpp"
+
+/**
+ * Reads CSV with a header row. The title ("title" or "name"), artist and album columns are found
+ * by name, in any order and any case; other columns are ignored. Fields may be quoted, with ""
+ * for a literal quote.
+ * @param in Stream to read.
+ * @return Every row with a title and an artist, in file order.
+ */
+[[nodiscard]] std::vector<TrackIdentity> readCsv(std::istream &in);
+
+/**
+ * Reads JSON lines: one object per line, with "title" (or "name"), "artist" and "album" strings.
+ * Blank and malformed lines are skipped.
+ * @param in Stream to read.
+ * @return Every line with a title and an artist, in file order.
+ */
+[[nodiscard]] std::vector<TrackIdentity> readJsonLines(std::istream &in);
+
+/**
+ * Reads the Tracks dictionary of an iTunes/Apple Music Library.xml export.
+ * @param path Path to the export.
+ * @return Every track with a name and an artist, in file order. Empty if the file cannot be read.
+ */
+[[nodiscard]] std::vector<TrackIdentity> readLibraryXml(const std::filesystem::path &path);
+
+/**
+ * Reads a track list, picking the format from the file extension: .csv, .jsonl/.ndjson/.json, or
+ * .xml for a library export.
+ * @param path Path to the list.
+ * @return The tracks, in file order. Empty if the file cannot be read or its format is unknown.
+ */
+[[nodiscard]] std::vector<TrackIdentity> readLibrary(const std::filesystem::path &path);
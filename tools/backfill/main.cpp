@@ -0,0 +1,255 @@
+/**
+ * @file main.cpp
+ * @author Jonathan Deng (https://github.com/Amqx)
+ * @date 19-Oct-26
+ */
+
+/**
+ * musicpp_backfill: runs a whole library through the enricher ahead of time, so the app finds its
+ * tracks already in the cache.
+ *
+ *   musicpp_backfill <library> [--jobs N] [--rate calls/s] [--checkpoint path] [--db path]
+ *                              [--region cc]
+ *
+ * The library is CSV, JSON lines or a Library.xml export; see library.hpp. Last.fm is searched
+ * too when LASTFM_KEY and LASTFM_SECRET are set.
+ */
+
+#include "backfill/checkpoint.hpp"
+#include "backfill/library.hpp"
+#include "log/log.hpp"
+#include "log/logGlobal.hpp"
+#include "metadata/cache.hpp"
+#include "metadata/enricher.hpp"
+#include "metadata/http/httpClient.hpp"
+#include "metadata/http/rateLimiter.hpp"
+#include "metadata/sources/lastfm.hpp"
+#include "metadata/sources/lastfm_request.hpp"
+#include "metadata/sources/scraper.hpp"
+
+#include <atomic>
+#include <csignal>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+/// Tracks enriched at once unless --jobs says otherwise.
+constexpr std::size_t kDefaultJobs{4};
+
+/// Calls per second let through to each host unless --rate says otherwise. Well under what
+/// either host tolerates, since a backfill runs for a long time.
+constexpr double kDefaultRate{2.0};
+
+/// How often a progress line is printed.
+constexpr std::chrono::seconds kProgressInterval{5};
+
+std::atomic<bool> stopping{false};
+
+void onInterrupt(int) {
+    stopping.store(true);
+}
+
+struct Options {
+    std::filesystem::path library;
+    std::size_t jobs = kDefaultJobs;
+    double rate = kDefaultRate;
+    std::filesystem::path checkpoint;
+    std::optional<std::filesystem::path> db;
+    std::string region = "ca";
+};
+
+void usage() {
+    std::cerr << "usage: musicpp_backfill <library.csv|.jsonl|.xml> [--jobs N] "
+        "[--rate calls/s per host] [--checkpoint path] [--db path] [--region cc]\n";
+}
+
+/**
+ * Reads the command line.
+ * @return The options, or nullopt if they do not parse.
+ */
+std::optional<Options> parseArgs(const int argc, char **argv) {
+    Options options;
+    bool haveLibrary = false;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const auto value = [&]() -> std::string {
+                if (i + 1 >= argc)
+                    throw std::invalid_argument(arg + " needs a value");
+                return argv[++i];
+            };
+            if (arg == "--jobs") {
+                options.jobs = std::max<std::size_t>(std::stoul(value()), 1);
+            } else if (arg == "--rate") {
+                options.rate = std::stod(value());
+            } else if (arg == "--checkpoint") {
+                options.checkpoint = value();
+            } else if (arg == "--db") {
+                options.db = value();
+            } else if (arg == "--region") {
+                options.region = value();
+            } else if (!arg.starts_with("--") && !haveLibrary) {
+                options.library = arg;
+                haveLibrary = true;
+            } else {
+                throw std::invalid_argument("unexpected argument " + arg);
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        return std::nullopt;
+    }
+    if (!haveLibrary)
+        return std::nullopt;
+    if (options.checkpoint.empty()) {
+        options.checkpoint = options.library;
+        options.checkpoint += ".checkpoint";
+    }
+    return options;
+}
+
+std::string formatDuration(const std::chrono::seconds total) {
+    const auto h = std::chrono::duration_cast<std::chrono::hours>(total);
+    const auto m = std::chrono::duration_cast<std::chrono::minutes>(total - h);
+    const auto s = total - h - m;
+    return fmt::format("{}:{:02}:{:02}", h.count(), m.count(), s.count());
+}
+}
+
+int main(const int argc, char **argv) {
+    const auto options = parseArgs(argc, argv);
+    if (!options) {
+        usage();
+        return 2;
+    }
+    logging::init();
+    const auto log = logging::get("backfill");
+
+    const auto tracks = readLibrary(options->library);
+    if (tracks.empty()) {
+        std::cerr << "No tracks read from " << options->library.string() << '\n';
+        return 1;
+    }
+
+    Checkpoint checkpoint(options->checkpoint);
+    const std::size_t first = std::min(checkpoint.resumeFrom(), tracks.size());
+
+    std::optional<MetadataCache> cache;
+    if (options->db) {
+        cache.emplace(*options->db);
+    } else {
+        cache.emplace();
+    }
+
+    // Every source may be searched for every track in flight, so the source threads scale with
+    // the jobs; the hosts' rate limits, not the thread count, are what keep them from being
+    // flooded. Each host is held to --rate, and Last.fm never above what it allows anyway.
+    const RateLimit limit{.perSecond = options->rate};
+    RateLimiter::limitHost(hostOf(kScraperEndpoint), limit);
+    RateLimiter::limitHost(hostOf(kLastFmEndpoint),
+                           limit.perSecond > 0 && limit.perSecond < kLastFmRateLimit.perSecond
+                               ? limit
+                               : kLastFmRateLimit);
+
+    std::vector<std::shared_ptr<MetadataWebSource> > sources;
+    sources.push_back(std::make_shared<Scraper>(options->region));
+    const auto key = envVar("LASTFM_KEY"), secret = envVar("LASTFM_SECRET");
+    if (key && secret && !key->empty() && !secret->empty()) {
+        sources.push_back(std::make_shared<LastFm>(*key, *secret));
+    }
+
+    // Bulk, so a backfill run alongside the app never holds up its lookups.
+    Enricher enricher(*cache, EnrichSchedule{
+                          .sourceThreads = options->jobs * sources.size(),
+                          .adaptiveOrder = true,
+                          .priority = CallPriority::Bulk
+                      });
+    for (auto &source : sources) {
+        enricher.registerSource(std::move(source));
+    }
+
+    std::signal(SIGINT, onInterrupt);
+    log->info("Backfilling {} track(s) from {}, starting at {}, {} at a time", tracks.size(),
+              options->library.string(), first, options->jobs);
+
+    std::atomic<std::size_t> next{first};
+    std::atomic<std::size_t> done{0};
+    std::atomic<std::size_t> empty{0};
+    const auto started = std::chrono::steady_clock::now();
+    {
+        std::vector<std::jthread> workers;
+        for (std::size_t w = 0; w < options->jobs; ++w) {
+            workers.emplace_back([&] {
+                while (!stopping.load()) {
+                    const std::size_t index = next.fetch_add(1);
+                    if (index >= tracks.size())
+                        return;
+                    Track track;
+                    track.identity = tracks[index];
+                    // Already cached tracks come straight back, so a rerun only pays for the rest.
+                    if (const auto enriched = enricher.enrich(track, std::nullopt);
+                        enriched.image.url.empty() && enriched.songUrls.empty()) {
+                        empty.fetch_add(1);
+                        log->debug("Nothing found for {}", track.identity);
+                    }
+                    checkpoint.markDone(index);
+                    done.fetch_add(1);
+                }
+            });
+        }
+
+        const std::size_t remaining = tracks.size() - first;
+        auto lastPrinted = started;
+        while (done.load() < remaining && !stopping.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            const auto now = std::chrono::steady_clock::now();
+            if (now - lastPrinted < kProgressInterval)
+                continue;
+            lastPrinted = now;
+
+            const auto count = done.load();
+            const double elapsed = std::chrono::duration<double>(now - started).count();
+            const double rate = elapsed > 0 ? static_cast<double>(count) / elapsed : 0.0;
+            const auto eta = rate > 0
+                                 ? std::chrono::seconds(static_cast<std::int64_t>(
+                                     static_cast<double>(remaining - count) / rate))
+                                 : std::chrono::seconds{};
+            std::cout << fmt::format("{}/{} ({:.1f}%), {:.2f} tracks/s, eta {}\n", first + count,
+                                     tracks.size(),
+                                     100.0 * static_cast<double>(first + count) /
+                                     static_cast<double>(tracks.size()),
+                                     rate, formatDuration(eta));
+        }
+    }
+    checkpoint.flush();
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - started);
+    const auto count = done.load();
+    std::cout << fmt::format("{} {} track(s) in {}, {} with nothing found; {}/{} done\n",
+                             stopping.load() ? "Stopped after" : "Finished", count,
+                             formatDuration(elapsed), empty.load(), first + count, tracks.size());
+    for (const auto &health : enricher.health()) {
+        std::cout << fmt::format("  {}: {}ms, {:.0f}% hits over {} call(s)\n", health.name,
+                                 health.latency.count(), health.successRatio * 100,
+                                 health.calls);
+    }
+    for (const auto &waits : RateLimiter::snapshot()) {
+        if (waits.bulk.granted + waits.bulk.refused == 0)
+            continue;
+        std::cout << fmt::format("  {}: waited {}ms on average, {}ms at most, for its rate limit\n",
+                                 waits.host, waits.bulk.meanWait().count() / 1000,
+                                 waits.bulk.longestWait.count() / 1000);
+    }
+    for (const auto &traffic : HttpClient::instance().traffic()) {
+        std::cout << fmt::format("  {}: {} call(s), {} on a reused connection, {} KiB received\n",
+                                 traffic.host, traffic.calls, traffic.reused,
+                                 traffic.bytesReceived / 1024);
+    }
+    log->info("Backfill {} after {} track(s) in {}s", stopping.load() ? "stopped" : "finished",
+              count, elapsed.count());
+    return 0;
+}